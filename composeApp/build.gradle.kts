@@ -277,6 +277,37 @@ tasks.withType<Test>().configureEach {
     }
 }
 
+// Generates the delta between two GeoIP databases, to publish with a release of
+// ooni/historical-geoip. The tool lives in desktopTest so it isn't shipped in the app.
+// ./gradlew :composeApp:generateMmdbDelta --args="<from.mmdb> <to.mmdb> <output.delta>"
+tasks.register<JavaExec>("generateMmdbDelta") {
+    group = "tools"
+    description = "Generates a binary delta between two GeoIP databases"
+    val compilation = kotlin.jvm("desktop").compilations.getByName("test")
+    classpath = compilation.output.allOutputs + (compilation.runtimeDependencyFiles ?: files())
+    mainClass.set("org.ooni.probe.tools.GenerateMmdbDeltaKt")
+}
+
+// Times DesktopNetworkTypeFinder against the bridge built by desktopApp/src/main/Makefile
+// ./gradlew :composeApp:benchmarkNetworkTypeFinder --args="[iterations]"
+tasks.register<JavaExec>("benchmarkNetworkTypeFinder") {
+    group = "tools"
+    description = "Measures the cost of reading the network type through the desktop bridge"
+    val compilation = kotlin.jvm("desktop").compilations.getByName("test")
+    classpath = compilation.output.allOutputs + (compilation.runtimeDependencyFiles ?: files())
+    mainClass.set("org.ooni.probe.tools.BenchmarkNetworkTypeFinderKt")
+    val osName = System.getProperty("os.name").lowercase()
+    val nativeDir = when {
+        osName.startsWith("mac") -> "macos"
+        osName.startsWith("windows") -> "windows"
+        else -> "linux"
+    }
+    systemProperty(
+        "compose.application.resources.dir",
+        rootProject.file("desktopApp/src/main/resources/$nativeDir").absolutePath,
+    )
+}
+
 // The KMP library Android variant only reads src/androidMain/res by default.
 // The launcher icons / notification_icon land in src/commonMain/res (copied
 // there from src/<org>/res by copyBrandingToCommonResources), so add that
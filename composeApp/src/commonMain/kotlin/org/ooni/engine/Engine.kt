@@ -2,19 +2,18 @@ package org.ooni.engine
 
 import androidx.annotation.VisibleForTesting
 import co.touchlab.kermit.Logger
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.channels.ProducerScope
 import kotlinx.coroutines.flow.Flow
 import kotlinx.coroutines.flow.channelFlow
 import kotlinx.coroutines.flow.flowOn
-import kotlinx.coroutines.flow.onCompletion
 import kotlinx.coroutines.isActive
-import kotlinx.coroutines.newSingleThreadContext
 import kotlinx.serialization.json.Json
-import okio.use
 import org.ooni.engine.OonimkallBridge.SubmitMeasurementResults
 import org.ooni.engine.models.EnginePreferences
+import org.ooni.engine.models.NetworkSnapshot
 import org.ooni.engine.models.Result
 import org.ooni.engine.models.TaskEvent
-import org.ooni.engine.models.TaskEventResult
 import org.ooni.engine.models.TaskOrigin
 import org.ooni.engine.models.TaskSettings
 import org.ooni.engine.models.resultOf
@@ -42,48 +41,62 @@ class Engine(
     private val getEnginePreferences: suspend () -> EnginePreferences,
     private val addRunCancelListener: (() -> Unit) -> CancelListenerCallback,
     private val backgroundContext: CoroutineContext,
+    private val taskDispatcher: EngineTaskDispatcher,
 ) {
+    private val taskEventDecoder = TaskEventDecoder(json)
+
+    // Goes through the bridge property, as UI tests swap the bridge before using the engine
+    private val sessionPool = EngineSessionPool(
+        newSession = { bridge.newSession(it) },
+        scope = CoroutineScope(backgroundContext),
+    )
+
     fun startTask(
         netTest: NetTest,
         taskOrigin: TaskOrigin,
         descriptorId: Descriptor.Id,
-    ): Flow<TaskEvent> {
-        val context = newSingleThreadContext("engine-start-task")
-        return channelFlow {
-            val preferences = getEnginePreferences()
-            val taskSettings =
-                buildTaskSettings(netTest, taskOrigin, preferences, descriptorId)
-            val settingsSerialized = json.encodeToString(taskSettings)
-
-            var task: OonimkallBridge.Task? = null
-            var cancelListener: CancelListenerCallback? = null
-            var isCancelled = false
-            try {
-                task = bridge.startTask(settingsSerialized)
-
-                cancelListener = addRunCancelListener {
-                    if (!isCancelled) {
-                        isCancelled = true
-                        task.interrupt()
-                    }
-                }
+    ): Flow<TaskEvent> =
+        channelFlow {
+            taskDispatcher.withSlot { runTask(netTest, taskOrigin, descriptorId) }
+        }.flowOn(taskDispatcher.context)
 
-                while (!task.isDone() && isActive) {
-                    val eventJson = task.waitForNextEvent()
-                    val taskEventResult = json.decodeFromString<TaskEventResult>(eventJson)
-                    taskEventMapper(taskEventResult, isCancelled)?.let { send(it) }
-                }
-            } catch (e: Exception) {
-                Logger.d("Error while running task", e)
-                throw MkException(e)
-            } finally {
-                if (task?.isDone() == false) {
+    private suspend fun ProducerScope<TaskEvent>.runTask(
+        netTest: NetTest,
+        taskOrigin: TaskOrigin,
+        descriptorId: Descriptor.Id,
+    ) {
+        val preferences = getEnginePreferences()
+        val taskSettings =
+            buildTaskSettings(netTest, taskOrigin, preferences, descriptorId)
+        val settingsSerialized = json.encodeToString(taskSettings)
+
+        var task: OonimkallBridge.Task? = null
+        var cancelListener: CancelListenerCallback? = null
+        var isCancelled = false
+        try {
+            task = bridge.startTask(settingsSerialized)
+
+            cancelListener = addRunCancelListener {
+                if (!isCancelled) {
+                    isCancelled = true
                     task.interrupt()
                 }
-                cancelListener?.dismiss()
             }
-        }.flowOn(context)
-            .onCompletion { context.close() }
+
+            while (!task.isDone() && isActive) {
+                val eventJson = task.waitForNextEvent()
+                val taskEventResult = taskEventDecoder(eventJson)
+                taskEventMapper(taskEventResult, isCancelled)?.let { send(it) }
+            }
+        } catch (e: Exception) {
+            Logger.d("Error while running task", e)
+            throw MkException(e)
+        } finally {
+            if (task?.isDone() == false) {
+                task.interrupt()
+            }
+            cancelListener?.dismiss()
+        }
     }
 
     suspend fun submitMeasurement(
@@ -92,7 +105,7 @@ class Engine(
     ): Result<SubmitMeasurementResults, MkException> =
         resultOf(backgroundContext) {
             val sessionConfig = buildSessionConfig(taskOrigin, getEnginePreferences())
-            val results = session(sessionConfig).use {
+            val results = sessionPool.use(sessionConfig) {
                 it.submitMeasurement(measurement)
             }
             if (results.measurementUid == null) {
@@ -113,7 +126,7 @@ class Engine(
                 enginePreferences = enginePreferences.copy(proxy = proxy.value)
             }
             val sessionConfig = buildSessionConfig(taskOrigin, enginePreferences)
-            session(sessionConfig).use {
+            sessionPool.use(sessionConfig) {
                 val request = OonimkallBridge.HTTPRequest(method = method, url = url)
                 it.httpDo(request).body
             }
@@ -121,13 +134,17 @@ class Engine(
             MkException(it)
         }
 
-    private fun session(sessionConfig: OonimkallBridge.SessionConfig): OonimkallBridge.Session = bridge.newSession(sessionConfig)
+    /** Closes the engine sessions kept warm for submissions and HTTP requests */
+    suspend fun shutdown() {
+        sessionPool.closeAll()
+    }
 
     private fun buildTaskSettings(
         netTest: NetTest,
         taskOrigin: TaskOrigin,
         preferences: EnginePreferences,
         descriptorId: Descriptor.Id,
+        network: NetworkSnapshot = networkTypeFinder.snapshot(),
     ) = TaskSettings(
         name = netTest.test.name,
         inputs = netTest.inputs.orEmpty(),
@@ -149,7 +166,11 @@ class Engine(
             maxRuntime = maxRuntime(taskOrigin, descriptorId, preferences),
         ),
         annotations = TaskSettings.Annotations(
-            networkType = networkTypeFinder(),
+            networkType = network.networkType,
+            networkVpnKind = network.vpnKind?.value,
+            networkMtu = network.mtu?.toString(),
+            networkIpv6DefaultRoute = network.hasIpv6DefaultRoute?.toString(),
+            networkMetered = network.isMetered?.toString(),
             flavor = platformInfo.buildSoftwareName(taskOrigin),
             origin = taskOrigin,
             osVersion = platformInfo.osVersion,
@@ -0,0 +1,136 @@
+package org.ooni.engine
+
+import co.touchlab.kermit.Logger
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Job
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.sync.Mutex
+import kotlinx.coroutines.sync.withLock
+import kotlin.time.Duration
+import kotlin.time.Duration.Companion.minutes
+import kotlin.time.TimeMark
+import kotlin.time.TimeSource
+
+/**
+ * Keeps engine sessions warm between requests, so consecutive submissions don't each pay for
+ * a new session bootstrap. Sessions are keyed on their whole [OonimkallBridge.SessionConfig]
+ * (proxy, software name, probe services URL...) and each one is lent to a single caller at a
+ * time, so concurrent callers get different sessions.
+ *
+ * A session is only returned to the pool if its request succeeded, a failure might mean the
+ * session itself is broken. Idle sessions are closed after [idleTimeout], by a job launched in
+ * [scope] while any session is idle, and all of them by [closeAll].
+ */
+class EngineSessionPool(
+    private val newSession: (OonimkallBridge.SessionConfig) -> OonimkallBridge.Session,
+    private val scope: CoroutineScope,
+    private val maxIdlePerConfig: Int = DEFAULT_MAX_IDLE_PER_CONFIG,
+    private val idleTimeout: Duration = DEFAULT_IDLE_TIMEOUT,
+    private val timeSource: TimeSource = TimeSource.Monotonic,
+) {
+    private class IdleSession(
+        val session: OonimkallBridge.Session,
+        val idleSince: TimeMark,
+    )
+
+    private val lock = Mutex()
+    private val idleSessions = mutableMapOf<OonimkallBridge.SessionConfig, ArrayDeque<IdleSession>>()
+    private var evictionJob: Job? = null
+
+    suspend fun <T> use(
+        config: OonimkallBridge.SessionConfig,
+        block: (OonimkallBridge.Session) -> T,
+    ): T {
+        val session = borrow(config)
+        val result = try {
+            block(session)
+        } catch (e: Throwable) {
+            closeQuietly(session)
+            throw e
+        }
+        giveBack(config, session)
+        return result
+    }
+
+    suspend fun closeAll() {
+        val sessions = lock.withLock {
+            evictionJob?.cancel()
+            evictionJob = null
+            idleSessions.values.flatten().also { idleSessions.clear() }
+        }
+        sessions.forEach { closeQuietly(it.session) }
+    }
+
+    private suspend fun borrow(config: OonimkallBridge.SessionConfig): OonimkallBridge.Session {
+        val expired = mutableListOf<IdleSession>()
+        val idle = lock.withLock {
+            removeExpired(expired)
+            idleSessions[config]?.removeLastOrNull()
+        }
+        expired.forEach { closeQuietly(it.session) }
+        return idle?.session ?: newSession(config)
+    }
+
+    private suspend fun giveBack(
+        config: OonimkallBridge.SessionConfig,
+        session: OonimkallBridge.Session,
+    ) {
+        val isPooled = lock.withLock {
+            val sessions = idleSessions.getOrPut(config) { ArrayDeque() }
+            if (sessions.size < maxIdlePerConfig) {
+                sessions.addLast(IdleSession(session, timeSource.markNow()))
+                scheduleEviction()
+                true
+            } else {
+                false
+            }
+        }
+        if (!isPooled) closeQuietly(session)
+    }
+
+    // Must be called with the lock held
+    private fun scheduleEviction() {
+        if (evictionJob?.isActive == true) return
+        evictionJob = scope.launch {
+            while (true) {
+                val expired = mutableListOf<IdleSession>()
+                val nextExpiry = lock.withLock {
+                    removeExpired(expired)
+                    // Oldest sessions are at the front
+                    val nextExpiry = idleSessions.values.minOfOrNull { idleTimeout - it.first().idleSince.elapsedNow() }
+                    if (nextExpiry == null) evictionJob = null
+                    nextExpiry
+                }
+                expired.forEach { closeQuietly(it.session) }
+                delay(nextExpiry ?: return@launch)
+            }
+        }
+    }
+
+    // Must be called with the lock held
+    private fun removeExpired(expired: MutableList<IdleSession>) {
+        val iterator = idleSessions.values.iterator()
+        while (iterator.hasNext()) {
+            val sessions = iterator.next()
+            // Oldest sessions are at the front
+            while (sessions.firstOrNull()?.let { it.idleSince.elapsedNow() >= idleTimeout } == true) {
+                expired.add(sessions.removeFirst())
+            }
+            if (sessions.isEmpty()) iterator.remove()
+        }
+    }
+
+    private fun closeQuietly(session: OonimkallBridge.Session) {
+        try {
+            session.close()
+        } catch (e: Exception) {
+            Logger.d("Could not close engine session", e)
+        }
+    }
+
+    companion object {
+        private const val DEFAULT_MAX_IDLE_PER_CONFIG = 4
+        private val DEFAULT_IDLE_TIMEOUT = 5.minutes
+    }
+}
@@ -0,0 +1,77 @@
+package org.ooni.engine
+
+import kotlinx.coroutines.CoroutineDispatcher
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.IO
+import kotlinx.coroutines.flow.MutableStateFlow
+import kotlinx.coroutines.flow.StateFlow
+import kotlinx.coroutines.flow.asStateFlow
+import kotlinx.coroutines.flow.update
+import kotlinx.coroutines.sync.Semaphore
+import kotlin.coroutines.CoroutineContext
+import kotlin.time.Duration
+import kotlin.time.TimeSource
+
+/**
+ * Bounded pool for the engine tasks, which block a thread on every `waitForNextEvent()`.
+ * Tasks borrow threads from [Dispatchers.IO] instead of creating one each, and at most
+ * [parallelism] of them run at once, the rest wait for a slot in [withSlot].
+ */
+class EngineTaskDispatcher(
+    parallelism: Int = DEFAULT_PARALLELISM,
+    dispatcher: CoroutineDispatcher = Dispatchers.IO,
+) {
+    val context: CoroutineContext = dispatcher.limitedParallelism(parallelism, "engine-task")
+
+    private val slots = Semaphore(parallelism)
+
+    private val _metrics = MutableStateFlow(Metrics())
+    val metrics: StateFlow<Metrics> = _metrics.asStateFlow()
+
+    suspend fun <T> withSlot(block: suspend () -> T): T {
+        val queuedAt = TimeSource.Monotonic.markNow()
+        _metrics.update { it.copy(queued = it.queued + 1) }
+        try {
+            slots.acquire()
+        } catch (e: Throwable) {
+            _metrics.update { it.copy(queued = it.queued - 1) }
+            throw e
+        }
+        val queueTime = queuedAt.elapsedNow()
+        _metrics.update {
+            it.copy(
+                queued = it.queued - 1,
+                active = it.active + 1,
+                started = it.started + 1,
+                totalQueueTime = it.totalQueueTime + queueTime,
+                maxQueueTime = maxOf(it.maxQueueTime, queueTime),
+            )
+        }
+        try {
+            return block()
+        } finally {
+            slots.release()
+            _metrics.update { it.copy(active = it.active - 1) }
+        }
+    }
+
+    data class Metrics(
+        // Tasks waiting for a free slot
+        val queued: Int = 0,
+        // Tasks currently holding a slot
+        val active: Int = 0,
+        // Tasks that got a slot since the app started
+        val started: Long = 0,
+        val totalQueueTime: Duration = Duration.ZERO,
+        val maxQueueTime: Duration = Duration.ZERO,
+    ) {
+        val averageQueueTime: Duration
+            get() = if (started == 0L) Duration.ZERO else totalQueueTime / started.toDouble()
+    }
+
+    companion object {
+        // Tests of a run are executed one after the other, so a few slots are enough
+        // to absorb overlapping runs without growing the thread count
+        private const val DEFAULT_PARALLELISM = 4
+    }
+}
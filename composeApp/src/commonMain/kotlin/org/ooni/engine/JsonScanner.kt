@@ -0,0 +1,178 @@
+package org.ooni.engine
+
+/**
+ * Minimal forward-only JSON reader over a string, for the few fields we need out of large
+ * documents. Values we don't need are skipped, or returned as raw JSON text, without building
+ * anything. Throws [MalformedJson] on anything it doesn't understand.
+ */
+internal class JsonScanner(
+    private val text: String,
+) {
+    class MalformedJson : Exception()
+
+    private var position = 0
+    private var isFirstField = true
+
+    fun beginObject() {
+        skipWhitespace()
+        expect('{')
+        isFirstField = true
+    }
+
+    fun isNextObject(): Boolean {
+        skipWhitespace()
+        return peek() == '{'
+    }
+
+    // Name of the next field of the current object, or null once the object ends
+    fun nextField(): String? {
+        skipWhitespace()
+        if (peek() == '}') {
+            position++
+            isFirstField = false
+            return null
+        }
+        if (!isFirstField) {
+            expect(',')
+            skipWhitespace()
+        }
+        isFirstField = false
+        val name = readString()
+        skipWhitespace()
+        expect(':')
+        return name
+    }
+
+    fun readString(): String {
+        skipWhitespace()
+        expect('"')
+        val start = position
+        val end = text.indexOf('"', start)
+        if (end < 0) throw MalformedJson()
+        // Fast path, nothing to unescape
+        val firstEscape = text.indexOf('\\', start)
+        if (firstEscape < 0 || firstEscape > end) {
+            position = end + 1
+            return text.substring(start, end)
+        }
+
+        val builder = StringBuilder(end - start)
+        var runStart = start
+        while (true) {
+            if (position >= text.length) throw MalformedJson()
+            when (text[position]) {
+                '"' -> {
+                    builder.appendRange(text, runStart, position)
+                    position++
+                    return builder.toString()
+                }
+
+                '\\' -> {
+                    builder.appendRange(text, runStart, position)
+                    builder.append(readEscape())
+                    runStart = position
+                }
+
+                else -> position++
+            }
+        }
+    }
+
+    fun readInt(): Int {
+        skipWhitespace()
+        val start = position
+        while (position < text.length && text[position] in NUMBER_CHARS) position++
+        return text.substring(start, position).toDoubleOrNull()?.toInt() ?: throw MalformedJson()
+    }
+
+    fun skipValue() {
+        skipWhitespace()
+        when (peek()) {
+            '"' -> skipString()
+            '{', '[' -> skipContainer()
+            else -> while (position < text.length && text[position] !in VALUE_END) position++
+        }
+    }
+
+    // The next value as it appears in the text, escapes and all
+    fun readRawValue(): String {
+        skipWhitespace()
+        val start = position
+        skipValue()
+        if (position == start) throw MalformedJson()
+        return text.substring(start, position)
+    }
+
+    private fun skipString() {
+        expect('"')
+        while (true) {
+            if (position >= text.length) throw MalformedJson()
+            when (text[position]) {
+                '"' -> {
+                    position++
+                    return
+                }
+
+                '\\' -> position += 2
+                else -> position++
+            }
+        }
+    }
+
+    private fun skipContainer() {
+        var depth = 0
+        do {
+            if (position >= text.length) throw MalformedJson()
+            when (text[position]) {
+                '"' -> {
+                    skipString()
+                    continue
+                }
+
+                '{', '[' -> depth++
+                '}', ']' -> depth--
+            }
+            position++
+        } while (depth > 0)
+    }
+
+    private fun readEscape(): Char {
+        position++ // backslash
+        if (position >= text.length) throw MalformedJson()
+        val char = text[position++]
+        return when (char) {
+            '"', '\\', '/' -> char
+            'b' -> '\b'
+            'f' -> '\u000C'
+            'n' -> '\n'
+            'r' -> '\r'
+            't' -> '\t'
+            'u' -> {
+                if (position + 4 > text.length) throw MalformedJson()
+                val code = text.substring(position, position + 4).toIntOrNull(16)
+                    ?: throw MalformedJson()
+                position += 4
+                // Surrogate pairs come as two escapes and are joined back by the builder
+                code.toChar()
+            }
+
+            else -> throw MalformedJson()
+        }
+    }
+
+    private fun skipWhitespace() {
+        while (position < text.length && text[position].isWhitespace()) position++
+    }
+
+    private fun peek(): Char = if (position < text.length) text[position] else throw MalformedJson()
+
+    private fun expect(char: Char) {
+        if (peek() != char) throw MalformedJson()
+        position++
+    }
+
+    private companion object {
+        const val NUMBER_CHARS = "-+.eE0123456789"
+        const val VALUE_END = ",}] \t\r\n"
+    }
+}
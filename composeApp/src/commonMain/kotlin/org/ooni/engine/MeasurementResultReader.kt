@@ -0,0 +1,80 @@
+package org.ooni.engine
+
+import kotlinx.serialization.descriptors.elementNames
+import kotlinx.serialization.json.Json
+import org.ooni.engine.models.MeasurementResult
+import org.ooni.engine.models.TestKeys
+
+/**
+ * Reads the [MeasurementResult] out of a measurement's JSON.
+ *
+ * The app keeps a handful of top level fields and test keys, while most of a measurement is
+ * network traces inside `test_keys` (requests, queries, TCP connects...). Those are skipped by
+ * [JsonScanner] without being tokenized into strings or objects, and only the raw text of the
+ * fields [MeasurementResult] and [TestKeys] declare is handed to [Json], so their serializers
+ * stay the single definition of what we read.
+ */
+class MeasurementResultReader(
+    private val json: Json,
+) {
+    operator fun invoke(measurementJson: String): MeasurementResult {
+        val picked = try {
+            pickFields(measurementJson)
+        } catch (e: JsonScanner.MalformedJson) {
+            throw IllegalArgumentException("Malformed measurement JSON", e)
+        }
+        return json.decodeFromString(picked)
+    }
+
+    private fun pickFields(measurementJson: String): String {
+        val scanner = JsonScanner(measurementJson)
+        val picked = StringBuilder()
+        picked.append('{')
+        scanner.beginObject()
+        while (true) {
+            val name = scanner.nextField() ?: break
+            when {
+                name == TEST_KEYS && scanner.isNextObject() -> {
+                    picked.appendField(name)
+                    pickTestKeys(scanner, picked)
+                }
+
+                name in resultFields -> picked.appendField(name).append(scanner.readRawValue())
+
+                else -> scanner.skipValue()
+            }
+        }
+        return picked.append('}').toString()
+    }
+
+    private fun pickTestKeys(
+        scanner: JsonScanner,
+        picked: StringBuilder,
+    ) {
+        val start = picked.length
+        picked.append('{')
+        scanner.beginObject()
+        while (true) {
+            val name = scanner.nextField() ?: break
+            if (name in testKeysFields) {
+                if (picked.length > start + 1) picked.append(',')
+                picked.append('"').append(name).append("\":").append(scanner.readRawValue())
+            } else {
+                scanner.skipValue()
+            }
+        }
+        picked.append('}')
+    }
+
+    // Field names come from our own serializers, nothing to escape
+    private fun StringBuilder.appendField(name: String): StringBuilder {
+        if (length > 1) append(',')
+        return append('"').append(name).append("\":")
+    }
+
+    companion object {
+        private const val TEST_KEYS = "test_keys"
+        private val resultFields = MeasurementResult.serializer().descriptor.elementNames.toSet()
+        private val testKeysFields = TestKeys.serializer().descriptor.elementNames.toSet()
+    }
+}
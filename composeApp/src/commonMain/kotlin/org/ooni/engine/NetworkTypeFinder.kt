@@ -1,7 +1,20 @@
 package org.ooni.engine
 
+import kotlinx.coroutines.flow.Flow
+import org.ooni.engine.models.NetworkSnapshot
 import org.ooni.engine.models.NetworkType
 
 fun interface NetworkTypeFinder {
     operator fun invoke(): NetworkType
+
+    /**
+     * Emits the current network type, then every change pushed by the platform.
+     * Returns null when the platform can't push changes, in which case callers need to poll.
+     */
+    fun observe(): Flow<NetworkType>? = null
+
+    /**
+     * The network type along with the interface details the platform knows about.
+     */
+    fun snapshot(): NetworkSnapshot = NetworkSnapshot(networkType = invoke())
 }
@@ -0,0 +1,70 @@
+package org.ooni.engine
+
+import kotlinx.serialization.json.Json
+import org.ooni.engine.models.TaskEventResult
+
+/**
+ * Decodes the events returned by `Task.waitForNextEvent()`.
+ *
+ * Measurement events carry the whole measurement, often hundreds of KB, as an escaped string in
+ * `json_str`. For those we only read `key`, `idx` and `json_str` in a single pass, skipping any
+ * other field, and the measurement is unescaped once into the string that ends up in the report
+ * file. The few fields the app keeps from it are then picked by [MeasurementResultReader].
+ * Every other event is small and goes through the regular [Json] decoding, which is also the
+ * fallback if a measurement event doesn't have the expected shape.
+ */
+class TaskEventDecoder(
+    private val json: Json,
+) {
+    operator fun invoke(eventJson: String): TaskEventResult =
+        try {
+            decodeMeasurement(eventJson)
+        } catch (e: JsonScanner.MalformedJson) {
+            null
+        } ?: json.decodeFromString(eventJson)
+
+    // Returns null if it's not a measurement event
+    private fun decodeMeasurement(eventJson: String): TaskEventResult? {
+        val scanner = JsonScanner(eventJson)
+        var key: String? = null
+        var value: TaskEventResult.Value? = null
+
+        scanner.beginObject()
+        while (true) {
+            when (scanner.nextField() ?: break) {
+                "key" -> {
+                    key = scanner.readString()
+                    if (key != MEASUREMENT_KEY) return null
+                }
+
+                // We only know how to read the value once we know it's a measurement
+                "value" -> value = if (key == MEASUREMENT_KEY) readValue(scanner) else return null
+
+                else -> scanner.skipValue()
+            }
+        }
+        return if (key == MEASUREMENT_KEY && value != null) {
+            TaskEventResult(key = key, value = value)
+        } else {
+            null
+        }
+    }
+
+    private fun readValue(scanner: JsonScanner): TaskEventResult.Value {
+        var idx = 0
+        var jsonStr: String? = null
+        scanner.beginObject()
+        while (true) {
+            when (scanner.nextField() ?: break) {
+                "idx" -> idx = scanner.readInt()
+                "json_str" -> jsonStr = scanner.readString()
+                else -> scanner.skipValue()
+            }
+        }
+        return TaskEventResult.Value(idx = idx, jsonStr = jsonStr)
+    }
+
+    companion object {
+        private const val MEASUREMENT_KEY = "measurement"
+    }
+}
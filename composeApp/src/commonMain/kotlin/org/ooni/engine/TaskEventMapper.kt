@@ -9,6 +9,8 @@ class TaskEventMapper(
     private val networkTypeFinder: NetworkTypeFinder,
     private val json: Json,
 ) {
+    private val readMeasurementResult = MeasurementResultReader(json)
+
     class EngineMeasurementJsonInvalid(
         message: String,
     ) : Exception(message)
@@ -77,7 +79,7 @@ class TaskEventMapper(
                         json = jsonString,
                         result =
                             try {
-                                json.decodeFromString(jsonString)
+                                readMeasurementResult(jsonString)
                             } catch (e: Exception) {
                                 Logger.w(
                                     "Engine emitted invalid measurement JSON " +
@@ -0,0 +1,27 @@
+package org.ooni.engine.models
+
+/**
+ * Details of the network in use, as far as the platform can tell.
+ * Fields are null when the platform doesn't know them.
+ */
+data class NetworkSnapshot(
+    val networkType: NetworkType,
+    // Interface carrying the traffic, the tunnel one when a VPN is connected
+    val interfaceName: String? = null,
+    val mtu: Int? = null,
+    val hasIpv6DefaultRoute: Boolean? = null,
+    val isMetered: Boolean? = null,
+    val vpnKind: VpnKind? = null,
+    // Increases every time any of the other fields changes
+    val generation: Long = 0,
+) {
+    enum class VpnKind(
+        val value: String,
+    ) {
+        WireGuard("wireguard"),
+        Tun("tun"),
+        Ppp("ppp"),
+        Ipsec("ipsec"),
+        Other("other"),
+    }
+}
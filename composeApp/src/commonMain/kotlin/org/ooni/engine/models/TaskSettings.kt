@@ -34,6 +34,11 @@ data class TaskSettings(
     @Serializable
     data class Annotations(
         @SerialName("network_type") val networkType: NetworkType,
+        // Annotation values are strings for the engine, so these are kept as such
+        @SerialName("network_vpn_kind") val networkVpnKind: String? = null,
+        @SerialName("network_mtu") val networkMtu: String? = null,
+        @SerialName("network_ipv6_default_route") val networkIpv6DefaultRoute: String? = null,
+        @SerialName("network_metered") val networkMetered: String? = null,
         // OONI or DW
         @SerialName("flavor") val flavor: String,
         // "autorun" or "ooni-run"
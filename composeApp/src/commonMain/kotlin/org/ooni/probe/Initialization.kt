@@ -4,7 +4,9 @@ import co.touchlab.kermit.Logger
 import co.touchlab.kermit.Severity
 import kotlinx.coroutines.CoroutineScope
 import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.flow.first
 import kotlinx.coroutines.launch
+import org.ooni.probe.data.models.SettingsKey
 import org.ooni.probe.di.Dependencies
 import org.ooni.probe.shared.PlatformInfo
 
@@ -37,9 +39,19 @@ fun initialization(
     coroutineScope.launch {
         dependencies.finishInProgressData()
         dependencies.deleteOldResults()
+        checkResultCountersOnce(dependencies)
+        dependencies.measurementRepository.fillMissingTestKeysSummaries()
     }
 }
 
+// The counters are kept by triggers, so checking them once after the migration is enough
+private suspend fun checkResultCountersOnce(dependencies: Dependencies) {
+    val preferences = dependencies.preferenceRepository
+    if (preferences.getValueByKey(SettingsKey.RESULT_COUNTERS_CHECKED).first() == true) return
+    dependencies.resultRepository.checkCounters()
+    preferences.setValueByKey(SettingsKey.RESULT_COUNTERS_CHECKED, true)
+}
+
 private fun logAppStart(platformInfo: PlatformInfo) {
     with(platformInfo) {
         Logger.v(
@@ -16,13 +16,17 @@ class DeleteFilesOkio(
     private val fileSystem: FileSystem,
     private val baseFilesDir: String,
     private val backgroundContext: CoroutineContext,
+    private val storageLedger: StorageUsageLedger? = null,
 ) : DeleteFiles {
     override suspend fun invoke(path: Path) {
-        withContext(backgroundContext) {
-            try {
-                fileSystem.deleteRecursively(baseFilesDir.toPath().resolve(path))
-            } catch (e: IOException) {
-                Logger.v("Could not delete files at $path", e)
+        val absolutePath = baseFilesDir.toPath().resolve(path)
+        storageLedger.trackDeleteIfPresent(absolutePath) {
+            withContext(backgroundContext) {
+                try {
+                    fileSystem.deleteRecursively(absolutePath)
+                } catch (e: IOException) {
+                    Logger.v("Could not delete files at $path", e)
+                }
             }
         }
     }
@@ -0,0 +1,193 @@
+package org.ooni.probe.data.disk
+
+import co.touchlab.kermit.Logger
+import kotlinx.coroutines.sync.Mutex
+import kotlinx.coroutines.sync.withLock
+import kotlinx.coroutines.withContext
+import okio.Buffer
+import okio.Deflater
+import okio.DeflaterSink
+import okio.FileSystem
+import okio.IOException
+import okio.Inflater
+import okio.InflaterSource
+import okio.Path
+import okio.Path.Companion.toPath
+import okio.buffer
+import okio.use
+import org.ooni.probe.data.models.MeasurementModel
+import kotlin.coroutines.CoroutineContext
+import kotlin.time.Clock
+import kotlin.time.Duration
+import kotlin.time.Duration.Companion.hours
+
+/**
+ * Raw JSON reports of the measurements, appended deflate-compressed to a few large segment
+ * files instead of one file per measurement. Each report is compressed on its own, so it can be
+ * read back from its [MeasurementModel.ReportLocation] without touching the rest of the segment.
+ *
+ * Entries are never rewritten: once a report is uploaded or its measurement deleted, the
+ * measurement drops its location, and [compact] deletes the segments nothing points to anymore.
+ * Measurements from older versions still have their report in its own file at
+ * [MeasurementModel.reportFilePath], which keeps being read and deleted as before.
+ */
+class MeasurementReportStore(
+    private val fileSystem: FileSystem,
+    baseFileDir: String,
+    private val backgroundContext: CoroutineContext,
+    private val storageLedger: StorageUsageLedger? = null,
+    private val maxSegmentBytes: Long = DEFAULT_MAX_SEGMENT_BYTES,
+    private val clock: Clock = Clock.System,
+) {
+    private val baseDir = baseFileDir.toPath()
+    private val segmentsDir = baseDir.resolve(SEGMENTS_PATH)
+    private val lock = Mutex()
+
+    // Segment receiving new reports, found on the first write
+    private var activeSegment: Long? = null
+
+    /** Appends [report] to the active segment, returns where it was stored, or null if it failed */
+    suspend fun write(report: String): MeasurementModel.ReportLocation? =
+        withContext(backgroundContext) {
+            val compressed = Buffer()
+            DeflaterSink(compressed, Deflater()).buffer().use { it.writeUtf8(report) }
+            val length = compressed.size
+
+            lock.withLock {
+                try {
+                    fileSystem.createDirectories(segmentsDir)
+                    var segment = activeSegment ?: (listSegments().maxOrNull() ?: 1L)
+                    // Read from disk instead of kept in memory, in case a write was cut short
+                    // or the folder was cleared
+                    var offset = fileSystem.metadataOrNull(segmentPath(segment))?.size ?: 0L
+                    if (offset > 0 && offset + length > maxSegmentBytes) {
+                        segment++
+                        offset = 0L
+                    }
+                    activeSegment = segment
+
+                    val path = segmentPath(segment)
+                    storageLedger.trackIfPresent(path) {
+                        fileSystem.appendingSink(path).buffer().use { it.writeAll(compressed) }
+                    }
+                    MeasurementModel.ReportLocation(segment, offset, length)
+                } catch (e: IOException) {
+                    Logger.e("Could not write measurement report", e)
+                    null
+                }
+            }
+        }
+
+    /** The report of [measurement], decompressed as it's read from its segment */
+    suspend fun read(measurement: MeasurementModel): String? =
+        withContext(backgroundContext) {
+            val location = measurement.reportLocation
+                ?: return@withContext measurement.reportFilePath?.let(::readLegacyFile)
+            try {
+                fileSystem.openReadOnly(segmentPath(location.segment)).use { handle ->
+                    InflaterSource(handle.source(location.offset), Inflater())
+                        .buffer()
+                        .use { it.readUtf8() }
+                }
+            } catch (e: IOException) {
+                Logger.w("Could not read measurement report", e)
+                null
+            }
+        }
+
+    /**
+     * A standalone file with the report of [measurement], relative to the base file directory,
+     * for sharing it.
+     */
+    suspend fun export(measurement: MeasurementModel): Path? {
+        val path = measurement.reportFilePath ?: return null
+        if (measurement.reportLocation == null) {
+            return path.takeIf { fileSystem.exists(baseDir.resolve(it)) }
+        }
+        val report = read(measurement) ?: return null
+        return withContext(backgroundContext) {
+            try {
+                val absolutePath = baseDir.resolve(path)
+                storageLedger.trackIfPresent(absolutePath) {
+                    fileSystem.write(absolutePath) { writeUtf8(report) }
+                }
+                path
+            } catch (e: IOException) {
+                Logger.w("Could not export measurement report", e)
+                null
+            }
+        }
+    }
+
+    /**
+     * Deletes the files holding only the report of [measurement]. Its entry in a segment is
+     * freed once the measurement no longer points to it.
+     */
+    suspend fun delete(measurement: MeasurementModel) {
+        val path = measurement.reportFilePath ?: return
+        val absolutePath = baseDir.resolve(path)
+        withContext(backgroundContext) {
+            storageLedger.trackIfPresent(absolutePath) {
+                try {
+                    fileSystem.delete(absolutePath, mustExist = false)
+                } catch (e: IOException) {
+                    Logger.v("Could not delete measurement report $path", e)
+                }
+            }
+        }
+    }
+
+    /** Deletes every segment that isn't in [liveSegments], except the ones still being written */
+    suspend fun compact(liveSegments: Set<Long>) {
+        withContext(backgroundContext) {
+            lock.withLock {
+                val segments = listSegments()
+                val active = activeSegment ?: segments.maxOrNull()
+                val now = clock.now().toEpochMilliseconds()
+                segments
+                    .filter { it != active && it !in liveSegments }
+                    .forEach { segment ->
+                        val path = segmentPath(segment)
+                        // A recent segment may hold reports of a running test that aren't
+                        // saved to the database yet
+                        val modifiedAt = fileSystem.metadataOrNull(path)?.lastModifiedAtMillis
+                        if (modifiedAt != null && now - modifiedAt < RECENTLY_WRITTEN.inWholeMilliseconds) {
+                            return@forEach
+                        }
+                        storageLedger.trackIfPresent(path) {
+                            try {
+                                fileSystem.delete(path, mustExist = false)
+                            } catch (e: IOException) {
+                                Logger.v("Could not delete report segment $segment", e)
+                            }
+                        }
+                    }
+            }
+        }
+    }
+
+    private fun readLegacyFile(path: Path): String? =
+        try {
+            fileSystem.read(baseDir.resolve(path)) { readUtf8() }
+        } catch (e: IOException) {
+            Logger.v("Could not read $path", e)
+            null
+        }
+
+    private fun listSegments(): List<Long> =
+        fileSystem
+            .listOrNull(segmentsDir)
+            .orEmpty()
+            .filter { it.name.endsWith(SEGMENT_EXTENSION) }
+            .mapNotNull { it.name.removeSuffix(SEGMENT_EXTENSION).toLongOrNull() }
+
+    private fun segmentPath(segment: Long) = segmentsDir.resolve("$segment$SEGMENT_EXTENSION")
+
+    companion object {
+        // Inside the Measurement folder, so deleting all results also deletes the segments
+        val SEGMENTS_PATH = "Measurement/Reports".toPath()
+        private const val SEGMENT_EXTENSION = ".seg"
+        private const val DEFAULT_MAX_SEGMENT_BYTES = 4L * 1024 * 1024
+        private val RECENTLY_WRITTEN: Duration = 1.hours
+    }
+}
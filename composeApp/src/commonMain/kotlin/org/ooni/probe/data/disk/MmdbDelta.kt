@@ -0,0 +1,153 @@
+package org.ooni.probe.data.disk
+
+import okio.BufferedSink
+import okio.BufferedSource
+import okio.ByteString
+import okio.ByteString.Companion.encodeUtf8
+import okio.FileHandle
+import okio.FileSystem
+import okio.HashingSink
+import okio.IOException
+import okio.Inflater
+import okio.InflaterSource
+import okio.Path
+import okio.Path.Companion.toPath
+import okio.blackholeSink
+import okio.buffer
+import okio.use
+
+/**
+ * Binary delta between two versions of the GeoIP database, so an update only downloads what
+ * changed since the installed version instead of the whole file.
+ *
+ * Layout: [MAGIC] and a version byte, the SHA-256 of the source database, the size and SHA-256
+ * of the target database, then a deflate-compressed list of operations. Each operation is
+ * [OP_COPY] with a source offset (8 bytes) and a length (4 bytes), or [OP_INSERT] with a length
+ * (4 bytes) and as many literal bytes. The list ends with [OP_END].
+ */
+object MmdbDelta {
+    val MAGIC = "OOMD".encodeUtf8()
+    const val VERSION = 1
+    const val OP_END = 0
+    const val OP_COPY = 1
+    const val OP_INSERT = 2
+
+    private const val PATCHING_SUFFIX = ".patching"
+    private const val CHUNK_SIZE = 64 * 1024
+    private const val SHA256_SIZE = 32L
+
+    class Header(
+        val sourceSha256: ByteString,
+        val targetSize: Long,
+        val targetSha256: ByteString,
+    )
+
+    fun writeHeader(
+        sink: BufferedSink,
+        header: Header,
+    ) {
+        sink.write(MAGIC)
+        sink.writeByte(VERSION)
+        sink.write(header.sourceSha256)
+        sink.writeLong(header.targetSize)
+        sink.write(header.targetSha256)
+    }
+
+    fun readHeader(source: BufferedSource): Header {
+        if (source.readByteString(MAGIC.size.toLong()) != MAGIC) throw IOException("Not a GeoIP delta")
+        val version = source.readByte().toInt()
+        if (version != VERSION) throw IOException("Unknown GeoIP delta version $version")
+        return Header(
+            sourceSha256 = source.readByteString(SHA256_SIZE),
+            targetSize = source.readLong(),
+            targetSha256 = source.readByteString(SHA256_SIZE),
+        )
+    }
+
+    /**
+     * Rebuilds the target database from [source] and [delta] and moves it onto [target] once it
+     * matches the SHA-256 in the delta, and [expectedSha256] when given. [source] is read in
+     * place and the result streamed to disk, so neither is held in memory.
+     *
+     * @throws IOException if the delta doesn't apply to [source], is malformed, or the result
+     * isn't the expected database. [target] is left untouched in that case.
+     */
+    fun apply(
+        fileSystem: FileSystem,
+        source: Path,
+        delta: Path,
+        target: Path,
+        expectedSha256: String? = null,
+    ) {
+        val partialName = "${target.name}$PATCHING_SUFFIX"
+        val partial = target.parent?.resolve(partialName) ?: partialName.toPath()
+        try {
+            fileSystem.source(delta).buffer().use { input ->
+                val header = readHeader(input)
+                if (expectedSha256 != null && !header.targetSha256.hex().equals(expectedSha256, ignoreCase = true)) {
+                    throw IOException("GeoIP delta doesn't produce the expected database")
+                }
+                if (sha256(fileSystem, source) != header.sourceSha256) {
+                    throw IOException("GeoIP delta doesn't apply to $source")
+                }
+
+                val hashing = HashingSink.sha256(fileSystem.sink(partial))
+                fileSystem.openReadOnly(source).use { sourceHandle ->
+                    InflaterSource(input, Inflater()).buffer().use { operations ->
+                        hashing.buffer().use { output -> patch(operations, sourceHandle, output) }
+                    }
+                }
+
+                val size = fileSystem.metadata(partial).size
+                if (size != header.targetSize || hashing.hash != header.targetSha256) {
+                    throw IOException("Patched GeoIP database doesn't match the delta")
+                }
+            }
+            fileSystem.atomicMove(partial, target)
+        } finally {
+            fileSystem.delete(partial, mustExist = false)
+        }
+    }
+
+    private fun patch(
+        operations: BufferedSource,
+        source: FileHandle,
+        output: BufferedSink,
+    ) {
+        val chunk = ByteArray(CHUNK_SIZE)
+        while (true) {
+            when (val operation = operations.readByte().toInt()) {
+                OP_END -> return
+
+                OP_COPY -> {
+                    var offset = operations.readLong()
+                    var remaining = operations.readInt().toLong()
+                    while (remaining > 0) {
+                        val read = source.read(offset, chunk, 0, minOf(remaining, CHUNK_SIZE.toLong()).toInt())
+                        if (read == -1) throw IOException("GeoIP delta copies past the end of the source")
+                        output.write(chunk, 0, read)
+                        offset += read
+                        remaining -= read
+                    }
+                }
+
+                OP_INSERT -> {
+                    val length = operations.readInt()
+                    if (length < 0) throw IOException("Invalid GeoIP delta insert of $length bytes")
+                    output.write(operations, length.toLong())
+                }
+
+                else -> throw IOException("Unknown GeoIP delta operation $operation")
+            }
+        }
+    }
+
+    fun sha256(
+        fileSystem: FileSystem,
+        path: Path,
+    ): ByteString =
+        HashingSink.sha256(blackholeSink()).use { hashing ->
+            fileSystem.source(path).buffer().use { it.readAll(hashing) }
+            hashing.hash
+        }
+}
@@ -0,0 +1,131 @@
+package org.ooni.probe.data.disk
+
+import co.touchlab.kermit.Logger
+import okio.FileSystem
+import okio.IOException
+import okio.Path
+import okio.Path.Companion.toPath
+import okio.buffer
+import okio.use
+import okio.utf8Size
+
+/**
+ * Append-only log spread over a few files of bounded size: [activePath] receives the new lines,
+ * and once it reaches [maxSegmentBytes] it's rotated to `<name>.1.txt`, pushing older segments
+ * one number up and dropping the ones beyond [maxSegments]. Blocking, call from a background context.
+ * Writes and deletes are reported to the [storageLedger]. Rotating moves segments inside the same
+ * folder, so only the dropped segment changes its total.
+ */
+class SegmentedLogFile(
+    private val fileSystem: FileSystem,
+    baseFileDir: String,
+    // Relative to the base file directory, e.g. Log/logger.txt
+    val activePath: Path,
+    private val maxSegmentBytes: Long = DEFAULT_MAX_SEGMENT_BYTES,
+    private val maxSegments: Int = DEFAULT_MAX_SEGMENTS,
+    private val storageLedger: StorageUsageLedger? = null,
+) {
+    private val directory = baseFileDir.toPath().resolve(activePath).parent ?: baseFileDir.toPath()
+    private val baseName = activePath.name.substringBeforeLast(".")
+    private val absoluteActivePath = directory.resolve(activePath.name)
+
+    // Size of the active segment, read from disk on the first append
+    private var activeSize: Long? = null
+
+    /** Paths of the segments on disk, oldest first */
+    fun segments(): List<Path> =
+        ((maxSegments - 1) downTo 1)
+            .map(::segmentPath)
+            .plus(absoluteActivePath)
+            .filter(fileSystem::exists)
+
+    suspend fun append(lines: List<String>) {
+        if (lines.isEmpty()) return
+        val contents = lines.joinToString(separator = "\n", postfix = "\n")
+        try {
+            fileSystem.createDirectories(directory)
+            val previousSize = activeSize ?: (fileSystem.metadataOrNull(absoluteActivePath)?.size ?: 0L)
+            storageLedger.trackIfPresent(absoluteActivePath) {
+                fileSystem.appendingSink(absoluteActivePath).buffer().use { it.writeUtf8(contents) }
+            }
+            val size = previousSize + contents.utf8Size()
+            activeSize = size
+            if (size >= maxSegmentBytes) rotate()
+        } catch (e: IOException) {
+            Logger.e("Could not append to log $activePath", e)
+            activeSize = null
+        }
+    }
+
+    /** The last [maxLines] lines, oldest first, reading only the segments needed */
+    fun readLastLines(maxLines: Int): List<String> {
+        val chunks = ArrayDeque<List<String>>()
+        var count = 0
+        for (segment in segments().asReversed()) {
+            if (count >= maxLines) break
+            val lines = try {
+                fileSystem.read(segment) { readUtf8() }.lines().dropLastWhile { it.isEmpty() }
+            } catch (e: IOException) {
+                Logger.v("Could not read log segment $segment", e)
+                continue
+            }
+            chunks.addFirst(lines)
+            count += lines.size
+        }
+        return chunks.flatten().takeLast(maxLines)
+    }
+
+    /**
+     * A single file holding the whole log, for sharing. Returns [activePath] itself when it's
+     * the only segment, otherwise concatenates every segment into `<name>-export.txt`.
+     */
+    suspend fun export(): Path {
+        val segments = segments()
+        if (segments.size <= 1) {
+            if (segments.isEmpty()) {
+                fileSystem.createDirectories(directory)
+                fileSystem.write(absoluteActivePath) {}
+            }
+            return activePath
+        }
+        val exportName = "$baseName-export.txt"
+        val exportPath = directory.resolve(exportName)
+        storageLedger.trackIfPresent(exportPath) {
+            fileSystem.write(exportPath) {
+                segments.forEach { segment -> fileSystem.read(segment) { readAll(this@write) } }
+            }
+        }
+        return activePath.parent?.resolve(exportName) ?: exportName.toPath()
+    }
+
+    suspend fun clear() {
+        try {
+            (segments() + directory.resolve("$baseName-export.txt")).forEach { path ->
+                storageLedger.trackIfPresent(path) { fileSystem.delete(path, mustExist = false) }
+            }
+        } catch (e: IOException) {
+            Logger.v("Could not delete log $activePath", e)
+        }
+        activeSize = 0L
+    }
+
+    private suspend fun rotate() {
+        val dropped = if (maxSegments > 1) segmentPath(maxSegments - 1) else absoluteActivePath
+        storageLedger.trackIfPresent(dropped) { fileSystem.delete(dropped, mustExist = false) }
+        for (index in (maxSegments - 2) downTo 1) {
+            val segment = segmentPath(index)
+            if (fileSystem.exists(segment)) fileSystem.atomicMove(segment, segmentPath(index + 1))
+        }
+        if (maxSegments > 1) {
+            fileSystem.atomicMove(absoluteActivePath, segmentPath(1))
+        }
+        activeSize = 0L
+    }
+
+    private fun segmentPath(index: Int) = directory.resolve("$baseName.$index.txt")
+
+    companion object {
+        private const val DEFAULT_MAX_SEGMENT_BYTES = 512L * 1024
+        private const val DEFAULT_MAX_SEGMENTS = 4
+    }
+}
@@ -0,0 +1,259 @@
+package org.ooni.probe.data.disk
+
+import co.touchlab.kermit.Logger
+import kotlinx.coroutines.flow.MutableStateFlow
+import kotlinx.coroutines.flow.StateFlow
+import kotlinx.coroutines.flow.asStateFlow
+import kotlinx.coroutines.sync.Mutex
+import kotlinx.coroutines.sync.withLock
+import kotlinx.coroutines.withContext
+import kotlinx.coroutines.yield
+import kotlinx.serialization.Serializable
+import kotlinx.serialization.json.Json
+import okio.FileSystem
+import okio.Path
+import okio.Path.Companion.toPath
+import kotlin.coroutines.CoroutineContext
+import kotlin.time.Clock
+import kotlin.time.Duration
+import kotlin.time.Duration.Companion.days
+import kotlin.time.Duration.Companion.seconds
+import kotlin.time.Instant
+
+/**
+ * Running total of the bytes stored under each of the [roots], so reading the storage used
+ * doesn't need to walk and stat every file. Totals are kept per entry directly inside a root
+ * (e.g. `Measurement`, `Log`), so deleting one of those folders doesn't need to walk it either.
+ *
+ * File operations report what they change through [track] and [trackDelete]. Files written by
+ * anyone else (the engine) make the ledger drift, so it's fully recounted by [reconcile] when it's
+ * older than [reconcileInterval]. The totals are saved to [ledgerPath] to survive restarts.
+ */
+class StorageUsageLedger(
+    private val fileSystem: FileSystem,
+    private val roots: List<Path>,
+    private val ledgerPath: Path,
+    private val json: Json,
+    private val backgroundContext: CoroutineContext,
+    private val reconcileInterval: Duration = DEFAULT_RECONCILE_INTERVAL,
+    private val clock: Clock = Clock.System,
+) {
+    private val lock = Mutex()
+    private val reconcileLock = Mutex()
+
+    // Bytes used under each entry directly inside a root, loaded on first use
+    private var usage: MutableMap<Path, Long>? = null
+    private var reconciledAt: Instant? = null
+    private var savedAt: Instant? = null
+
+    private val _total = MutableStateFlow(0L)
+    val total: StateFlow<Long> = _total.asStateFlow()
+
+    suspend fun needsReconciliation(): Boolean =
+        lock.withLock {
+            loadedUsage()
+            val reconciledAt = reconciledAt ?: return@withLock true
+            clock.now() - reconciledAt >= reconcileInterval
+        }
+
+    /**
+     * Runs [block], which writes or deletes [path], and records how much the size of [path]
+     * changed. For a directory, the size of all files inside it.
+     */
+    suspend fun <T> track(
+        path: Path,
+        block: suspend () -> T,
+    ): T {
+        val sizeBefore = withContext(backgroundContext) { sizeOf(path) }
+        val result = block()
+        val sizeAfter = withContext(backgroundContext) { sizeOf(path) }
+        if (sizeAfter != sizeBefore) record(path, sizeAfter - sizeBefore)
+        return result
+    }
+
+    /**
+     * Runs [block], which deletes [path]. A root, or an entry directly inside one, has its total
+     * dropped without walking it. Deeper folders are walked like [track] does.
+     */
+    suspend fun <T> trackDelete(
+        path: Path,
+        block: suspend () -> T,
+    ): T {
+        val root = rootOf(path) ?: return block()
+        if (path != root && path.parent != root) return track(path, block)
+
+        val result = block()
+        val sizeLeft = withContext(backgroundContext) { sizeOf(path) }
+        lock.withLock {
+            val usage = loadedUsage()
+            usage.keys.removeAll { it.isInside(path) }
+            // Whatever couldn't be deleted is still there
+            if (sizeLeft > 0) {
+                if (path == root) reconciledAt = null else usage[path] = sizeLeft
+            }
+            updateTotal()
+            save()
+        }
+        return result
+    }
+
+    /** Recounts every file. Skipped if a recount is already running. */
+    suspend fun reconcile() {
+        if (!reconcileLock.tryLock()) return
+        try {
+            val counted = withContext(backgroundContext) {
+                roots.fold(mutableMapOf<Path, Long>()) { counted, root ->
+                    counted.apply { putAll(countRoot(root)) }
+                }
+            }
+            lock.withLock {
+                loadedUsage()
+                usage = counted
+                reconciledAt = clock.now()
+                updateTotal()
+                save()
+            }
+        } finally {
+            reconcileLock.unlock()
+        }
+    }
+
+    private suspend fun record(
+        path: Path,
+        delta: Long,
+    ) {
+        val entry = entryOf(path) ?: return
+        lock.withLock {
+            val usage = loadedUsage()
+            usage[entry] = ((usage[entry] ?: 0L) + delta).coerceAtLeast(0L)
+            updateTotal()
+            // Recording happens on every file write, so the ledger file isn't saved every time
+            val savedAt = savedAt
+            if (savedAt == null || clock.now() - savedAt >= SAVE_INTERVAL) save()
+        }
+    }
+
+    // Must be called with the lock held
+    private suspend fun loadedUsage(): MutableMap<Path, Long> {
+        usage?.let { return it }
+        val saved = withContext(backgroundContext) {
+            try {
+                fileSystem
+                    .metadataOrNull(ledgerPath)
+                    ?.let { fileSystem.read(ledgerPath) { readUtf8() } }
+                    ?.let { json.decodeFromString<SavedLedger>(it) }
+            } catch (e: Exception) {
+                Logger.w("Could not read storage usage ledger", e)
+                null
+            }
+        }
+        // A ledger saved for other roots, or by a version without per-entry totals, can't be trusted
+        val trusted = saved?.takeIf { it.roots == roots.map(Path::toString) }
+        val loaded = trusted
+            ?.usage
+            ?.mapKeys { it.key.toPath() }
+            ?.filterKeys { entryOf(it) == it }
+            .orEmpty()
+            .toMutableMap()
+        usage = loaded
+        reconciledAt = trusted?.reconciledAt?.let(Instant::fromEpochMilliseconds)
+        updateTotal()
+        return loaded
+    }
+
+    // Must be called with the lock held
+    private suspend fun save() {
+        val saved = SavedLedger(
+            roots = roots.map(Path::toString),
+            usage = usage.orEmpty().mapKeys { it.key.toString() },
+            reconciledAt = reconciledAt?.toEpochMilliseconds(),
+        )
+        withContext(backgroundContext) {
+            try {
+                ledgerPath.parent?.let { fileSystem.createDirectories(it) }
+                fileSystem.write(ledgerPath) { writeUtf8(json.encodeToString(saved)) }
+            } catch (e: Exception) {
+                Logger.w("Could not save storage usage ledger", e)
+            }
+        }
+        savedAt = clock.now()
+    }
+
+    private fun updateTotal() {
+        _total.value = usage.orEmpty().values.sum()
+    }
+
+    // The most specific root, in case one is inside another
+    private fun rootOf(path: Path): Path? =
+        roots.filter { path.isInside(it) }.maxByOrNull { it.segments.size }
+
+    // The entry directly inside a root that holds [path], where its size is totaled
+    private fun entryOf(path: Path): Path? {
+        val root = rootOf(path) ?: return null
+        if (path == root) return null
+        return root.resolve(path.segments[root.segments.size])
+    }
+
+    private suspend fun countRoot(root: Path): Map<Path, Long> {
+        if (fileSystem.metadataOrNull(root) == null) return emptyMap()
+        val nestedRoots = roots.filter { it != root && it.isInside(root) }
+        val counted = mutableMapOf<Path, Long>()
+        var count = 0
+        fileSystem.listRecursively(root).forEach { path ->
+            // Low priority, let other work run while walking large folders
+            if (++count % YIELD_EVERY_FILES == 0) yield()
+            if (nestedRoots.any { path.isInside(it) }) return@forEach
+            val size = regularFileSize(path)
+            if (size > 0) {
+                val entry = root.resolve(path.segments[root.segments.size])
+                counted[entry] = (counted[entry] ?: 0L) + size
+            }
+        }
+        return counted
+    }
+
+    private fun sizeOf(path: Path): Long {
+        val metadata = fileSystem.metadataOrNull(path) ?: return 0L
+        if (!metadata.isDirectory) return regularFileSize(path)
+        return fileSystem.listRecursively(path).sumOf { regularFileSize(it) }
+    }
+
+    private fun regularFileSize(path: Path): Long {
+        val metadata = try {
+            fileSystem.metadataOrNull(path)
+        } catch (_: Exception) {
+            null
+        } ?: return 0L
+        return if (metadata.isRegularFile) metadata.size ?: 0L else 0L
+    }
+
+    private fun Path.isInside(root: Path) =
+        isAbsolute == root.isAbsolute && segments.take(root.segments.size) == root.segments
+
+    @Serializable
+    private data class SavedLedger(
+        val roots: List<String> = emptyList(),
+        val usage: Map<String, Long>,
+        val reconciledAt: Long? = null,
+    )
+
+    companion object {
+        val FILE_PATH = "storage_usage.json".toPath()
+
+        private val DEFAULT_RECONCILE_INTERVAL = 1.days
+        private val SAVE_INTERVAL = 10.seconds
+        private const val YIELD_EVERY_FILES = 200
+    }
+}
+
+/** Runs [block] tracking the changes to [path] in the ledger, if there is one */
+suspend fun <T> StorageUsageLedger?.trackIfPresent(
+    path: Path,
+    block: suspend () -> T,
+): T = if (this == null) block() else track(path, block)
+
+/** Runs [block] tracking the deletion of [path] in the ledger, if there is one */
+suspend fun <T> StorageUsageLedger?.trackDeleteIfPresent(
+    path: Path,
+    block: suspend () -> T,
+): T = if (this == null) block() else trackDelete(path, block)
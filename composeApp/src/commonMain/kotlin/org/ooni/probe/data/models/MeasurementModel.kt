@@ -23,8 +23,10 @@ data class MeasurementModel(
     val reportId: ReportId?,
     val uid: Uid? = null,
     val testKeys: String? = null,
+    val testKeysSummary: TestKeysSummary? = null,
     val rerunNetwork: String? = null,
     val verificationStatus: VerificationStatus? = null,
+    val reportLocation: ReportLocation? = null,
     val urlId: UrlModel.Id?,
     val resultId: ResultModel.Id,
 ) {
@@ -40,11 +42,19 @@ data class MeasurementModel(
         val value: String,
     )
 
+    /** Where the compressed report is, inside the segments of the MeasurementReportStore */
+    data class ReportLocation(
+        val segment: Long,
+        val offset: Long,
+        val length: Long,
+    )
+
     val idOrThrow get() = id ?: throw IllegalStateException("Id no available")
 
     val logFilePath: Path
         get() = logFilePath(resultId, test)
 
+    // Report file written by older versions, and where the report is exported for sharing
     val reportFilePath: Path?
         get() = id?.let { "Measurement/${id.value}_${test.name}.json".toPath() }
 
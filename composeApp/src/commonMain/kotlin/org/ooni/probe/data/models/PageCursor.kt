@@ -0,0 +1,19 @@
+package org.ooni.probe.data.models
+
+/**
+ * Position in a list ordered by start time and id, for keyset pagination:
+ * pages are fetched relative to a cursor instead of an offset.
+ */
+data class PageCursor(
+    val startTime: Long,
+    val id: Long,
+)
+
+/**
+ * A page of the results list, newest first: the results older than [after] and at least as new
+ * as [until]. Without [until], the page is the first [ResultFilter.PAGE_SIZE] results after [after].
+ */
+data class ResultsPage(
+    val after: PageCursor? = null,
+    val until: PageCursor? = null,
+)
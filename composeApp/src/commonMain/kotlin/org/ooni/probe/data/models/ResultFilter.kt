@@ -13,7 +13,6 @@ data class ResultFilter(
     val networks: List<NetworkModel> = emptyList(),
     val taskOrigin: TaskOrigin? = null,
     val dates: Date = Date.AnyDate,
-    val limit: Long = LIMIT,
 ) {
     val isAll get() = this == ResultFilter()
 
@@ -44,7 +43,7 @@ data class ResultFilter(
     }
 
     companion object {
-        const val LIMIT = 100L
+        const val PAGE_SIZE = 100L
         private val MIN_DATE = LocalDate(2000, 1, 1)
         private val MAX_DATE = LocalDate.today().plus(1, DateTimeUnit.YEAR)
     }
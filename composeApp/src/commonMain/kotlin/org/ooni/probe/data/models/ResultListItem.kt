@@ -4,6 +4,7 @@ data class ResultListItem(
     val result: ResultModel,
     val descriptor: DescriptorItem,
     val network: NetworkModel?,
+    val pageCursor: PageCursor?,
     val measurementCounts: MeasurementCounts,
     val allMeasurementsUploaded: Boolean,
     val anyMeasurementUploadFailed: Boolean,
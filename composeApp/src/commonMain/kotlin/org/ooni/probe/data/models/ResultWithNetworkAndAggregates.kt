@@ -3,6 +3,8 @@ package org.ooni.probe.data.models
 data class ResultWithNetworkAndAggregates(
     val result: ResultModel,
     val network: NetworkModel?,
+    // Built from the stored start time, so it matches the rows the page queries compare against
+    val pageCursor: PageCursor?,
     val measurementCounts: MeasurementCounts,
     val allMeasurementsUploaded: Boolean,
     val anyMeasurementUploadFailed: Boolean,
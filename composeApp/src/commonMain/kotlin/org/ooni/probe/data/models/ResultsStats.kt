@@ -5,4 +5,5 @@ data class ResultsStats(
     val networks: Long,
     val dataUsageUp: Long,
     val dataUsageDown: Long,
+    val notViewed: Long,
 )
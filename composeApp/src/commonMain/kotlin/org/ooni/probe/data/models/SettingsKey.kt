@@ -83,4 +83,7 @@ enum class SettingsKey(
     ROUTE("route"),
 
     CLEAR_LEGACY_DIRECTORIES("clear_legacy_directories"),
+
+    // Set once the measurement counters were checked after the migration that added them
+    RESULT_COUNTERS_CHECKED("result_counters_checked"),
 }
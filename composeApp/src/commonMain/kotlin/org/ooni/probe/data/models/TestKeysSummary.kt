@@ -0,0 +1,62 @@
+package org.ooni.probe.data.models
+
+import okio.Buffer
+import org.ooni.engine.models.TestKeys
+
+/**
+ * The few test keys shown in the results lists and dashboards, stored as a small fixed-width
+ * binary value so they're read without decoding the test keys JSON.
+ *
+ * Layout: a version byte, a byte with a bit set for each value present, then each value as an
+ * 8-byte double, in the order of the properties.
+ */
+data class TestKeysSummary(
+    val medianBitrate: Double? = null,
+    val upload: Double? = null,
+    val download: Double? = null,
+    val ping: Double? = null,
+) {
+    private val values get() = listOf(medianBitrate, upload, download, ping)
+
+    fun encode(): ByteArray {
+        val buffer = Buffer()
+        buffer.writeByte(VERSION)
+        buffer.writeByte(
+            values.foldIndexed(0) { index, flags, value ->
+                if (value != null) flags or (1 shl index) else flags
+            },
+        )
+        values.forEach { buffer.writeLong((it ?: 0.0).toRawBits()) }
+        return buffer.readByteArray()
+    }
+
+    companion object {
+        private const val VERSION = 1
+        private const val VALUES_COUNT = 4
+        private const val ENCODED_SIZE = 2L + VALUES_COUNT * Long.SIZE_BYTES
+
+        fun from(testKeys: TestKeys) =
+            TestKeysSummary(
+                medianBitrate = testKeys.simple?.medianBitrate,
+                upload = testKeys.summary?.upload,
+                download = testKeys.summary?.download,
+                ping = testKeys.summary?.ping,
+            )
+
+        /** Null if [bytes] isn't a summary in a version we know */
+        fun decode(bytes: ByteArray): TestKeysSummary? {
+            val buffer = Buffer().write(bytes)
+            if (buffer.size != ENCODED_SIZE || buffer.readByte().toInt() != VERSION) return null
+            val flags = buffer.readByte().toInt()
+            val values = List(VALUES_COUNT) { index ->
+                Double.fromBits(buffer.readLong()).takeIf { flags and (1 shl index) != 0 }
+            }
+            return TestKeysSummary(
+                medianBitrate = values[0],
+                upload = values[1],
+                download = values[2],
+                ping = values[3],
+            )
+        }
+    }
+}
@@ -14,46 +14,43 @@ import ooniprobe.composeapp.generated.resources.r480p
 import ooniprobe.composeapp.generated.resources.r720p
 import ooniprobe.composeapp.generated.resources.r720p_ext
 import org.jetbrains.compose.resources.StringResource
-import org.ooni.engine.models.TestKeys
 import org.ooni.engine.models.TestType
 import org.ooni.probe.shared.format
 
 data class TestKeysWithResultId(
     val id: MeasurementModel.Id,
     val testName: String?,
-    val testKeys: TestKeys?,
+    val summary: TestKeysSummary?,
     val resultId: ResultModel.Id,
     val descriptorName: String?,
     val descriptorRunId: Descriptor.Id?,
 )
 
 fun List<TestKeysWithResultId>.videoQuality() =
-    this.firstOrNull { TestType.Dash.name == it.testName }?.testKeys?.getVideoQuality(extended = false)
+    this.firstOrNull { TestType.Dash.name == it.testName }?.let { dash ->
+        dash.summary?.getVideoQuality(extended = false) ?: Res.string.TestResults_NotAvailable
+    }
 
 fun List<TestKeysWithResultId>.uploadSpeed() =
     firstOrNull { TestType.Ndt.name == it.testName }
-        ?.testKeys
         ?.summary
         ?.upload
         ?.let(::ScaledValue)
 
 fun List<TestKeysWithResultId>.downloadSpeed() =
     firstOrNull { TestType.Ndt.name == it.testName }
-        ?.testKeys
         ?.summary
         ?.download
         ?.let(::ScaledValue)
 
 fun List<TestKeysWithResultId>.ping() =
     firstOrNull { TestType.Ndt.name == it.testName }
-        ?.testKeys
         ?.summary
         ?.ping
         ?.format(1)
 
-fun TestKeys.getVideoQuality(extended: Boolean): StringResource =
-    simple
-        ?.medianBitrate
+fun TestKeysSummary.getVideoQuality(extended: Boolean): StringResource =
+    medianBitrate
         ?.let { minimumBitrateForVideo(it, extended) }
         ?: Res.string.TestResults_NotAvailable
 
@@ -16,15 +16,15 @@ import org.ooni.probe.Database
 import org.ooni.probe.data.GetById
 import org.ooni.probe.data.Measurement
 import org.ooni.probe.data.SelectByResultIdWithUrl
-import org.ooni.probe.data.SelectTestKeysByDescriptorKey
 import org.ooni.probe.data.SelectTestKeysByResultId
+import org.ooni.probe.data.SelectTestKeysByResultIds
 import org.ooni.probe.data.SelectWithUrl
 import org.ooni.probe.data.Url
 import org.ooni.probe.data.models.Descriptor
-import org.ooni.probe.data.models.DescriptorItem
 import org.ooni.probe.data.models.MeasurementModel
 import org.ooni.probe.data.models.MeasurementWithUrl
 import org.ooni.probe.data.models.ResultModel
+import org.ooni.probe.data.models.TestKeysSummary
 import org.ooni.probe.data.models.TestKeysWithResultId
 import org.ooni.probe.data.models.UrlModel
 import org.ooni.probe.shared.toEpoch
@@ -43,6 +43,7 @@ class MeasurementRepository(
             .mapToList(backgroundContext)
             .map { list -> list.mapNotNull { it.toModel() } }
 
+    /** All measurements of a result, see selectByResultIdWithUrl for why this isn't paginated */
     fun listByResultId(id: ResultModel.Id) =
         database.measurementQueries
             .selectByResultIdWithUrl(id.value)
@@ -80,12 +81,10 @@ class MeasurementRepository(
             .mapToList(backgroundContext)
             .map { list -> list.mapNotNull { it.toModel() } }
 
-    fun selectTestKeys(filterByDescriptors: List<DescriptorItem>): Flow<List<TestKeysWithResultId>> =
+    fun selectTestKeysByResultIds(resultIds: List<ResultModel.Id>): Flow<List<TestKeysWithResultId>> =
         database.measurementQueries
-            .selectTestKeysByDescriptorKey(
-                filterByDescriptors = if (filterByDescriptors.any()) 1 else 0,
-                descriptorsKeys = filterByDescriptors.map { it.key },
-            ).asFlow()
+            .selectTestKeysByResultIds(resultIds = resultIds.map { it.value })
+            .asFlow()
             .mapToList(backgroundContext)
             .map { list -> list.mapNotNull { it.toModel() } }
 
@@ -104,6 +103,15 @@ class MeasurementRepository(
             .mapToOne(backgroundContext)
             .map { it.toModel() }
 
+    suspend fun listReportSegments(): Set<Long> =
+        withContext(backgroundContext) {
+            database.measurementQueries
+                .selectReportSegments()
+                .executeAsList()
+                .mapNotNull { it.report_segment }
+                .toSet()
+        }
+
     fun countFromStartTime(startTime: LocalDateTime): Flow<Long> =
         database.measurementQueries
             .countFromStartTime(startTime.toEpoch())
@@ -113,34 +121,76 @@ class MeasurementRepository(
     suspend fun createOrUpdate(model: MeasurementModel): MeasurementModel.Id =
         withContext(backgroundContext) {
             database.transactionWithResult {
-                database.measurementQueries.insertOrReplace(
-                    id = model.id?.value,
-                    test_name = model.test.name,
-                    start_time = model.startTime?.toEpoch(),
-                    runtime = model.runtime,
-                    is_done = if (model.isDone) 1 else 0,
-                    is_uploaded = if (model.isUploaded) 1 else 0,
-                    is_failed = if (model.isFailed) 1 else 0,
-                    failure_msg = model.failureMessage,
-                    is_upload_failed = if (model.isUploadFailed) 1 else 0,
-                    upload_failure_msg = model.uploadFailureMessage,
-                    is_rerun = if (model.isRerun) 1 else 0,
-                    is_anomaly = if (model.isAnomaly) 1 else 0,
-                    report_id = model.reportId?.value,
-                    uid = model.uid?.value,
-                    test_keys = model.testKeys,
-                    rerun_network = model.rerunNetwork,
-                    url_id = model.urlId?.value,
-                    result_id = model.resultId.value,
-                    verification_status = model.verificationStatus?.name,
-                )
-
+                insertOrReplace(model)
                 model.id ?: MeasurementModel.Id(
                     database.measurementQueries.selectLastInsertedRowId().executeAsOne(),
                 )
             }
         }
 
+    // Writes all models in a single transaction, so observers are only notified once
+    suspend fun createOrUpdateAll(models: List<MeasurementModel>) {
+        withContext(backgroundContext) {
+            database.transaction {
+                models.forEach { insertOrReplace(it) }
+            }
+        }
+    }
+
+    private fun insertOrReplace(model: MeasurementModel) {
+        database.measurementQueries.insertOrReplace(
+            id = model.id?.value,
+            test_name = model.test.name,
+            start_time = model.startTime?.toEpoch(),
+            runtime = model.runtime,
+            is_done = if (model.isDone) 1 else 0,
+            is_uploaded = if (model.isUploaded) 1 else 0,
+            is_failed = if (model.isFailed) 1 else 0,
+            failure_msg = model.failureMessage,
+            is_upload_failed = if (model.isUploadFailed) 1 else 0,
+            upload_failure_msg = model.uploadFailureMessage,
+            is_rerun = if (model.isRerun) 1 else 0,
+            is_anomaly = if (model.isAnomaly) 1 else 0,
+            report_id = model.reportId?.value,
+            uid = model.uid?.value,
+            test_keys = model.testKeys,
+            rerun_network = model.rerunNetwork,
+            url_id = model.urlId?.value,
+            result_id = model.resultId.value,
+            verification_status = model.verificationStatus?.name,
+            report_segment = model.reportLocation?.segment,
+            report_offset = model.reportLocation?.offset,
+            report_length = model.reportLocation?.length,
+            test_keys_summary = model.testKeysSummaryOrDecoded()?.encode(),
+        )
+    }
+
+    /**
+     * Fills in the test keys summary of measurements stored before it existed, decoding their
+     * test keys once. Returns how many measurements were updated.
+     */
+    suspend fun fillMissingTestKeysSummaries(): Long =
+        withContext(backgroundContext) {
+            var updated = 0L
+            do {
+                val batch = database.measurementQueries
+                    .selectWithoutTestKeysSummary(SUMMARY_BATCH_SIZE)
+                    .executeAsList()
+                database.transaction {
+                    batch.forEach { row ->
+                        // Test keys that can't be decoded get an empty summary, to not try again
+                        val summary = row.test_keys
+                            ?.let(::decodeTestKeys)
+                            ?.let(TestKeysSummary::from)
+                            ?: TestKeysSummary()
+                        database.measurementQueries.updateTestKeysSummary(summary.encode(), row.id)
+                    }
+                }
+                updated += batch.size
+            } while (batch.size.toLong() == SUMMARY_BATCH_SIZE)
+            updated
+        }
+
     suspend fun deleteById(measurementId: MeasurementModel.Id) = deleteByIds(listOf(measurementId))
 
     suspend fun deleteByIds(measurementIds: List<MeasurementModel.Id>) {
@@ -174,8 +224,16 @@ class MeasurementRepository(
             reportId = report_id?.let(MeasurementModel::ReportId),
             uid = uid?.let(MeasurementModel::Uid),
             testKeys = test_keys,
+            testKeysSummary = test_keys_summary?.let(TestKeysSummary::decode),
             rerunNetwork = rerun_network,
             verificationStatus = verification_status?.let(::decodeVerificationStatus),
+            reportLocation = report_segment?.let { segment ->
+                MeasurementModel.ReportLocation(
+                    segment = segment,
+                    offset = report_offset ?: return@let null,
+                    length = report_length ?: return@let null,
+                )
+            },
             urlId = url_id?.let(UrlModel::Id),
             resultId = result_id?.let(ResultModel::Id) ?: return null,
         )
@@ -203,6 +261,10 @@ class MeasurementRepository(
                 url_id = url_id,
                 result_id = result_id,
                 verification_status = verification_status,
+                report_segment = report_segment,
+                report_offset = report_offset,
+                report_length = report_length,
+                test_keys_summary = test_keys_summary,
             ).toModel() ?: return null,
             url = id_?.let { urlId ->
                 Url(
@@ -237,6 +299,10 @@ class MeasurementRepository(
                 url_id = url_id,
                 result_id = result_id,
                 verification_status = verification_status,
+                report_segment = report_segment,
+                report_offset = report_offset,
+                report_length = report_length,
+                test_keys_summary = test_keys_summary,
             ).toModel() ?: return null,
             url = id_?.let { urlId ->
                 Url(
@@ -271,6 +337,10 @@ class MeasurementRepository(
                 url_id = url_id,
                 result_id = result_id,
                 verification_status = verification_status,
+                report_segment = report_segment,
+                report_offset = report_offset,
+                report_length = report_length,
+                test_keys_summary = test_keys_summary,
             ).toModel() ?: return null,
             url = Url(
                 id = url_id ?: return null,
@@ -281,12 +351,12 @@ class MeasurementRepository(
         )
     }
 
-    private fun SelectTestKeysByDescriptorKey.toModel(): TestKeysWithResultId? {
+    private fun SelectTestKeysByResultIds.toModel(): TestKeysWithResultId? {
         return TestKeysWithResultId(
             id = MeasurementModel.Id(id),
             resultId = result_id?.let(ResultModel::Id) ?: return null,
             testName = test_name,
-            testKeys = test_keys?.let(::decodeTestKeys),
+            summary = test_keys_summary?.let(TestKeysSummary::decode),
             descriptorName = descriptor_name,
             descriptorRunId = descriptor_runId?.let(Descriptor::Id),
         )
@@ -297,12 +367,16 @@ class MeasurementRepository(
             id = MeasurementModel.Id(id),
             resultId = result_id?.let(ResultModel::Id) ?: return null,
             testName = test_name,
-            testKeys = test_keys?.let(::decodeTestKeys),
+            summary = test_keys_summary?.let(TestKeysSummary::decode),
             descriptorName = descriptor_name,
             descriptorRunId = descriptor_runId?.let(Descriptor::Id),
         )
     }
 
+    // For models built with only the test keys JSON
+    private fun MeasurementModel.testKeysSummaryOrDecoded() =
+        testKeysSummary ?: testKeys?.let(::decodeTestKeys)?.let(TestKeysSummary::from)
+
     private fun decodeVerificationStatus(value: String): VerificationStatus? = runCatching { VerificationStatus.valueOf(value) }.getOrNull()
 
     private fun decodeTestKeys(value: String): TestKeys? {
@@ -314,4 +388,8 @@ class MeasurementRepository(
             null
         }
     }
+
+    companion object {
+        private const val SUMMARY_BATCH_SIZE = 500L
+    }
 }
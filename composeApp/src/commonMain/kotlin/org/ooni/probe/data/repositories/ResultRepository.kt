@@ -4,6 +4,7 @@ import app.cash.sqldelight.coroutines.asFlow
 import app.cash.sqldelight.coroutines.mapToList
 import app.cash.sqldelight.coroutines.mapToOne
 import app.cash.sqldelight.coroutines.mapToOneOrNull
+import co.touchlab.kermit.Logger
 import kotlinx.coroutines.flow.Flow
 import kotlinx.coroutines.flow.first
 import kotlinx.coroutines.flow.map
@@ -17,6 +18,7 @@ import org.ooni.probe.data.SelectByIdWithNetwork
 import org.ooni.probe.data.models.Descriptor
 import org.ooni.probe.data.models.MeasurementCounts
 import org.ooni.probe.data.models.NetworkModel
+import org.ooni.probe.data.models.PageCursor
 import org.ooni.probe.data.models.ResultFilter
 import org.ooni.probe.data.models.ResultModel
 import org.ooni.probe.data.models.ResultWithNetworkAndAggregates
@@ -31,10 +33,26 @@ class ResultRepository(
     private val database: Database,
     private val backgroundContext: CoroutineContext,
 ) {
-    fun list(filter: ResultFilter = ResultFilter()): Flow<List<ResultWithNetworkAndAggregates>> {
+    /** The newest results matching the [filter], up to [limit] results */
+    fun list(
+        filter: ResultFilter = ResultFilter(),
+        limit: Long = ResultFilter.PAGE_SIZE,
+    ): Flow<List<ResultWithNetworkAndAggregates>> = listPage(filter, limit = limit)
+
+    /**
+     * Results matching the [filter], newest first, that are older than [after] and at least as new
+     * as [until], up to [limit] results. Bounding a page with [until] instead of a [limit] keeps it
+     * stable while results are added or removed elsewhere in the list.
+     */
+    fun listPage(
+        filter: ResultFilter,
+        after: PageCursor? = null,
+        until: PageCursor? = null,
+        limit: Long? = null,
+    ): Flow<List<ResultWithNetworkAndAggregates>> {
         val params = FilterParams.build(filter)
         return database.resultQueries
-            .selectAllWithNetwork(
+            .selectPageWithNetwork(
                 filterByDescriptors = params.filterByDescriptors,
                 descriptorsKeys = params.descriptorsKeys,
                 filterByNetworks = params.filterByNetworks,
@@ -43,12 +61,45 @@ class ResultRepository(
                 taskOrigin = params.taskOrigin,
                 startFrom = params.startFrom,
                 startUntil = params.startUntil,
-                limit = params.limit,
+                hasAfter = if (after != null) 1 else 0,
+                afterStartTime = after?.startTime,
+                afterId = after?.id ?: 0,
+                hasUntil = if (until != null) 1 else 0,
+                untilStartTime = until?.startTime,
+                untilId = until?.id ?: 0,
+                // SQLite treats a negative limit as no limit
+                limit = limit ?: -1,
             ).asFlow()
             .mapToList(backgroundContext)
             .map { list -> list.mapNotNull { it.toModel() } }
     }
 
+    /** Cursor of the last result in the page after [after], or null if there are no more results */
+    suspend fun getNextPageEnd(
+        filter: ResultFilter,
+        after: PageCursor,
+        pageSize: Long,
+    ): PageCursor? =
+        withContext(backgroundContext) {
+            val params = FilterParams.build(filter)
+            database.resultQueries
+                .selectPageCursors(
+                    filterByDescriptors = params.filterByDescriptors,
+                    descriptorsKeys = params.descriptorsKeys,
+                    filterByNetworks = params.filterByNetworks,
+                    networkIds = params.networkIds,
+                    filterByTaskOrigin = params.filterByTaskOrigin,
+                    taskOrigin = params.taskOrigin,
+                    startFrom = params.startFrom,
+                    startUntil = params.startUntil,
+                    afterStartTime = after.startTime,
+                    afterId = after.id,
+                    limit = pageSize,
+                ).executeAsList()
+                .lastOrNull()
+                ?.let { PageCursor(startTime = it.start_time ?: return@let null, id = it.id) }
+        }
+
     fun getById(resultId: ResultModel.Id): Flow<Pair<ResultModel, NetworkModel?>?> =
         database.resultQueries
             .selectByIdWithNetwork(resultId.value)
@@ -103,6 +154,7 @@ class ResultRepository(
                     networks = it.networks,
                     dataUsageUp = it.data_usage_up?.roundToLong() ?: 0L,
                     dataUsageDown = it.data_usage_down?.roundToLong() ?: 0L,
+                    notViewed = it.not_viewed ?: 0L,
                 )
             }
     }
@@ -199,6 +251,22 @@ class ResultRepository(
         }
     }
 
+    /**
+     * Verifies the per-result measurement counters against the measurements themselves,
+     * and rebuilds them if they drifted. Returns the number of results that were inconsistent.
+     */
+    suspend fun checkCounters(): Long =
+        withContext(backgroundContext) {
+            database.transactionWithResult {
+                val inconsistent = database.resultCountersQueries.countInconsistent().executeAsOne()
+                if (inconsistent > 0) {
+                    Logger.w("Rebuilding measurement counters of $inconsistent results")
+                    database.resultCountersQueries.rebuild()
+                }
+                inconsistent
+            }
+        }
+
     suspend fun deleteAll() {
         withContext(backgroundContext) {
             database.transaction {
@@ -236,7 +304,7 @@ class ResultRepository(
     private fun org.ooni.probe.data.ResultWithNetworkAndAggregates.toModel(): ResultWithNetworkAndAggregates? {
         return ResultWithNetworkAndAggregates(
             result = Result(
-                id = id ?: return null,
+                id = id,
                 descriptor_name = descriptor_name,
                 start_time = start_time,
                 is_viewed = is_viewed,
@@ -259,10 +327,11 @@ class ResultRepository(
                     network_type = network_type,
                 ).toModel()
             },
+            pageCursor = start_time?.let { PageCursor(startTime = it, id = id) },
             measurementCounts = MeasurementCounts(
-                done = doneMeasurementsCount ?: 0,
-                failed = failedMeasurementsCount ?: 0,
-                anomaly = anomalyMeasurementsCount ?: 0,
+                done = doneMeasurementsCount,
+                failed = failedMeasurementsCount,
+                anomaly = anomalyMeasurementsCount,
             ),
             allMeasurementsUploaded = allMeasurementsUploaded,
             anyMeasurementUploadFailed = anyMeasurementUploadFailed,
@@ -307,7 +376,6 @@ class ResultRepository(
         val taskOrigin: String?,
         val startFrom: Long,
         val startUntil: Long,
-        val limit: Long,
     ) {
         companion object {
             fun build(filter: ResultFilter): FilterParams {
@@ -324,7 +392,6 @@ class ResultRepository(
                     startUntil = range.endInclusive
                         .atTime(23, 59, 59)
                         .toEpoch(),
-                    limit = filter.limit,
                 )
             }
         }
@@ -3,19 +3,24 @@ package org.ooni.probe.data.repositories
 import app.cash.sqldelight.coroutines.asFlow
 import app.cash.sqldelight.coroutines.mapToList
 import kotlinx.coroutines.flow.Flow
-import kotlinx.coroutines.flow.first
 import kotlinx.coroutines.flow.map
+import kotlinx.coroutines.sync.Mutex
+import kotlinx.coroutines.sync.withLock
 import kotlinx.coroutines.withContext
 import org.ooni.engine.models.WebConnectivityCategory
 import org.ooni.probe.Database
 import org.ooni.probe.data.Url
 import org.ooni.probe.data.models.UrlModel
+import org.ooni.probe.shared.LruCache
 import kotlin.coroutines.CoroutineContext
 
 class UrlRepository(
     private val database: Database,
     private val backgroundContext: CoroutineContext,
 ) {
+    private val idCache = LruCache<String, UrlModel.Id>(ID_CACHE_SIZE)
+    private val idCacheLock = Mutex()
+
     suspend fun createOrUpdate(model: UrlModel): UrlModel =
         withContext(backgroundContext) {
             database.transactionWithResult {
@@ -41,12 +46,12 @@ class UrlRepository(
         withContext(backgroundContext) {
             database.transactionWithResult {
                 val urlsWithoutId = models.filter { it.id == null }.map { it.url }
-                val existingModels: List<UrlModel> =
-                    // Some lists are too large for a single SQL query
+                val existingModels: Map<String, UrlModel> =
                     urlsWithoutId
-                        .chunked(200) { urlsChunk ->
+                        .chunked(SELECT_CHUNK_SIZE) { urlsChunk ->
                             database.urlQueries.selectByUrls(urlsChunk).executeAsList()
                         }.flatMap { list -> list.mapNotNull { it.toModel() } }
+                        .associateBy { it.url }
 
                 models.map { model ->
                     // Already has ID, let's update
@@ -55,7 +60,7 @@ class UrlRepository(
                         return@map model
                     }
 
-                    val existingModel = existingModels.firstOrNull { it.url == model.url }
+                    val existingModel = existingModels[model.url]
                     if (existingModel == null) {
                         // New URL, let's insert
                         return@map createOrUpdateWithoutTransaction(model)
@@ -72,18 +77,48 @@ class UrlRepository(
             }
         }
 
-    suspend fun getOrCreateByUrl(url: String): UrlModel =
-        listByUrls(listOf(url))
-            .first()
-            .firstOrNull()
-            ?: run {
-                val newModel = UrlModel(
-                    url = url,
-                    category = WebConnectivityCategory.MISC,
-                    countryCode = null,
-                )
-                createOrUpdate(newModel)
+    /**
+     * Ids of the [urls], adding the ones that don't exist yet in a single transaction.
+     * Recently used ids are kept in memory, since the same URLs are tested over and over.
+     */
+    suspend fun getOrCreateIdsByUrl(urls: Collection<String>): Map<String, UrlModel.Id> {
+        val ids = mutableMapOf<String, UrlModel.Id>()
+        val uncachedUrls = idCacheLock.withLock {
+            urls.filter { url ->
+                val id = idCache[url] ?: return@filter true
+                ids[url] = id
+                false
+            }
+        }.distinct()
+        if (uncachedUrls.isEmpty()) return ids
+
+        val storedIds = withContext(backgroundContext) {
+            database.transactionWithResult {
+                val existingIds = selectIdsByUrls(uncachedUrls)
+                val newUrls = uncachedUrls.filterNot { it in existingIds }
+                newUrls.forEach { url ->
+                    database.urlQueries.insertOrIgnoreUrl(
+                        url = url,
+                        category_code = WebConnectivityCategory.MISC.code,
+                        country_code = null,
+                    )
+                }
+                existingIds + selectIdsByUrls(newUrls)
             }
+        }
+        idCacheLock.withLock {
+            storedIds.forEach { (url, id) -> idCache[url] = id }
+        }
+        return ids + storedIds
+    }
+
+    private fun selectIdsByUrls(urls: List<String>): Map<String, UrlModel.Id> =
+        urls
+            .chunked(SELECT_CHUNK_SIZE) { urlsChunk ->
+                database.urlQueries.selectIdsByUrls(urlsChunk).executeAsList()
+            }.flatten()
+            .mapNotNull { row -> row.url?.let { it to UrlModel.Id(row.id) } }
+            .toMap()
 
     fun list(): Flow<List<UrlModel>> =
         database.urlQueries
@@ -92,12 +127,13 @@ class UrlRepository(
             .mapToList(backgroundContext)
             .map { list -> list.mapNotNull { it.toModel() } }
 
-    private fun listByUrls(urls: List<String>): Flow<List<UrlModel>> =
-        database.urlQueries
-            .selectByUrls(urls)
-            .asFlow()
-            .mapToList(backgroundContext)
-            .map { list -> list.mapNotNull { it.toModel() } }
+    companion object {
+        // Some lists are too large for a single SQL query
+        private const val SELECT_CHUNK_SIZE = 200
+
+        // Enough for the URLs of a few runs of the default websites test
+        private const val ID_CACHE_SIZE = 5_000
+    }
 }
 
 fun Url.toModel(): UrlModel? {
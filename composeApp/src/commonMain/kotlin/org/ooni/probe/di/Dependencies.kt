@@ -14,6 +14,7 @@ import okio.FileSystem
 import okio.Path.Companion.toPath
 import okio.SYSTEM
 import org.ooni.engine.Engine
+import org.ooni.engine.EngineTaskDispatcher
 import org.ooni.engine.NetworkTypeFinder
 import org.ooni.engine.OonimkallBridge
 import org.ooni.engine.SecureStorage
@@ -30,14 +31,11 @@ import org.ooni.probe.config.FlavorConfigInterface
 import org.ooni.probe.config.LegacyDirectoryManager
 import org.ooni.probe.config.OrganizationConfig
 import org.ooni.probe.config.ProxyConfig
-import org.ooni.probe.data.disk.AppendFile
-import org.ooni.probe.data.disk.AppendFileOkio
 import org.ooni.probe.data.disk.DeleteFiles
 import org.ooni.probe.data.disk.DeleteFilesOkio
-import org.ooni.probe.data.disk.ReadFile
-import org.ooni.probe.data.disk.ReadFileOkio
-import org.ooni.probe.data.disk.WriteFile
-import org.ooni.probe.data.disk.WriteFileOkio
+import org.ooni.probe.data.disk.MeasurementReportStore
+import org.ooni.probe.data.disk.SegmentedLogFile
+import org.ooni.probe.data.disk.StorageUsageLedger
 import org.ooni.probe.data.models.ArticleModel
 import org.ooni.probe.data.models.AutoRunParameters
 import org.ooni.probe.data.models.BatteryState
@@ -46,6 +44,7 @@ import org.ooni.probe.data.models.MeasurementModel
 import org.ooni.probe.data.models.MeasurementsFilter
 import org.ooni.probe.data.models.PlatformAction
 import org.ooni.probe.data.models.PreferenceCategoryKey
+import org.ooni.probe.data.models.ResultFilter
 import org.ooni.probe.data.models.ResultModel
 import org.ooni.probe.data.models.RunSpecification
 import org.ooni.probe.data.repositories.AppReviewRepository
@@ -238,35 +237,51 @@ class Dependencies(
     @VisibleForTesting
     val urlRepository by lazy { UrlRepository(database, databaseContext) }
 
-    private val readFile: ReadFile by lazy { ReadFileOkio(FileSystem.SYSTEM, baseFileDir) }
-    private val writeFile: WriteFile by lazy { WriteFileOkio(FileSystem.SYSTEM, baseFileDir) }
-    private val appendFile: AppendFile by lazy { AppendFileOkio(FileSystem.SYSTEM, baseFileDir) }
+    private val storageLedger by lazy {
+        StorageUsageLedger(
+            fileSystem = FileSystem.SYSTEM,
+            roots = listOf(baseFileDir.toPath(), cacheDir.toPath()),
+            ledgerPath = baseFileDir.toPath().resolve(StorageUsageLedger.FILE_PATH),
+            json = json,
+            backgroundContext = backgroundContext,
+        )
+    }
     private val deleteFiles: DeleteFiles by lazy {
         DeleteFilesOkio(
             fileSystem = FileSystem.SYSTEM,
             baseFilesDir = baseFileDir,
             backgroundContext = backgroundContext,
+            storageLedger = storageLedger,
         )
     }
 
-    private val getStorageUsed by lazy {
-        GetStorageUsed(
-            backgroundContext = backgroundContext,
-            baseFileDir = baseFileDir,
-            cacheDir = cacheDir,
+    private val getStorageUsed by lazy { GetStorageUsed(storageLedger) }
+
+    private val measurementReportStore by lazy {
+        MeasurementReportStore(
             fileSystem = FileSystem.SYSTEM,
+            baseFileDir = baseFileDir,
+            backgroundContext = backgroundContext,
+            storageLedger = storageLedger,
         )
     }
 
+    // Segments of the report store nothing points to anymore are deleted
+    private suspend fun compactMeasurementReports() {
+        measurementReportStore.compact(measurementRepository.listReportSegments())
+    }
+
     // Monitoring
 
     val crashMonitoring by lazy { CrashMonitoring(preferenceRepository, platformInfo) }
     val appLogger by lazy {
         AppLogger(
-            readFile = readFile,
-            writeFile = writeFile,
-            appendFile = appendFile,
-            deleteFiles = deleteFiles,
+            logFile = SegmentedLogFile(
+                fileSystem = FileSystem.SYSTEM,
+                baseFileDir = baseFileDir,
+                activePath = AppLogger.FILE_PATH,
+                storageLedger = storageLedger,
+            ),
             backgroundContext = backgroundContext,
         )
     }
@@ -282,6 +297,7 @@ class Dependencies(
         DownloadFile(
             fileSystem = FileSystem.SYSTEM,
             isOnline = connectivityMonitor::isOnline,
+            storageLedger = storageLedger,
         )
     }
 
@@ -313,9 +329,12 @@ class Dependencies(
             getEnginePreferences = getEnginePreferences::invoke,
             addRunCancelListener = runBackgroundStateManager::addCancelListener,
             backgroundContext = backgroundContext,
+            taskDispatcher = engineTaskDispatcher,
         )
     }
 
+    val engineTaskDispatcher by lazy { EngineTaskDispatcher() }
+
     // Domain
 
     private val acceptDescriptorUpdate by lazy {
@@ -371,6 +390,8 @@ class Dependencies(
             getMeasurementsWithoutResult = measurementRepository::listWithoutResult,
             deleteMeasurementsById = measurementRepository::deleteByIds,
             deleteFile = deleteFiles::invoke,
+            deleteReport = measurementReportStore::delete,
+            compactReports = ::compactMeasurementReports,
         )
     }
     val deleteOldResults by lazy {
@@ -504,9 +525,9 @@ class Dependencies(
     }
     private val getResults by lazy {
         GetResults(
-            resultRepository::list,
+            resultRepository::listPage,
             getTestDescriptors::all,
-            measurementRepository::selectTestKeys,
+            measurementRepository::selectTestKeysByResultIds,
         )
     }
     private val getResult by lazy {
@@ -740,11 +761,12 @@ class Dependencies(
             startTest = engine::startTask,
             getResultByIdAndUpdate = resultRepository::getByIdAndUpdate,
             setCurrentTestState = runBackgroundStateManager::updateState,
-            getOrCreateUrl = urlRepository::getOrCreateByUrl,
+            getOrCreateUrlIds = urlRepository::getOrCreateIdsByUrl,
             storeMeasurement = measurementRepository::createOrUpdate,
+            storeMeasurements = measurementRepository::createOrUpdateAll,
             storeNetwork = networkRepository::createIfNew,
-            writeFile = writeFile,
-            deleteFiles = deleteFiles,
+            writeReport = measurementReportStore::write,
+            deleteReport = measurementReportStore::delete,
             json = json,
             getPreferenceValueByKey = preferenceRepository::getValueByKey,
             submitMeasurement = submitMeasurement::invoke,
@@ -755,8 +777,8 @@ class Dependencies(
         SubmitMeasurement(
             submitMeasurementWithUser = submitMeasurementWithUser::invoke,
             engineSubmit = engine::submitMeasurement,
-            readFile = readFile,
-            deleteFiles = deleteFiles,
+            readReport = measurementReportStore::read,
+            deleteReport = measurementReportStore::delete,
             updateMeasurement = measurementRepository::createOrUpdate,
             deleteMeasurementById = measurementRepository::deleteById,
             handleSubmitOutcome = handleSubmitOutcome::invoke,
@@ -814,7 +836,9 @@ class Dependencies(
     private val uploadMissingMeasurements by lazy {
         UploadMissingMeasurements(
             getMeasurementsNotUploaded = getMeasurementsNotUploaded::invoke,
+            readReport = measurementReportStore::read,
             submitMeasurement = submitMeasurement::invoke,
+            compactReports = ::compactMeasurementReports,
         )
     }
     private val testProxy by lazy {
@@ -1046,6 +1070,9 @@ class Dependencies(
         goToResult = goToResult,
         goToUpload = goToUpload,
         getResults = getResults::invoke,
+        getNextPageEnd = { filter, after ->
+            resultRepository.getNextPageEnd(filter, after, ResultFilter.PAGE_SIZE)
+        },
         getResultsStats = resultRepository::countByFilter,
         getDescriptors = getTestDescriptors::latest,
         getNetworks = networkRepository::list,
@@ -1119,7 +1146,8 @@ class Dependencies(
         goToUpload = goToUpload,
         goToMeasurement = goToMeasurement,
         getMeasurement = measurementRepository::getById,
-        readFile = readFile,
+        readReport = measurementReportStore::read,
+        exportReport = measurementReportStore::export,
         shareFile = { launchAction(it) },
     )
 
@@ -9,15 +9,16 @@ class DeleteMeasurementsWithoutResult(
     private val getMeasurementsWithoutResult: suspend () -> Flow<List<MeasurementModel>>,
     private val deleteMeasurementsById: suspend (List<MeasurementModel.Id>) -> Unit,
     private val deleteFile: suspend (Path) -> Unit,
+    private val deleteReport: suspend (MeasurementModel) -> Unit,
+    private val compactReports: suspend () -> Unit,
 ) {
     suspend fun invoke() {
         val measurementsToDelete = getMeasurementsWithoutResult().first()
         measurementsToDelete.forEach { measurement ->
             deleteFile(measurement.logFilePath)
-            measurement.reportFilePath?.let { reportFilePath ->
-                deleteFile(reportFilePath)
-            }
+            deleteReport(measurement)
         }
         deleteMeasurementsById(measurementsToDelete.mapNotNull { it.id })
+        compactReports()
     }
 }
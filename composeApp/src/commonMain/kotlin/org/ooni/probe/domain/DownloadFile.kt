@@ -3,44 +3,189 @@ package org.ooni.probe.domain
 import io.ktor.client.HttpClient
 import io.ktor.client.plugins.HttpTimeout
 import io.ktor.client.request.get
+import io.ktor.client.request.header
+import io.ktor.client.request.prepareGet
+import io.ktor.client.statement.HttpResponse
 import io.ktor.client.statement.bodyAsBytes
+import io.ktor.client.statement.bodyAsChannel
+import io.ktor.client.statement.bodyAsText
+import io.ktor.http.HttpHeaders
+import io.ktor.http.HttpStatusCode
+import io.ktor.http.contentLength
 import io.ktor.http.isSuccess
+import io.ktor.utils.io.readAvailable
+import kotlinx.coroutines.CancellationException
 import okio.FileSystem
+import okio.HashingSink
 import okio.Path
 import okio.Path.Companion.toPath
+import okio.blackholeSink
 import okio.buffer
 import okio.use
 import org.ooni.engine.models.Failure
 import org.ooni.engine.models.Result
 import org.ooni.engine.models.Success
 import org.ooni.passport.models.PassportException
+import org.ooni.probe.data.disk.StorageUsageLedger
+import org.ooni.probe.data.disk.trackIfPresent
 import org.ooni.probe.data.models.GetBytesException
 import kotlin.time.Duration.Companion.seconds
 
 /**
  * Downloads binary content to a target absolute path using the provided fetcher.
+ * - Streams the body in chunks to `<target>.part`, so memory use doesn't grow with the file
+ * - Resumes an interrupted download from the `.part` file with an HTTP Range request
+ * - Verifies the SHA-256 checksum, when one is given, before moving it onto the target
  * - Creates parent directories if needed
- * - Skips writing if the target already exists with the same size
  */
 class DownloadFile(
     private val fileSystem: FileSystem,
     private val isOnline: () -> Boolean,
     private val httpClientFactory: () -> HttpClient = ::defaultHttpClient,
+    private val storageLedger: StorageUsageLedger? = null,
 ) {
     suspend operator fun invoke(
         url: String,
         absoluteTargetPath: String,
-    ): Result<Path, GetBytesException> =
-        fetchBytes(url).map { bytes ->
-            // Only touch the filesystem once there is something to write, so a failed or skipped
-            // download leaves no empty directory tree behind.
-            val target = absoluteTargetPath.toPath()
-            target.parent?.let { parent ->
-                if (fileSystem.metadataOrNull(parent) == null) fileSystem.createDirectories(parent)
+        sha256: String? = null,
+    ): Result<Path, GetBytesException> {
+        if (!isOnline()) {
+            return Failure(
+                GetBytesException(PassportException.Offline("No active network, skipped $url")),
+            )
+        }
+
+        val target = absoluteTargetPath.toPath()
+        val partialName = "${target.name}$PARTIAL_SUFFIX"
+        val partial = target.parent?.resolve(partialName) ?: partialName.toPath()
+        val client = httpClientFactory()
+
+        return try {
+            storageLedger
+                .trackIfPresent(partial) { downloadToPartial(client, url, partial, sha256 != null) }
+                .flatMap { verifyChecksum(partial, sha256) }
+                .map {
+                    storageLedger.trackIfPresent(partial) {
+                        storageLedger.trackIfPresent(target) {
+                            fileSystem.atomicMove(partial, target)
+                        }
+                    }
+                    target
+                }
+        } catch (e: CancellationException) {
+            throw e
+        } catch (e: Throwable) {
+            // The partial file is kept, the next attempt resumes from it
+            Failure(GetBytesException(e))
+        } finally {
+            client.close()
+        }
+    }
+
+    private suspend fun downloadToPartial(
+        client: HttpClient,
+        url: String,
+        partial: Path,
+        hasChecksum: Boolean,
+    ): Result<Unit, GetBytesException> {
+        val resumeFrom = fileSystem.metadataOrNull(partial)?.size ?: 0L
+        return client
+            .prepareGet(url) {
+                if (resumeFrom > 0) header(HttpHeaders.Range, "bytes=$resumeFrom-")
+            }.execute { response ->
+                when {
+                    resumeFrom > 0 && response.status == HttpStatusCode.PartialContent -> {
+                        val range = ContentRange.parse(response.headers[HttpHeaders.ContentRange])
+                        if (range == null || range.start != resumeFrom) {
+                            fileSystem.delete(partial, mustExist = false)
+                            Failure(GetBytesException(Exception("Unexpected range resuming $url")))
+                        } else {
+                            response.writeTo(partial, append = true, expectedSize = range.total)
+                        }
+                    }
+
+                    // Nothing left after the partial file: it's complete, if the checksum agrees
+                    resumeFrom > 0 && response.status == HttpStatusCode.RequestedRangeNotSatisfiable -> {
+                        if (hasChecksum) {
+                            Success(Unit)
+                        } else {
+                            fileSystem.delete(partial, mustExist = false)
+                            Failure(GetBytesException(Exception("Could not resume $url")))
+                        }
+                    }
+
+                    // The whole file, also when the server ignored the Range header
+                    response.status.isSuccess() ->
+                        response.writeTo(partial, append = false, expectedSize = response.contentLength())
+
+                    else -> Failure(
+                        GetBytesException(
+                            Exception("HTTP ${response.status.value} while GET $url: ${response.bodyAsText()}"),
+                        ),
+                    )
+                }
+            }
+    }
+
+    private suspend fun HttpResponse.writeTo(
+        partial: Path,
+        append: Boolean,
+        expectedSize: Long?,
+    ): Result<Unit, GetBytesException> {
+        // Only touch the filesystem once there is something to write, so a failed or skipped
+        // download leaves no empty directory tree behind.
+        partial.parent?.let { parent ->
+            if (fileSystem.metadataOrNull(parent) == null) fileSystem.createDirectories(parent)
+        }
+        val channel = bodyAsChannel()
+        val chunk = ByteArray(CHUNK_SIZE)
+        val sink = if (append) fileSystem.appendingSink(partial) else fileSystem.sink(partial)
+        sink.buffer().use { output ->
+            while (true) {
+                val read = channel.readAvailable(chunk, 0, chunk.size)
+                if (read == -1) break
+                output.write(chunk, 0, read)
+            }
+        }
+
+        val size = fileSystem.metadata(partial).size
+        return if (expectedSize != null && size != expectedSize) {
+            Failure(GetBytesException(Exception("Incomplete download: $size of $expectedSize bytes")))
+        } else {
+            Success(Unit)
+        }
+    }
+
+    private fun verifyChecksum(
+        partial: Path,
+        sha256: String?,
+    ): Result<Unit, GetBytesException> {
+        if (sha256 == null) return Success(Unit)
+        val actual = HashingSink.sha256(blackholeSink()).use { hashing ->
+            fileSystem.source(partial).buffer().use { it.readAll(hashing) }
+            hashing.hash.hex()
+        }
+        if (actual.equals(sha256, ignoreCase = true)) return Success(Unit)
+        // A corrupt file can't be resumed, start over next time
+        fileSystem.delete(partial, mustExist = false)
+        return Failure(GetBytesException(Exception("Checksum mismatch: expected $sha256, got $actual")))
+    }
+
+    // Content-Range: bytes <start>-<end>/<total or *>
+    private class ContentRange(
+        val start: Long,
+        val total: Long?,
+    ) {
+        companion object {
+            fun parse(header: String?): ContentRange? {
+                val range = header?.removePrefix("bytes ")?.split("/") ?: return null
+                return ContentRange(
+                    start = range.first().substringBefore("-").toLongOrNull() ?: return null,
+                    total = range.getOrNull(1)?.toLongOrNull(),
+                )
             }
-            fileSystem.sink(target).buffer().use { sink -> sink.write(bytes) }
-            target
         }
+    }
 
     /**
      * Perform a simple HTTP GET and return the raw response body bytes.
@@ -76,6 +221,9 @@ class DownloadFile(
     }
 }
 
+private const val PARTIAL_SUFFIX = ".part"
+private const val CHUNK_SIZE = 64 * 1024
+
 /**
  * Timeouts are generous on the request as a whole because a GeoIP database is several MB, but
  * tight on connect: a black-holed network fails at connect time, and that is the case that used
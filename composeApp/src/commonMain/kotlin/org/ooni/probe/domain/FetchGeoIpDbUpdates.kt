@@ -8,6 +8,7 @@ import kotlinx.serialization.Serializable
 import kotlinx.serialization.SerializationException
 import kotlinx.serialization.json.Json
 import okio.FileSystem
+import okio.IOException
 import okio.Path
 import okio.Path.Companion.toPath
 import org.ooni.engine.Engine.MkException
@@ -16,6 +17,7 @@ import org.ooni.engine.models.Result
 import org.ooni.engine.models.Success
 import org.ooni.passport.models.PassportException
 import org.ooni.passport.models.PassportHttpResponse
+import org.ooni.probe.data.disk.MmdbDelta
 import org.ooni.probe.data.models.GetBytesException
 import org.ooni.probe.data.models.SettingsKey
 import org.ooni.probe.data.repositories.PreferenceRepository
@@ -25,7 +27,11 @@ import kotlin.time.Duration.Companion.days
 import kotlin.time.Instant
 
 class FetchGeoIpDbUpdates(
-    private val downloadFile: suspend (url: String, absoluteTargetPath: String) -> Result<Path, GetBytesException>,
+    private val downloadFile: suspend (
+        url: String,
+        absoluteTargetPath: String,
+        sha256: String?,
+    ) -> Result<Path, GetBytesException>,
     private val cacheDir: String,
     private val passportGet: suspend (url: String) -> Result<PassportHttpResponse, PassportException>,
     private val preferencesRepository: PreferenceRepository,
@@ -36,6 +42,7 @@ class FetchGeoIpDbUpdates(
     companion object {
         private const val GEOIP_DB_VERSION_DEFAULT: String = "20250801"
         private const val GEOIP_DB_REPO: String = "ooni/historical-geoip"
+        private const val SHA256_PREFIX = "sha256:"
     }
 
     suspend operator fun invoke(): Result<Path?, MkException> {
@@ -48,10 +55,10 @@ class FetchGeoIpDbUpdates(
             }
         }
 
-        return getLatestEngineVersion()
-            .flatMap { version ->
+        return getLatestRelease()
+            .flatMap { release ->
                 val latest: String =
-                    version ?: return@flatMap Failure(MkException(IllegalStateException("Failed to fetch latest GeoIP DB release")))
+                    release?.tag ?: return@flatMap Failure(MkException(IllegalStateException("Failed to fetch latest GeoIP DB release")))
                 val (isLatest, latestVersion) = isGeoIpDbLatest(latest)
                 if (isLatest) {
                     // Update last check time even when already at latest version
@@ -69,7 +76,11 @@ class FetchGeoIpDbUpdates(
                         }
                         cacheDirPath.resolve("$latestVersion.mmdb").toString()
                     }
-                    downloadFile(url, target)
+                    // A delta from the installed version is much smaller, when there is one
+                    val updated: Result<Path, GetBytesException> =
+                        updateWithDelta(release, latestVersion, target.toPath())?.let { Success(it) }
+                            ?: downloadFile(url, target, release.sha256Of(geoIpDbFileName(latestVersion)))
+                    updated
                         .flatMap { downloadedPath ->
                             withContext(backgroundContext) {
                                 // Cleanup other mmdb files other than the latest
@@ -93,15 +104,11 @@ class FetchGeoIpDbUpdates(
 
     /**
      * Compare latest and current version integers and return pair of latest state and actual version number
-     * @return Pair<Boolean, String> where the first element is true if the DB is the latest,
-     * the second is the current version and the third is the latest version.
+     * @return Pair<Boolean, String> where the first element is true if the installed DB is at
+     * least as new as the latest release, and the second is the latest version.
      */
     private suspend fun isGeoIpDbLatest(latestVersion: String): Pair<Boolean, String> {
-        val currentGeoIpDbVersion: String =
-            (
-                preferencesRepository.getValueByKey(SettingsKey.MMDB_VERSION).first()
-                    ?: GEOIP_DB_VERSION_DEFAULT
-            ) as String
+        val currentGeoIpDbVersion = getCurrentVersion()
         val latestTag = normalize(latestVersion) ?: run {
             Logger.w("Unknown format for latest version $latestVersion")
             return true to latestVersion
@@ -112,12 +119,60 @@ class FetchGeoIpDbUpdates(
         }
 
         return Pair(
-            latestTag >= currentTag,
+            latestTag <= currentTag,
             latestTag.toString(),
         )
     }
 
-    private suspend fun getLatestEngineVersion(): Result<String?, MkException> {
+    private suspend fun getCurrentVersion(): String =
+        (
+            preferencesRepository.getValueByKey(SettingsKey.MMDB_VERSION).first()
+                ?: GEOIP_DB_VERSION_DEFAULT
+        ) as String
+
+    /**
+     * Builds the [latestVersion] database from the installed one and the delta published with
+     * the release, if there is one for the installed version.
+     * @return the updated database, or null if it needs a full download instead
+     */
+    private suspend fun updateWithDelta(
+        release: GhRelease,
+        latestVersion: String,
+        target: Path,
+    ): Path? {
+        val currentVersion = getCurrentVersion()
+        val deltaName = geoIpDeltaFileName(currentVersion, latestVersion)
+        if (release.assets.none { it.name == deltaName }) return null
+        val source = cacheDir.toPath().resolve("$currentVersion.mmdb")
+        if (!withContext(backgroundContext) { fileSystem.exists(source) }) return null
+
+        val delta = downloadFile(
+            buildReleaseAssetUrl(latestVersion, deltaName),
+            cacheDir.toPath().resolve(deltaName).toString(),
+            release.sha256Of(deltaName),
+        ).onFailure { Logger.w(it) { "Failed to download GeoIP delta $deltaName" } }
+            .get() ?: return null
+
+        return withContext(backgroundContext) {
+            try {
+                MmdbDelta.apply(
+                    fileSystem = fileSystem,
+                    source = source,
+                    delta = delta,
+                    target = target,
+                    expectedSha256 = release.sha256Of(geoIpDbFileName(latestVersion)),
+                )
+                target
+            } catch (e: IOException) {
+                Logger.w(e) { "Failed to apply GeoIP delta $deltaName" }
+                null
+            } finally {
+                fileSystem.delete(delta, mustExist = false)
+            }
+        }
+    }
+
+    private suspend fun getLatestRelease(): Result<GhRelease?, MkException> {
         val url = "https://api.github.com/repos/${GEOIP_DB_REPO}/releases/latest"
 
         return passportGet(url)
@@ -125,7 +180,7 @@ class FetchGeoIpDbUpdates(
             .map { response ->
                 response.bodyText?.takeIf { response.isSuccessful }?.let { payload ->
                     try {
-                        json.decodeFromString<GhRelease>(payload).tag
+                        json.decodeFromString<GhRelease>(payload)
                     } catch (e: SerializationException) {
                         Logger.e(e) { "Failed to decode release info" }
                         null
@@ -137,13 +192,26 @@ class FetchGeoIpDbUpdates(
             }
     }
 
-    private fun buildGeoIpDbUrl(version: String): String =
-        "https://github.com/${GEOIP_DB_REPO}/releases/download/$version/$version-ip2country_as.mmdb"
+    private fun buildGeoIpDbUrl(version: String): String = buildReleaseAssetUrl(version, geoIpDbFileName(version))
+
+    private fun buildReleaseAssetUrl(
+        version: String,
+        assetName: String,
+    ): String = "https://github.com/${GEOIP_DB_REPO}/releases/download/$version/$assetName"
+
+    private fun geoIpDbFileName(version: String) = "$version-ip2country_as.mmdb"
+
+    // Published next to the database, generated with the generateMmdbDelta Gradle task
+    private fun geoIpDeltaFileName(
+        fromVersion: String,
+        toVersion: String,
+    ) = "$fromVersion-$toVersion-ip2country_as.mmdb.delta"
 
     private fun normalize(tag: String): Int? = tag.removePrefix("v").trim().toIntOrNull()
 
     /**
-     * Delete all .mmdb files in the cache directory except for the specified version.
+     * Delete all .mmdb files in the cache directory except for the specified version, with any
+     * partial download or delta left behind.
      * @param keepVersion The version of the mmdb file to keep (e.g., "20250801")
      */
     private fun cleanupOldMmdbFiles(keepVersion: String) {
@@ -158,7 +226,9 @@ class FetchGeoIpDbUpdates(
 
             files.forEach { filePath ->
                 val fileName = filePath.name
-                if (fileName.endsWith(".mmdb") && fileName != keepFileName) {
+                // Also partial downloads of other versions, which won't be resumed
+                val isMmdb = fileName.contains(".mmdb")
+                if (isMmdb && fileName != keepFileName && fileName != "$keepFileName.part") {
                     try {
                         fileSystem.delete(filePath)
                         Logger.d { "Deleted old MMDB file: $fileName" }
@@ -175,5 +245,20 @@ class FetchGeoIpDbUpdates(
     @Serializable
     data class GhRelease(
         @SerialName("tag_name") val tag: String,
+        @SerialName("assets") val assets: List<GhAsset> = emptyList(),
+    ) {
+        /** SHA-256 of the asset with [name], from its digest like `sha256:<hex>` */
+        fun sha256Of(name: String) =
+            assets
+                .firstOrNull { it.name == name }
+                ?.digest
+                ?.takeIf { it.startsWith(SHA256_PREFIX) }
+                ?.removePrefix(SHA256_PREFIX)
+    }
+
+    @Serializable
+    data class GhAsset(
+        @SerialName("name") val name: String,
+        @SerialName("digest") val digest: String? = null,
     )
 }
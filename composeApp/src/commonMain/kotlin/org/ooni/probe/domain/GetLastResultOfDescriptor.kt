@@ -26,6 +26,8 @@ class GetLastResultOfDescriptor(
             result = result,
             descriptor = descriptor,
             network = network,
+            // Not part of a paged list
+            pageCursor = null,
             measurementCounts = MeasurementCounts(
                 done = measurements.count { it.measurement.isDone }.toLong(),
                 failed = measurements.count { it.measurement.isFailed }.toLong(),
@@ -1,43 +1,28 @@
 package org.ooni.probe.domain
 
 import kotlinx.coroutines.flow.Flow
-import kotlinx.coroutines.flow.MutableStateFlow
-import kotlinx.coroutines.flow.asStateFlow
-import kotlinx.coroutines.flow.onStart
-import kotlinx.coroutines.flow.update
-import kotlinx.coroutines.withContext
-import okio.FileNotFoundException
-import okio.FileSystem
-import okio.Path.Companion.toPath
-import kotlin.coroutines.CoroutineContext
+import kotlinx.coroutines.flow.channelFlow
+import kotlinx.coroutines.launch
+import org.ooni.probe.data.disk.StorageUsageLedger
 
+/**
+ * Storage used by the app, read from the [StorageUsageLedger] instead of walking every file.
+ * The ledger is recounted in the background when it's stale.
+ */
 class GetStorageUsed(
-    private val backgroundContext: CoroutineContext,
-    private val baseFileDir: String,
-    private val fileSystem: FileSystem,
-    private val cacheDir: String,
+    private val storageLedger: StorageUsageLedger,
 ) {
-    private val storageUsed = MutableStateFlow<Long>(0)
-
     fun observe(): Flow<Long> =
-        storageUsed
-            .asStateFlow()
-            .onStart { update() }
-
-    suspend fun update(): Long {
-        return withContext(backgroundContext) {
-            val allFiles = listOf(baseFileDir, cacheDir)
-                .flatMap { fileSystem.listRecursively(baseFileDir.toPath()) }
-            val usedStorage = allFiles.sumOf {
-                val metadata = try {
-                    fileSystem.metadata(it)
-                } catch (_: FileNotFoundException) {
-                    return@sumOf 0L
-                }
-                if (metadata.isRegularFile) metadata.size ?: 0 else 0
+        channelFlow {
+            launch {
+                if (storageLedger.needsReconciliation()) storageLedger.reconcile()
             }
-            storageUsed.update { usedStorage }
-            return@withContext usedStorage
+            storageLedger.total.collect { send(it) }
         }
+
+    /** Recounts every file, for when a lot has changed outside the tracked file operations */
+    suspend fun update(): Long {
+        storageLedger.reconcile()
+        return storageLedger.total.value
     }
 }
@@ -2,14 +2,14 @@ package org.ooni.probe.domain
 
 import co.touchlab.kermit.Logger
 import co.touchlab.kermit.Severity
+import kotlinx.coroutines.NonCancellable
 import kotlinx.coroutines.flow.Flow
 import kotlinx.coroutines.flow.first
+import kotlinx.coroutines.withContext
 import kotlinx.serialization.json.Json
 import org.ooni.engine.models.TaskEvent
 import org.ooni.engine.models.TaskEventResult
 import org.ooni.engine.models.TaskOrigin
-import org.ooni.probe.data.disk.DeleteFiles
-import org.ooni.probe.data.disk.WriteFile
 import org.ooni.probe.data.models.Descriptor
 import org.ooni.probe.data.models.DescriptorItem
 import org.ooni.probe.data.models.MeasurementModel
@@ -18,19 +18,22 @@ import org.ooni.probe.data.models.NetworkModel
 import org.ooni.probe.data.models.ResultModel
 import org.ooni.probe.data.models.RunBackgroundState
 import org.ooni.probe.data.models.SettingsKey
+import org.ooni.probe.data.models.TestKeysSummary
 import org.ooni.probe.data.models.UrlModel
 import org.ooni.probe.shared.monitoring.Instrumentation
 import org.ooni.probe.shared.toLocalDateTime
+import kotlin.time.Instant
 
 class RunNetTest(
     private val startTest: (NetTest, TaskOrigin, Descriptor.Id) -> Flow<TaskEvent>,
-    private val getOrCreateUrl: suspend (String) -> UrlModel,
+    private val getOrCreateUrlIds: suspend (Collection<String>) -> Map<String, UrlModel.Id>,
     private val storeMeasurement: suspend (MeasurementModel) -> MeasurementModel.Id,
+    private val storeMeasurements: suspend (List<MeasurementModel>) -> Unit,
     private val storeNetwork: suspend (NetworkModel) -> NetworkModel.Id,
     private val getResultByIdAndUpdate: suspend (ResultModel.Id, (ResultModel) -> ResultModel) -> Unit,
     private val setCurrentTestState: ((RunBackgroundState) -> RunBackgroundState) -> Unit,
-    private val writeFile: WriteFile,
-    private val deleteFiles: DeleteFiles,
+    private val writeReport: suspend (String) -> MeasurementModel.ReportLocation?,
+    private val deleteReport: suspend (MeasurementModel) -> Unit,
     private val json: Json,
     private val getPreferenceValueByKey: (SettingsKey) -> Flow<Any?>,
     private val submitMeasurement: suspend (MeasurementModel) -> MeasurementModel?,
@@ -50,7 +53,15 @@ class RunNetTest(
     private var reportId: String? = null
     private var lastNetwork: NetworkModel? = null
     private val measurements = mutableMapOf<Int, MeasurementModel>()
+    private val urlIds = mutableMapOf<String, UrlModel.Id>()
     private val progressStep = 1.0 / spec.descriptor.netTests.size
+    private var testStartTime: Instant? = null
+
+    // Most events update the measurement or the result, so their writes are coalesced
+    private val writeBehind = RunWriteBehind(
+        storeMeasurements = storeMeasurements,
+        storeResultUpdate = { getResultByIdAndUpdate(spec.resultId, it) },
+    )
 
     suspend operator fun invoke() {
         Instrumentation.withTransaction(
@@ -76,6 +87,11 @@ class RunNetTest(
             }
 
             try {
+                // Resolve all inputs at once, instead of one by one as the measurements start
+                spec.netTest.inputs
+                    ?.takeIf { it.isNotEmpty() }
+                    ?.let { urlIds += getOrCreateUrlIds(it) }
+
                 startTest(
                     spec.netTest,
                     spec.taskOrigin,
@@ -83,11 +99,18 @@ class RunNetTest(
                 ).collect(::onEvent)
             } catch (_: Exception) {
                 // Exceptions were logged in the Engine
+            } finally {
+                withContext(NonCancellable) { writeBehind.flush() }
             }
         }
     }
 
     private suspend fun onEvent(event: TaskEvent) {
+        handleEvent(event)
+        writeBehind.flushIfDue()
+    }
+
+    private suspend fun handleEvent(event: TaskEvent) {
         when (event) {
             TaskEvent.Started -> {
                 // We already update the initial state before starting the task
@@ -119,7 +142,7 @@ class RunNetTest(
                         urlId = if (event.url.isNullOrEmpty()) {
                             null
                         } else {
-                            getOrCreateUrl(event.url).id
+                            getUrlId(event.url)
                         },
                     ),
                 )
@@ -165,7 +188,11 @@ class RunNetTest(
                     if (event.result == null) {
                         measurement = measurement.copy(isFailed = true)
                     } else {
-                        if (event.result.testStartTime != null) {
+                        // The test start time is the same for every measurement of the task
+                        if (event.result.testStartTime != null &&
+                            event.result.testStartTime != testStartTime
+                        ) {
+                            testStartTime = event.result.testStartTime
                             updateResult {
                                 it.copy(
                                     startTime = event.result.testStartTime.toLocalDateTime(),
@@ -188,7 +215,7 @@ class RunNetTest(
                         // see https://github.com/ooni/probe-multiplatform/issues/435
                         if (event.result.input != null && measurement.urlId == null) {
                             measurement = measurement.copy(
-                                urlId = getOrCreateUrl(event.result.input).id,
+                                urlId = getUrlId(event.result.input),
                             )
                         }
 
@@ -200,6 +227,7 @@ class RunNetTest(
                                 } else {
                                     json.encodeToString(testKeys)
                                 },
+                                testKeysSummary = TestKeysSummary.from(it),
                             )
                         }
 
@@ -217,10 +245,12 @@ class RunNetTest(
                         )
                     }
 
-                    writeToReportFile(measurement, event.json)
-
-                    measurement
+                    writeToReport(measurement, event.json)
                 }
+                // The report can only be found through the location stored with the measurement.
+                // If it only reached the database at the next flush, a crash in between would
+                // leave the measurement without its report.
+                writeBehind.flush()
             }
 
             is TaskEvent.MeasurementSubmissionSuccessful -> {
@@ -236,9 +266,10 @@ class RunNetTest(
                             failureMessage = "Submission failed: missing measurement UID",
                         )
                     } else {
-                        measurement.reportFilePath?.let { deleteFiles(it) }
+                        deleteReport(measurement)
                         measurement.copy(
                             isUploaded = true,
+                            reportLocation = null,
                             uid = MeasurementModel.Uid(event.measurementUid),
                         )
                     }
@@ -265,6 +296,9 @@ class RunNetTest(
                 updateMeasurement(event.index) {
                     it.copy(isDone = true)
                 }
+                // A done measurement must be stored before it's submitted, and the submission
+                // writes the measurement on its own
+                writeBehind.flush()
                 submitMeasurement(event.index)
             }
 
@@ -275,6 +309,7 @@ class RunNetTest(
                         dataUsageUp = it.dataUsageUp + event.uploadedKb,
                     )
                 }
+                writeBehind.flush()
             }
 
             is TaskEvent.StartupFailure,
@@ -317,8 +352,11 @@ class RunNetTest(
         }
     }
 
-    private suspend fun updateResult(update: (ResultModel) -> ResultModel) {
-        getResultByIdAndUpdate(spec.resultId, update)
+    private suspend fun getUrlId(url: String): UrlModel.Id? =
+        urlIds[url] ?: getOrCreateUrlIds(listOf(url))[url]?.also { urlIds[url] = it }
+
+    private fun updateResult(update: (ResultModel) -> ResultModel) {
+        writeBehind.updateResult(update)
     }
 
     private suspend fun createMeasurement(
@@ -336,7 +374,7 @@ class RunNetTest(
         val measurement = measurements[index] ?: return
         val updatedMeasurement = update(measurement)
         measurements[index] = updatedMeasurement
-        storeMeasurement(updatedMeasurement)
+        writeBehind.updateMeasurement(updatedMeasurement)
     }
 
     private suspend fun submitMeasurement(index: Int) {
@@ -353,14 +391,12 @@ class RunNetTest(
         }
     }
 
-    private suspend fun writeToReportFile(
+    private suspend fun writeToReport(
         measurement: MeasurementModel,
         text: String,
-    ) {
-        writeFile(
-            path = measurement.reportFilePath ?: return,
-            contents = text,
-        )
+    ): MeasurementModel {
+        if (measurement.id == null) return measurement
+        return measurement.copy(reportLocation = writeReport(text) ?: return measurement)
     }
 
     /**
@@ -0,0 +1,67 @@
+package org.ooni.probe.domain
+
+import org.ooni.probe.data.models.MeasurementModel
+import org.ooni.probe.data.models.ResultModel
+import kotlin.time.Duration
+import kotlin.time.Duration.Companion.seconds
+import kotlin.time.TimeMark
+import kotlin.time.TimeSource
+
+/**
+ * Holds the measurement and result updates of a running test in memory, so the many updates of
+ * each task event turn into a few database writes. Only the latest version of each measurement is
+ * kept, and result updates are chained into a single one.
+ *
+ * Pending updates are written by [flush], which callers use at durability points (a report is
+ * written, a measurement is done, the task ends), or by [flushIfDue] once the oldest pending
+ * update is [window] old. Not thread-safe, it's meant to be used by a single run.
+ */
+class RunWriteBehind(
+    private val storeMeasurements: suspend (List<MeasurementModel>) -> Unit,
+    private val storeResultUpdate: suspend ((ResultModel) -> ResultModel) -> Unit,
+    private val window: Duration = DEFAULT_WINDOW,
+    private val timeSource: TimeSource = TimeSource.Monotonic,
+) {
+    private val pendingMeasurements = linkedMapOf<MeasurementModel.Id, MeasurementModel>()
+    private var pendingResultUpdate: ((ResultModel) -> ResultModel)? = null
+    private var oldestPending: TimeMark? = null
+
+    fun updateMeasurement(measurement: MeasurementModel) {
+        val id = measurement.id ?: return
+        pendingMeasurements[id] = measurement
+        markPending()
+    }
+
+    fun updateResult(update: (ResultModel) -> ResultModel) {
+        val previousUpdate = pendingResultUpdate
+        pendingResultUpdate = if (previousUpdate == null) {
+            update
+        } else {
+            { update(previousUpdate(it)) }
+        }
+        markPending()
+    }
+
+    suspend fun flushIfDue() {
+        if ((oldestPending ?: return).elapsedNow() >= window) flush()
+    }
+
+    suspend fun flush() {
+        val measurements = pendingMeasurements.values.toList()
+        val resultUpdate = pendingResultUpdate
+        pendingMeasurements.clear()
+        pendingResultUpdate = null
+        oldestPending = null
+
+        if (measurements.isNotEmpty()) storeMeasurements(measurements)
+        resultUpdate?.let { storeResultUpdate(it) }
+    }
+
+    private fun markPending() {
+        if (oldestPending == null) oldestPending = timeSource.markNow()
+    }
+
+    companion object {
+        private val DEFAULT_WINDOW = 1.seconds
+    }
+}
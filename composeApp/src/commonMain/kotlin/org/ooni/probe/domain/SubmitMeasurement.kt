@@ -11,8 +11,6 @@ import org.ooni.engine.models.Success
 import org.ooni.passport.models.SubmitError
 import org.ooni.passport.models.VerificationStatus
 import org.ooni.passport.models.isOfflineFailure
-import org.ooni.probe.data.disk.DeleteFiles
-import org.ooni.probe.data.disk.ReadFile
 import org.ooni.probe.data.models.MeasurementModel
 import org.ooni.probe.shared.monitoring.Instrumentation
 import org.ooni.probe.shared.monitoring.reportTransaction
@@ -22,30 +20,47 @@ class SubmitMeasurement(
         String,
     ) -> Result<ResponseData, Throwable?>,
     private val engineSubmit: suspend (String) -> Result<SubmitMeasurementResults, MkException>,
-    private val readFile: ReadFile,
-    private val deleteFiles: DeleteFiles,
+    private val readReport: suspend (MeasurementModel) -> String?,
+    private val deleteReport: suspend (MeasurementModel) -> Unit,
     private val updateMeasurement: suspend (MeasurementModel) -> Unit,
     private val deleteMeasurementById: suspend (MeasurementModel.Id) -> Unit,
     private val handleSubmitOutcome: suspend (VerificationStatus, SubmitError?) -> Unit,
     private val json: Json,
 ) {
     suspend operator fun invoke(measurement: MeasurementModel): MeasurementModel? =
-        Instrumentation.withTransaction(
-            operation = "SubmitMeasurement",
-            data = mapOf(
-                "measurementTest" to measurement.test.name,
-                "isFailed" to measurement.isFailed,
-                "isUploadFailed" to measurement.isUploadFailed,
-                "runtime" to measurement.runtime.toString(),
-            ),
-        ) {
-            invokeInstrumented(measurement)
-        }
+        withTransaction(measurement) { invokeInstrumented(measurement) }
+
+    /** Submits [measurement] with its [report] already read by the caller, e.g. ahead of time */
+    suspend operator fun invoke(
+        measurement: MeasurementModel,
+        report: String?,
+    ): MeasurementModel? = withTransaction(measurement) { invokeInstrumented(measurement, report) }
+
+    private suspend fun withTransaction(
+        measurement: MeasurementModel,
+        block: suspend () -> MeasurementModel?,
+    ) = Instrumentation.withTransaction(
+        operation = "SubmitMeasurement",
+        data = mapOf(
+            "measurementTest" to measurement.test.name,
+            "isFailed" to measurement.isFailed,
+            "isUploadFailed" to measurement.isUploadFailed,
+            "runtime" to measurement.runtime.toString(),
+        ),
+        block = block,
+    )
 
     suspend fun invokeInstrumented(measurement: MeasurementModel): MeasurementModel? {
-        val reportFilePath = measurement.reportFilePath ?: return measurement
+        if (measurement.id == null) return measurement
+        return invokeInstrumented(measurement, readReport(measurement))
+    }
+
+    suspend fun invokeInstrumented(
+        measurement: MeasurementModel,
+        report: String?,
+    ): MeasurementModel? {
+        if (measurement.id == null) return measurement
 
-        val report = readFile(reportFilePath)
         if (report.isNullOrBlank()) {
             Logger.w("Missing or empty measurement report file")
             measurement.id?.let { deleteMeasurementById(it) }
@@ -95,12 +110,13 @@ class SubmitMeasurement(
                     isUploadFailed = false,
                     uploadFailureMessage = null,
                     uid = result.value.uid,
+                    reportLocation = null,
                     verificationStatus = result.value.verificationStatus
                         .takeIf { it != VerificationStatus.Unknown },
                 )
                 updateMeasurement(newMeasurement)
                 Logger.i { "Measurement Submission successful: ${newMeasurement.uid}" }
-                deleteFiles(reportFilePath)
+                deleteReport(measurement)
                 newMeasurement
             }
 
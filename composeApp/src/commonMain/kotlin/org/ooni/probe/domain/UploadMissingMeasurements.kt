@@ -1,17 +1,27 @@
 package org.ooni.probe.domain
 
 import co.touchlab.kermit.Logger
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.coroutineScope
 import kotlinx.coroutines.flow.Flow
 import kotlinx.coroutines.flow.channelFlow
 import kotlinx.coroutines.flow.first
-import kotlinx.coroutines.isActive
+import kotlinx.coroutines.joinAll
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.sync.Mutex
+import kotlinx.coroutines.sync.withLock
 import org.ooni.probe.data.models.MeasurementModel
 import org.ooni.probe.data.models.MeasurementsFilter
 import org.ooni.probe.shared.monitoring.Instrumentation
 
 class UploadMissingMeasurements(
     private val getMeasurementsNotUploaded: (MeasurementsFilter) -> Flow<List<MeasurementModel>>,
-    private val submitMeasurement: suspend (MeasurementModel) -> MeasurementModel?,
+    private val readReport: suspend (MeasurementModel) -> String?,
+    // Submits a measurement with its report already read
+    private val submitMeasurement: suspend (MeasurementModel, String?) -> MeasurementModel?,
+    // Uploaded reports aren't needed anymore, their segments can go
+    private val compactReports: suspend () -> Unit = {},
+    private val concurrency: Int = DEFAULT_CONCURRENCY,
 ) {
     operator fun invoke(filter: MeasurementsFilter): Flow<State> =
         channelFlow {
@@ -32,42 +42,68 @@ class UploadMissingMeasurements(
                 var uploaded = 0
                 var failedToUpload = 0
                 var subsequentFailures = 0
+                var aborted = false
 
                 if (total > 0) {
                     Logger.i("Uploading missing measurements: $total")
                 }
 
-                measurements.forEach { measurement ->
-                    if (!isActive) return@withTransaction // Check is coroutine was cancelled
-
-                    if (subsequentFailures >= MAX_SUBSEQUENT_FAILURES) {
-                        Logger.i("Aborting upload due to too many subsequent failures")
-                        send(State.Finished(uploaded, failedToUpload, total))
-                        return@withTransaction
+                // Up to `concurrency` uploads in flight, all to the same backend. Reports are read
+                // ahead into a channel of the same size, so a worker finishing an upload finds the
+                // next report already read instead of waiting on disk and decompression.
+                val lock = Mutex()
+                coroutineScope {
+                    val reads = Channel<Pair<MeasurementModel, String?>>(concurrency)
+                    val reader = launch {
+                        measurements.forEach { reads.send(it to readReport(it)) }
+                        reads.close()
                     }
 
-                    send(State.Uploading(uploaded, failedToUpload, total))
+                    List(concurrency.coerceAtMost(total)) {
+                        launch {
+                            for ((measurement, report) in reads) {
+                                val proceed = lock.withLock {
+                                    if (subsequentFailures >= MAX_SUBSEQUENT_FAILURES) {
+                                        aborted = true
+                                        false
+                                    } else {
+                                        send(State.Uploading(uploaded, failedToUpload, total))
+                                        true
+                                    }
+                                }
+                                if (!proceed) break
 
-                    val newMeasurement = submitMeasurement(measurement)
+                                val newMeasurement = submitMeasurement(measurement, report)
 
-                    when {
-                        newMeasurement?.isUploaded == true -> {
-                            uploaded++
-                            subsequentFailures = 0
-                        }
-                        // Report can never be parsed/submitted (marked not-done): count it as failed
-                        // but not toward the subsequent-failure abort, so healthy measurements behind
-                        // it still run. Such rows are also excluded from future sweeps (is_done = 0).
-                        newMeasurement != null && !newMeasurement.isDone -> {
-                            failedToUpload++
-                        }
-                        else -> {
-                            failedToUpload++
-                            subsequentFailures++
+                                lock.withLock {
+                                    when {
+                                        newMeasurement?.isUploaded == true -> {
+                                            uploaded++
+                                            subsequentFailures = 0
+                                        }
+                                        // Report can never be parsed/submitted (marked not-done): count it as failed
+                                        // but not toward the subsequent-failure abort, so healthy measurements behind
+                                        // it still run. Such rows are also excluded from future sweeps (is_done = 0).
+                                        newMeasurement != null && !newMeasurement.isDone -> {
+                                            failedToUpload++
+                                        }
+                                        else -> {
+                                            failedToUpload++
+                                            subsequentFailures++
+                                        }
+                                    }
+                                }
+                            }
                         }
-                    }
+                    }.joinAll()
+                    // After an abort, stop reading reports nobody will upload
+                    reader.cancel()
                 }
 
+                if (aborted) {
+                    Logger.i("Aborting upload due to too many subsequent failures")
+                }
+                if (uploaded > 0) compactReports()
                 send(State.Finished(uploaded, failedToUpload, total))
             }
         }
@@ -93,5 +129,6 @@ class UploadMissingMeasurements(
 
     companion object {
         private const val MAX_SUBSEQUENT_FAILURES = 5
+        private const val DEFAULT_CONCURRENCY = 4
     }
 }
@@ -2,35 +2,54 @@ package org.ooni.probe.domain.results
 
 import kotlinx.coroutines.flow.Flow
 import kotlinx.coroutines.flow.combine
+import kotlinx.coroutines.flow.flatMapLatest
 import org.ooni.probe.data.models.DescriptorItem
 import org.ooni.probe.data.models.OoniTest
+import org.ooni.probe.data.models.PageCursor
 import org.ooni.probe.data.models.ResultFilter
 import org.ooni.probe.data.models.ResultListItem
 import org.ooni.probe.data.models.ResultModel
+import org.ooni.probe.data.models.ResultsPage
 import org.ooni.probe.data.models.ResultWithNetworkAndAggregates
 import org.ooni.probe.data.models.TestKeysWithResultId
 
 class GetResults(
-    private val getResults: (ResultFilter) -> Flow<List<ResultWithNetworkAndAggregates>>,
+    private val getResults: (
+        filter: ResultFilter,
+        after: PageCursor?,
+        until: PageCursor?,
+        limit: Long?,
+    ) -> Flow<List<ResultWithNetworkAndAggregates>>,
     private val getDescriptors: () -> Flow<List<DescriptorItem>>,
-    private val getTestKeys: (List<DescriptorItem>) -> Flow<List<TestKeysWithResultId>>,
+    private val getTestKeys: (List<ResultModel.Id>) -> Flow<List<TestKeysWithResultId>>,
 ) {
-    operator fun invoke(filter: ResultFilter): Flow<List<ResultListItem>> =
-        combine(
-            getResults(filter),
-            getDescriptors(),
-            getTestKeys(filter.descriptors),
-        ) { results, descriptors, testKeys ->
-            results.mapNotNull { item ->
-                ResultListItem(
-                    result = item.result,
-                    descriptor = descriptors.forResult(item.result) ?: return@mapNotNull null,
-                    network = item.network,
-                    measurementCounts = item.measurementCounts,
-                    allMeasurementsUploaded = item.allMeasurementsUploaded,
-                    anyMeasurementUploadFailed = item.anyMeasurementUploadFailed,
-                    testKeys = testKeys.forResult(item.result),
-                )
+    /** The results of a [page], with the test keys of those results only */
+    operator fun invoke(
+        filter: ResultFilter,
+        page: ResultsPage = ResultsPage(),
+    ): Flow<List<ResultListItem>> =
+        getResults(
+            filter,
+            page.after,
+            page.until,
+            if (page.until == null) ResultFilter.PAGE_SIZE else null,
+        ).flatMapLatest { results ->
+            combine(
+                getDescriptors(),
+                getTestKeys(results.mapNotNull { it.result.id }),
+            ) { descriptors, testKeys ->
+                results.mapNotNull { item ->
+                    ResultListItem(
+                        result = item.result,
+                        descriptor = descriptors.forResult(item.result) ?: return@mapNotNull null,
+                        network = item.network,
+                        pageCursor = item.pageCursor,
+                        measurementCounts = item.measurementCounts,
+                        allMeasurementsUploaded = item.allMeasurementsUploaded,
+                        anyMeasurementUploadFailed = item.anyMeasurementUploadFailed,
+                        testKeys = testKeys.forResult(item.result),
+                    )
+                }
             }
         }
 }
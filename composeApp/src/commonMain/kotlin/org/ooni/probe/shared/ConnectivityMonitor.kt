@@ -17,13 +17,15 @@ class ConnectivityMonitor(
     fun isOnline(): Boolean = networkTypeFinder() != NetworkType.NoInternet
 
     /**
-     * Emits the current state immediately, then only on change. Polls rather than registering a
-     * platform callback so that a single implementation covers Android, iOS and desktop.
+     * Emits the current state immediately, then only on change. Uses the changes pushed by the
+     * [NetworkTypeFinder] when available, and otherwise polls so that a single implementation
+     * covers Android, iOS and desktop.
      */
     fun observeIsOnline(): Flow<Boolean> =
-        tickerFlow(POLL_INTERVAL)
-            .map { isOnline() }
-            .distinctUntilChanged()
+        (
+            networkTypeFinder.observe()?.map { it != NetworkType.NoInternet }
+                ?: tickerFlow(POLL_INTERVAL).map { isOnline() }
+        ).distinctUntilChanged()
 
     companion object {
         @VisibleForTesting
@@ -0,0 +1,35 @@
+package org.ooni.probe.shared
+
+/**
+ * Map that keeps at most [capacity] entries, evicting the least recently used one when full.
+ * Not thread-safe.
+ */
+class LruCache<K : Any, V : Any>(
+    val capacity: Int,
+) {
+    init {
+        require(capacity > 0) { "capacity must be positive" }
+    }
+
+    // Insertion ordered, so the least recently used entry is the first one
+    private val entries = LinkedHashMap<K, V>()
+
+    val size get() = entries.size
+
+    operator fun get(key: K): V? {
+        val value = entries.remove(key) ?: return null
+        entries[key] = value
+        return value
+    }
+
+    operator fun set(
+        key: K,
+        value: V,
+    ) {
+        entries.remove(key)
+        entries[key] = value
+        if (entries.size > capacity) {
+            entries.remove(entries.keys.first())
+        }
+    }
+}
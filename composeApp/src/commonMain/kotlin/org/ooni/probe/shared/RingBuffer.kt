@@ -0,0 +1,39 @@
+package org.ooni.probe.shared
+
+/**
+ * Fixed-capacity buffer that keeps the latest [capacity] items. Adding is O(1): once full,
+ * each new item overwrites the oldest one. Not thread-safe.
+ */
+class RingBuffer<T : Any>(
+    val capacity: Int,
+) {
+    init {
+        require(capacity > 0) { "capacity must be positive" }
+    }
+
+    private val items = arrayOfNulls<Any>(capacity)
+    private var start = 0
+
+    var size = 0
+        private set
+
+    fun add(item: T) {
+        items[(start + size) % capacity] = item
+        if (size < capacity) {
+            size++
+        } else {
+            start = (start + 1) % capacity
+        }
+    }
+
+    fun addAll(items: Iterable<T>) = items.forEach(::add)
+
+    fun clear() {
+        items.fill(null)
+        start = 0
+        size = 0
+    }
+
+    @Suppress("UNCHECKED_CAST")
+    fun toList(): List<T> = List(size) { index -> items[(start + index) % capacity] as T }
+}
@@ -2,70 +2,111 @@ package org.ooni.probe.shared.monitoring
 
 import co.touchlab.kermit.LogWriter
 import co.touchlab.kermit.Severity
-import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.coroutineScope
+import kotlinx.coroutines.delay
 import kotlinx.coroutines.flow.Flow
 import kotlinx.coroutines.flow.MutableStateFlow
-import kotlinx.coroutines.flow.collectLatest
-import kotlinx.coroutines.flow.distinctUntilChanged
-import kotlinx.coroutines.flow.map
-import kotlinx.coroutines.flow.onStart
 import kotlinx.coroutines.flow.sample
+import kotlinx.coroutines.flow.transform
 import kotlinx.coroutines.flow.update
 import kotlinx.coroutines.launch
+import kotlinx.coroutines.sync.Mutex
+import kotlinx.coroutines.sync.withLock
 import kotlinx.coroutines.withContext
 import kotlinx.datetime.LocalDateTime
+import okio.Path
 import okio.Path.Companion.toPath
-import org.ooni.probe.data.disk.AppendFile
-import org.ooni.probe.data.disk.DeleteFiles
-import org.ooni.probe.data.disk.ReadFile
-import org.ooni.probe.data.disk.WriteFile
+import org.ooni.probe.data.disk.SegmentedLogFile
+import org.ooni.probe.shared.RingBuffer
 import org.ooni.probe.shared.now
 import org.ooni.probe.ui.shared.logFormat
 import kotlin.coroutines.CoroutineContext
+import kotlin.time.Duration.Companion.milliseconds
 import kotlin.time.Duration.Companion.seconds
 
 class AppLogger(
-    private val readFile: ReadFile,
-    private val writeFile: WriteFile,
-    private val appendFile: AppendFile,
-    private val deleteFiles: DeleteFiles,
+    private val logFile: SegmentedLogFile,
     private val backgroundContext: CoroutineContext,
 ) {
-    private val log = MutableStateFlow(emptyList<String>())
+    // Lines logged but not yet in the ring buffer, so logging never waits on the lock
+    private val pending = Channel<String>(Channel.UNLIMITED)
+
+    private val lock = Mutex()
+
+    // Serializes access to the log file, which isn't thread-safe
+    private val fileLock = Mutex()
+    private val lines = RingBuffer<String>(MAX_LINES)
+
+    // Lines in the ring buffer not yet appended to the log file
+    private val unwritten = mutableListOf<String>()
+
+    // Bumped on every change to the ring buffer
+    private val version = MutableStateFlow(0L)
 
     fun read(severity: Severity?): Flow<List<String>> =
-        log.map { lines ->
-            if (severity == null) {
-                lines
-            } else {
-                lines.filter { line ->
-                    line.contains(": ${severity.name.uppercase()} :")
-                }
-            }
+        version.transform {
+            val snapshot = lock.withLock { lines.toList() }
+            emit(
+                if (severity == null) {
+                    snapshot
+                } else {
+                    snapshot.filter { line ->
+                        line.contains(": ${severity.name.uppercase()} :")
+                    }
+                },
+            )
+            // Copying the buffer is O(lines), so don't do it for every single new line
+            delay(READ_INTERVAL)
         }
 
     suspend fun clear() {
-        log.value = emptyList()
-        deleteFiles(FILE_PATH)
+        lock.withLock {
+            lines.clear()
+            unwritten.clear()
+        }
+        version.update { it + 1 }
+        withContext(backgroundContext) { fileLock.withLock { logFile.clear() } }
     }
 
-    suspend fun getLogFilePath() =
-        FILE_PATH
-            .also { appendFile(it, "") } // Ensure file exists
+    // A single file with the whole log, including lines not persisted yet
+    suspend fun getLogFilePath(): Path =
+        withContext(backgroundContext) {
+            writeUnwrittenLines()
+            fileLock.withLock { logFile.export() }
+        }
 
-    // Persist the log into the log file after a certain period without changes
+    // Moves logged lines into the ring buffer as they come, and appends them to the log file
+    // after a certain period, so bursts of lines are written together
     suspend fun writeLogsToFile() {
         withContext(backgroundContext) {
-            log
-                .onStart {
-                    if (log.value.isEmpty()) {
-                        log.value = readFile(FILE_PATH).orEmpty().lines()
+            val previousLines = fileLock.withLock { logFile.readLastLines(MAX_LINES) }
+            lock.withLock {
+                if (lines.size == 0) lines.addAll(previousLines)
+            }
+            version.update { it + 1 }
+
+            coroutineScope {
+                launch {
+                    version
+                        .sample(WRITE_INTERVAL)
+                        .collect { writeUnwrittenLines() }
+                }
+                for (line in pending) {
+                    lock.withLock {
+                        lines.add(line)
+                        unwritten.add(line)
                     }
-                }.sample(5.seconds)
-                .distinctUntilChanged()
-                .collectLatest { lines ->
-                    writeFile(FILE_PATH, lines.joinToString("\n"))
+                    version.update { it + 1 }
                 }
+            }
+        }
+    }
+
+    private suspend fun writeUnwrittenLines() {
+        fileLock.withLock {
+            val batch = lock.withLock { unwritten.toList().also { unwritten.clear() } }
+            logFile.append(batch)
         }
     }
 
@@ -81,18 +122,14 @@ class AppLogger(
             tag: String,
             throwable: Throwable?,
         ) {
-            CoroutineScope(backgroundContext).launch {
-                val logMessage =
-                    "${LocalDateTime.now().logFormat()} : ${severity.name.uppercase()} : $message"
-                log.update { lines ->
-                    (lines + logMessage).takeLast(MAX_LINES)
-                }
-            }
+            pending.trySend("${LocalDateTime.now().logFormat()} : ${severity.name.uppercase()} : $message")
         }
     }
 
     companion object {
         val FILE_PATH = "Log/logger.txt".toPath()
         private const val MAX_LINES = 10_000
+        private val WRITE_INTERVAL = 5.seconds
+        private val READ_INTERVAL = 250.milliseconds
     }
 }
@@ -18,7 +18,6 @@ import okio.Path
 import ooniprobe.composeapp.generated.resources.Measurement_Raw_Share
 import ooniprobe.composeapp.generated.resources.Res
 import org.jetbrains.compose.resources.getString
-import org.ooni.probe.data.disk.ReadFile
 import org.ooni.probe.data.models.MeasurementModel
 import org.ooni.probe.data.models.MeasurementWithUrl
 import org.ooni.probe.data.models.PlatformAction
@@ -29,7 +28,8 @@ class MeasurementRawViewModel(
     goToUpload: (MeasurementModel.Id) -> Unit,
     goToMeasurement: (MeasurementModel.Id) -> Unit,
     getMeasurement: (MeasurementModel.Id) -> Flow<MeasurementWithUrl?>,
-    readFile: ReadFile,
+    readReport: suspend (MeasurementModel) -> String?,
+    exportReport: suspend (MeasurementModel) -> Path?,
     shareFile: (PlatformAction.FileSharing) -> Unit,
 ) : ViewModel() {
     private val events = MutableSharedFlow<Event>(extraBufferCapacity = 1)
@@ -55,18 +55,16 @@ class MeasurementRawViewModel(
             .filterNotNull()
             .take(1)
             .onEach { item ->
-                item.measurement.reportFilePath?.let { reportFilePath ->
-                    val json = readFile(reportFilePath)
-                    val jsonPretty = json?.let {
-                        val jsonSerializer = Json { prettyPrint = true }
-                        jsonSerializer.encodeToString(jsonSerializer.parseToJsonElement(it))
-                    }
-                    _state.update {
-                        it.copy(
-                            reportFilePath = reportFilePath,
-                            json = jsonPretty,
-                        )
-                    }
+                val json = readReport(item.measurement)
+                val jsonPretty = json?.let {
+                    val jsonSerializer = Json { prettyPrint = true }
+                    jsonSerializer.encodeToString(jsonSerializer.parseToJsonElement(it))
+                }
+                _state.update {
+                    it.copy(
+                        measurement = item.measurement,
+                        json = jsonPretty,
+                    )
                 }
             }.launchIn(viewModelScope)
 
@@ -83,11 +81,14 @@ class MeasurementRawViewModel(
         events
             .filterIsInstance<Event.ShareClicked>()
             .onEach {
-                _state.value.reportFilePath?.let {
-                    shareFile(
-                        PlatformAction.FileSharing(getString(Res.string.Measurement_Raw_Share), it),
-                    )
-                }
+                // Reports are stored compressed, so a copy is written to a file to share it
+                _state.value.measurement
+                    ?.let { exportReport(it) }
+                    ?.let {
+                        shareFile(
+                            PlatformAction.FileSharing(getString(Res.string.Measurement_Raw_Share), it),
+                        )
+                    }
             }.launchIn(viewModelScope)
     }
 
@@ -97,7 +98,7 @@ class MeasurementRawViewModel(
 
     data class State(
         val json: String? = null,
-        val reportFilePath: Path? = null,
+        val measurement: MeasurementModel? = null,
     )
 
     sealed interface Event {
@@ -30,6 +30,7 @@ import androidx.compose.material3.TopAppBarDefaults
 import androidx.compose.material3.TriStateCheckbox
 import androidx.compose.material3.VerticalDivider
 import androidx.compose.runtime.Composable
+import androidx.compose.runtime.LaunchedEffect
 import androidx.compose.runtime.getValue
 import androidx.compose.runtime.mutableStateOf
 import androidx.compose.runtime.remember
@@ -63,7 +64,6 @@ import ooniprobe.composeapp.generated.resources.Modal_DoYouWantToDeleteAllTests
 import ooniprobe.composeapp.generated.resources.Modal_DoYouWantToDeleteSomeTests
 import ooniprobe.composeapp.generated.resources.Modal_Selected
 import ooniprobe.composeapp.generated.resources.Res
-import ooniprobe.composeapp.generated.resources.Results_LimitedNotice
 import ooniprobe.composeapp.generated.resources.Results_MarkAllAsViewed
 import ooniprobe.composeapp.generated.resources.Results_MarkAllAsViewed_Confirmation
 import ooniprobe.composeapp.generated.resources.Results_MarkAllAsViewed_Filtered_Confirmation
@@ -420,19 +420,20 @@ private fun Results(
                     }
                 }
             }
-            if (state.areResultsLimited) {
-                item("limited") {
-                    Text(
-                        text = stringResource(
-                            Res.string.Results_LimitedNotice,
-                            state.filter.limit,
-                        ),
-                        style = MaterialTheme.typography.labelLarge,
-                        textAlign = TextAlign.Center,
+            if (state.canLoadMore) {
+                item("loadMore") {
+                    // Reaching the end of the list loads the next page
+                    LaunchedEffect(state.lastResultCursor) {
+                        onEvent(ResultsViewModel.Event.LoadMore)
+                    }
+                    Box(
+                        contentAlignment = Alignment.Center,
                         modifier = Modifier
                             .fillMaxWidth()
                             .padding(horizontal = 16.dp, vertical = 24.dp),
-                    )
+                    ) {
+                        CircularProgressIndicator()
+                    }
                 }
             }
         }
@@ -5,6 +5,7 @@ import androidx.lifecycle.viewModelScope
 import kotlinx.coroutines.flow.Flow
 import kotlinx.coroutines.flow.MutableSharedFlow
 import kotlinx.coroutines.flow.MutableStateFlow
+import kotlinx.coroutines.flow.SharingStarted
 import kotlinx.coroutines.flow.asStateFlow
 import kotlinx.coroutines.flow.combine
 import kotlinx.coroutines.flow.distinctUntilChanged
@@ -13,19 +14,23 @@ import kotlinx.coroutines.flow.flatMapLatest
 import kotlinx.coroutines.flow.launchIn
 import kotlinx.coroutines.flow.map
 import kotlinx.coroutines.flow.onEach
+import kotlinx.coroutines.flow.shareIn
 import kotlinx.coroutines.flow.update
 import kotlinx.datetime.LocalDate
 import org.ooni.probe.data.models.DescriptorItem
 import org.ooni.probe.data.models.NetworkModel
+import org.ooni.probe.data.models.PageCursor
 import org.ooni.probe.data.models.ResultFilter
 import org.ooni.probe.data.models.ResultListItem
 import org.ooni.probe.data.models.ResultModel
+import org.ooni.probe.data.models.ResultsPage
 import org.ooni.probe.data.models.ResultsStats
 
 class ResultsViewModel(
     goToResult: (ResultModel.Id) -> Unit,
     goToUpload: () -> Unit,
-    getResults: (ResultFilter) -> Flow<List<ResultListItem>>,
+    getResults: (ResultFilter, ResultsPage) -> Flow<List<ResultListItem>>,
+    getNextPageEnd: suspend (ResultFilter, PageCursor) -> PageCursor?,
     getResultsStats: (ResultFilter) -> Flow<ResultsStats>,
     getDescriptors: () -> Flow<List<DescriptorItem>>,
     getNetworks: () -> Flow<List<NetworkModel>>,
@@ -38,17 +43,24 @@ class ResultsViewModel(
     private val _state = MutableStateFlow(State())
     val state = _state.asStateFlow()
 
+    // Shared so loading another page keeps listening to the pages already loaded
+    private val pageResults = mutableMapOf<Pair<ResultFilter, ResultsPage>, Flow<List<ResultListItem>>>()
+
     init {
         state
-            .map { it.filter }
+            .map { it.filter to it.pages }
             .distinctUntilChanged()
-            .flatMapLatest {
+            .flatMapLatest { (filter, pages) ->
+                pageResults.keys.retainAll { (pageFilter, page) -> pageFilter == filter && page in pages }
                 combine(
-                    getResults(it),
-                    getResultsStats(it),
-                    ::Pair,
-                )
-            }.onEach { (results, stats) ->
+                    pages.map { page ->
+                        pageResults.getOrPut(filter to page) {
+                            getResults(filter, page)
+                                .shareIn(viewModelScope, SharingStarted.WhileSubscribed(PAGE_STOP_TIMEOUT), replay = 1)
+                        }
+                    },
+                ) { it.toList().flatten() }
+            }.onEach { results ->
                 val previousRuns = _state.value.results.values
                     .flatten()
                 val newRuns = previousRuns.updateWithNewResults(results)
@@ -56,13 +68,27 @@ class ResultsViewModel(
                 _state.update { state ->
                     state.copy(
                         results = newRunsByDate,
-                        stats = stats,
                         isLoading = false,
-                        markAllAsViewedEnabled = results.any { !it.result.isViewed },
+                        isLoadingMore = false,
+                        // A full page means there might be more results after it
+                        canLoadMore = state.hasMorePages &&
+                            (state.pages.size > 1 || results.size >= ResultFilter.PAGE_SIZE),
                     )
                 }
             }.launchIn(viewModelScope)
 
+        state
+            .map { it.filter }
+            .distinctUntilChanged()
+            .flatMapLatest { getResultsStats(it) }
+            .onEach { stats ->
+                _state.update {
+                    // Counted over the whole filter, not only the pages loaded so far
+                    it.copy(stats = stats, markAllAsViewedEnabled = stats.notViewed > 0)
+                }
+            }
+            .launchIn(viewModelScope)
+
         getDescriptors()
             .onEach { descriptors -> _state.update { it.copy(descriptors = descriptors) } }
             .launchIn(viewModelScope)
@@ -104,8 +130,41 @@ class ResultsViewModel(
 
         events
             .filterIsInstance<Event.FilterChanged>()
-            .onEach { event -> _state.update { it.copy(filter = event.filter) } }
-            .launchIn(viewModelScope)
+            .onEach { event ->
+                _state.update {
+                    it.copy(
+                        filter = event.filter,
+                        pages = listOf(ResultsPage()),
+                        hasMorePages = true,
+                        canLoadMore = false,
+                    )
+                }
+            }.launchIn(viewModelScope)
+
+        events
+            .filterIsInstance<Event.LoadMore>()
+            .onEach {
+                val state = _state.value
+                if (!state.canLoadMore || state.isLoadingMore) return@onEach
+                val lastCursor = state.lastResultCursor ?: return@onEach
+                _state.update { it.copy(isLoadingMore = true) }
+                val pageEnd = getNextPageEnd(state.filter, lastCursor)
+                _state.update {
+                    // The filter might have changed while we were fetching the next page
+                    if (it.filter != state.filter) return@update it
+                    if (pageEnd == null) {
+                        it.copy(hasMorePages = false, canLoadMore = false, isLoadingMore = false)
+                    } else {
+                        // Close the open page at its current end, so new results don't push
+                        // older ones into the next page, and add the next page after it
+                        it.copy(
+                            pages = it.pages.dropLast(1) +
+                                it.pages.last().copy(until = lastCursor) +
+                                ResultsPage(after = lastCursor, until = pageEnd),
+                        )
+                    }
+                }
+            }.launchIn(viewModelScope)
 
         events
             .filterIsInstance<Event.ChangeItemSelection>()
@@ -153,6 +212,11 @@ class ResultsViewModel(
 
     data class State(
         val filter: ResultFilter = ResultFilter(),
+        // Pages loaded so far, the last one is open-ended until there's a next one
+        val pages: List<ResultsPage> = listOf(ResultsPage()),
+        val hasMorePages: Boolean = true,
+        val canLoadMore: Boolean = false,
+        val isLoadingMore: Boolean = false,
         val descriptors: List<DescriptorItem> = emptyList(),
         val networks: List<NetworkModel> = emptyList(),
         val results: Map<LocalDate, List<RunListItem>> = emptyMap(),
@@ -163,7 +227,10 @@ class ResultsViewModel(
     ) {
         private val allRuns get() = results.values.flatten()
         private val allResultItems get() = allRuns.flatMap { it.results }
-        val areResultsLimited get() = allResultItems.size >= ResultFilter.LIMIT
+        val lastResultCursor
+            get() = allResultItems
+                .mapNotNull { it.item.pageCursor }
+                .minWithOrNull(compareBy<PageCursor> { it.startTime }.thenBy { it.id })
         val anyMissingUpload get() = allResultItems.any { !it.item.allMeasurementsUploaded }
         val areAllSelected get() = allResultItems.all { it.isSelected }
         val isAnySelected get() = allResultItems.any { it.isSelected }
@@ -195,5 +262,11 @@ class ResultsViewModel(
         data class FilterChanged(
             val filter: ResultFilter,
         ) : Event
+
+        data object LoadMore : Event
+    }
+
+    companion object {
+        private const val PAGE_STOP_TIMEOUT = 5_000L
     }
 }
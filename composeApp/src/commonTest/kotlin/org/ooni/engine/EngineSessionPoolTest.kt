@@ -0,0 +1,125 @@
+package org.ooni.engine
+
+import kotlinx.coroutines.CompletableDeferred
+import kotlinx.coroutines.async
+import kotlinx.coroutines.test.TestScope
+import kotlinx.coroutines.test.advanceTimeBy
+import kotlinx.coroutines.test.runCurrent
+import kotlinx.coroutines.test.runTest
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFailsWith
+import kotlin.time.Duration.Companion.minutes
+
+class EngineSessionPoolTest {
+    private val bridge = TestOonimkallBridge()
+
+    // Idle sessions expire on the virtual time of the test
+    private fun TestScope.buildSubject() =
+        EngineSessionPool(
+            newSession = bridge::newSession,
+            scope = backgroundScope,
+            maxIdlePerConfig = 2,
+            idleTimeout = 5.minutes,
+            timeSource = testScheduler.timeSource,
+        )
+
+    @Test
+    fun reusesSessionForSequentialRequests() =
+        runTest {
+            val subject = buildSubject()
+            repeat(3) { subject.use(CONFIG) { } }
+
+            assertEquals(1, bridge.newSessionCount)
+            assertEquals(0, bridge.closedSessionCount)
+        }
+
+    @Test
+    fun keysSessionsOnConfig() =
+        runTest {
+            val subject = buildSubject()
+            subject.use(CONFIG) { }
+            subject.use(CONFIG.copy(proxy = "psiphon://")) { }
+            subject.use(CONFIG) { }
+
+            assertEquals(2, bridge.newSessionCount)
+        }
+
+    @Test
+    fun concurrentRequestsUseDifferentSessions() =
+        runTest {
+            val subject = buildSubject()
+            val canFinish = CompletableDeferred<Unit>()
+            val sessions = List(3) {
+                async { subject.use(CONFIG) { session -> session.also { canFinish.await() } } }
+            }
+            runCurrent()
+            canFinish.complete(Unit)
+
+            assertEquals(3, sessions.map { it.await() }.toSet().size)
+            // Only 2 are kept idle
+            assertEquals(1, bridge.closedSessionCount)
+
+            subject.use(CONFIG) { }
+            assertEquals(3, bridge.newSessionCount)
+        }
+
+    @Test
+    fun discardsSessionAfterFailure() =
+        runTest {
+            val subject = buildSubject()
+            assertFailsWith<IllegalStateException> {
+                subject.use(CONFIG) { throw IllegalStateException() }
+            }
+            assertEquals(1, bridge.closedSessionCount)
+
+            subject.use(CONFIG) { }
+            assertEquals(2, bridge.newSessionCount)
+        }
+
+    @Test
+    fun closesIdleSessionsAfterTimeout() =
+        runTest {
+            val subject = buildSubject()
+            subject.use(CONFIG) { }
+            advanceTimeBy(4.minutes)
+            subject.use(CONFIG.copy(proxy = "psiphon://")) { }
+
+            advanceTimeBy(2.minutes)
+            // Without any other request
+            assertEquals(1, bridge.closedSessionCount)
+
+            advanceTimeBy(4.minutes)
+            assertEquals(2, bridge.closedSessionCount)
+
+            subject.use(CONFIG) { }
+            assertEquals(3, bridge.newSessionCount)
+        }
+
+    @Test
+    fun closeAll() =
+        runTest {
+            val subject = buildSubject()
+            subject.use(CONFIG) { }
+            subject.use(CONFIG.copy(proxy = "psiphon://")) { }
+            subject.closeAll()
+
+            assertEquals(2, bridge.closedSessionCount)
+        }
+
+    companion object {
+        private val CONFIG = OonimkallBridge.SessionConfig(
+            softwareName = "ooniprobe-test",
+            softwareVersion = "1",
+            proxy = null,
+            probeServicesURL = "https://api.ooni.io",
+            assetsDir = "",
+            geoIpDB = null,
+            stateDir = "",
+            tempDir = "",
+            tunnelDir = "",
+            logger = null,
+            verbose = false,
+        )
+    }
+}
@@ -0,0 +1,49 @@
+package org.ooni.engine
+
+import kotlinx.coroutines.CompletableDeferred
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.test.runCurrent
+import kotlinx.coroutines.test.runTest
+import kotlin.test.Test
+import kotlin.test.assertEquals
+
+class EngineTaskDispatcherTest {
+    @Test
+    fun queuesTasksBeyondParallelism() =
+        runTest {
+            val dispatcher = EngineTaskDispatcher(parallelism = 1, dispatcher = Dispatchers.Default)
+            val firstCanFinish = CompletableDeferred<Unit>()
+
+            launch { dispatcher.withSlot { firstCanFinish.await() } }
+            launch { dispatcher.withSlot { } }
+            runCurrent()
+
+            dispatcher.metrics.value.let {
+                assertEquals(1, it.active)
+                assertEquals(1, it.queued)
+                assertEquals(1, it.started)
+            }
+
+            firstCanFinish.complete(Unit)
+            runCurrent()
+
+            dispatcher.metrics.value.let {
+                assertEquals(0, it.active)
+                assertEquals(0, it.queued)
+                assertEquals(2, it.started)
+            }
+        }
+
+    @Test
+    fun releasesSlotWhenTaskFails() =
+        runTest {
+            val dispatcher = EngineTaskDispatcher(parallelism = 1, dispatcher = Dispatchers.Default)
+
+            runCatching { dispatcher.withSlot { throw IllegalStateException() } }
+            dispatcher.withSlot { }
+
+            assertEquals(0, dispatcher.metrics.value.active)
+            assertEquals(2, dispatcher.metrics.value.started)
+        }
+}
@@ -5,6 +5,7 @@ import kotlinx.coroutines.flow.toList
 import kotlinx.coroutines.test.runTest
 import org.ooni.engine.models.EnginePreferences
 import org.ooni.engine.models.Failure
+import org.ooni.engine.models.NetworkSnapshot
 import org.ooni.engine.models.NetworkType
 import org.ooni.engine.models.TaskEvent
 import org.ooni.engine.models.TaskLogLevel
@@ -53,6 +54,41 @@ class EngineTest {
             assertEquals(NetworkType.NoInternet, settings.annotations.networkType)
         }
 
+    @Test
+    fun startTaskAnnotatesNetworkSnapshot() =
+        runTest {
+            val bridge = TestOonimkallBridge()
+            bridge.addNextEvents("""{"key":"status.started","value":{}}""")
+            val snapshotFinder = object : NetworkTypeFinder {
+                override fun invoke() = NetworkType.VPN
+
+                override fun snapshot() =
+                    NetworkSnapshot(
+                        networkType = NetworkType.VPN,
+                        interfaceName = "wg0",
+                        mtu = 1420,
+                        hasIpv6DefaultRoute = false,
+                        vpnKind = NetworkSnapshot.VpnKind.WireGuard,
+                    )
+            }
+            val engine = buildEngine(bridge, snapshotFinder)
+
+            engine
+                .startTask(
+                    NetTest(test = TestType.WebConnectivity),
+                    taskOrigin = TaskOrigin.AutoRun,
+                    descriptorId = Descriptor.Id(OoniTest.Websites.id),
+                ).toList()
+
+            val annotations =
+                json.decodeFromString<TaskSettings>(bridge.lastStartTaskSettingsSerialized!!).annotations
+            assertEquals(NetworkType.VPN, annotations.networkType)
+            assertEquals("wireguard", annotations.networkVpnKind)
+            assertEquals("1420", annotations.networkMtu)
+            assertEquals("false", annotations.networkIpv6DefaultRoute)
+            assertEquals(null, annotations.networkMetered)
+        }
+
     @Test
     fun httpDoWithException() =
         runTest {
@@ -67,8 +103,10 @@ class EngineTest {
             assertEquals(exception, result.reason.cause)
         }
 
-    private fun buildEngine(bridge: OonimkallBridge) =
-        Engine(
+    private fun buildEngine(
+        bridge: OonimkallBridge,
+        networkTypeFinder: NetworkTypeFinder = this.networkTypeFinder,
+    ) = Engine(
             bridge = bridge,
             json = json,
             baseFilePath = "",
@@ -96,5 +134,6 @@ class EngineTest {
             },
             addRunCancelListener = { CancelListenerCallback {} },
             backgroundContext = Dispatchers.Unconfined,
+            taskDispatcher = EngineTaskDispatcher(dispatcher = Dispatchers.Default),
         )
 }
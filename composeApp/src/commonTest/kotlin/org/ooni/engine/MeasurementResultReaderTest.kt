@@ -0,0 +1,49 @@
+package org.ooni.engine
+
+import org.ooni.probe.di.Dependencies
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFailsWith
+import kotlin.test.assertNull
+
+class MeasurementResultReaderTest {
+    private val subject = MeasurementResultReader(Dependencies.buildJson())
+
+    @Test
+    fun readsKeptFields() {
+        val result = subject(
+            """{"annotations":{"os":"android"},"input":"https://ooni.org","probe_asn":"AS1","probe_cc":"PT","test_runtime":1.5,"test_keys":{"requests":[{"request":{"body":"}]\"{"},"failure":null}],"queries":[],"blocking":"dns","accessible":false,"summary":{"ping":12.5},"tampering":{"header_field_name":false,"total":true}},"report_id":"r1"}""",
+        )
+
+        assertEquals("https://ooni.org", result.input)
+        assertEquals("AS1", result.probeAsn)
+        assertEquals("PT", result.probeCountryCode)
+        assertEquals(1.5, result.testRuntime)
+        assertEquals("r1", result.reportId)
+        assertEquals("dns", result.testKeys?.blocking)
+        assertEquals(12.5, result.testKeys?.summary?.ping)
+        assertEquals(true, result.testKeys?.tampering?.value)
+    }
+
+    @Test
+    fun nullTestKeys() {
+        val result = subject("""{"input":null,"test_keys":null}""")
+
+        assertNull(result.input)
+        assertNull(result.testKeys)
+    }
+
+    @Test
+    fun emptyTestKeys() {
+        val result = subject("""{"test_keys":{"requests":[]}}""")
+
+        assertNull(result.testKeys?.blocking)
+    }
+
+    @Test
+    fun malformed() {
+        assertFailsWith<IllegalArgumentException> {
+            subject("""{"input":"https://ooni.org","test_keys":{"blocking":""")
+        }
+    }
+}
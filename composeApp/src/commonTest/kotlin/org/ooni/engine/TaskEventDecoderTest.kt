@@ -0,0 +1,76 @@
+package org.ooni.engine
+
+import kotlinx.serialization.SerializationException
+import org.ooni.probe.di.Dependencies
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFailsWith
+import kotlin.test.assertNull
+
+class TaskEventDecoderTest {
+    private val subject = TaskEventDecoder(Dependencies.buildJson())
+
+    @Test
+    fun measurement() {
+        val result = subject(
+            """{"key":"measurement","value":{"idx":3,"input":"https://ooni.org","json_str":"{\"input\":\"https://ooni.org\",\"test_keys\":{\"blocking\":false}}"}}""",
+        )
+
+        assertEquals("measurement", result.key)
+        assertEquals(3, result.value?.idx)
+        assertEquals(
+            """{"input":"https://ooni.org","test_keys":{"blocking":false}}""",
+            result.value?.jsonStr,
+        )
+        // Fields we don't need are skipped
+        assertNull(result.value?.input)
+    }
+
+    @Test
+    fun measurementWithEscapes() {
+        val result = subject(
+            """{ "key" : "measurement", "value" : { "json_str" : "{\"body\":\"a\\\"b\\n\u00e9 😀\"}", "idx" : 1 } }""",
+        )
+
+        assertEquals(1, result.value?.idx)
+        // Escapes inside the measurement itself are kept as they are
+        assertEquals("""{"body":"a\"b\né 😀"}""", result.value?.jsonStr)
+    }
+
+    @Test
+    fun measurementSkipsNestedFields() {
+        val result = subject(
+            """{"key":"measurement","value":{"extra":{"list":[1,"}]",{"a":null}],"b":true},"flag":false,"idx":2,"json_str":"{}"}}""",
+        )
+
+        assertEquals(2, result.value?.idx)
+        assertEquals("{}", result.value?.jsonStr)
+    }
+
+    @Test
+    fun otherEvents() {
+        val result = subject(
+            """{"key":"status.progress","value":{"message":"contacted bouncer","percentage":0.1}}""",
+        )
+
+        assertEquals("status.progress", result.key)
+        assertEquals("contacted bouncer", result.value?.message)
+        assertEquals(0.1, result.value?.percentage)
+    }
+
+    @Test
+    fun valueBeforeKeyFallsBack() {
+        val result = subject("""{"value":{"idx":4,"json_str":"{}"},"key":"measurement"}""")
+
+        assertEquals("measurement", result.key)
+        assertEquals(4, result.value?.idx)
+        assertEquals("{}", result.value?.jsonStr)
+    }
+
+    @Test
+    fun malformed() {
+        assertFailsWith<SerializationException> {
+            subject("""{"key":"measurement","value":{"idx":""")
+        }
+    }
+}
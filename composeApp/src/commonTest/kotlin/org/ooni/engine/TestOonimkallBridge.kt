@@ -18,6 +18,12 @@ class TestOonimkallBridge : OonimkallBridge {
     var lastSessionConfig: OonimkallBridge.SessionConfig? = null
         private set
 
+    var newSessionCount = 0
+        private set
+
+    var closedSessionCount = 0
+        private set
+
     var submitMeasurementMock: ((String) -> OonimkallBridge.SubmitMeasurementResults)? = null
     var httpDoMock: ((OonimkallBridge.HTTPRequest) -> OonimkallBridge.HTTPResponse)? = null
 
@@ -36,6 +42,7 @@ class TestOonimkallBridge : OonimkallBridge {
 
     override fun newSession(sessionConfig: OonimkallBridge.SessionConfig): OonimkallBridge.Session {
         lastSessionConfig = sessionConfig
+        newSessionCount++
         return Session()
     }
 
@@ -44,6 +51,8 @@ class TestOonimkallBridge : OonimkallBridge {
 
         override fun httpDo(request: OonimkallBridge.HTTPRequest): OonimkallBridge.HTTPResponse = httpDoMock!!(request)
 
-        override fun close() {}
+        override fun close() {
+            closedSessionCount++
+        }
     }
 }
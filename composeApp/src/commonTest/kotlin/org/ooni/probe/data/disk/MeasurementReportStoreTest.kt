@@ -0,0 +1,132 @@
+package org.ooni.probe.data.disk
+
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.test.runTest
+import okio.FileSystem
+import okio.SYSTEM
+import org.ooni.probe.data.models.MeasurementModel
+import org.ooni.testing.factories.MeasurementModelFactory
+import kotlin.test.AfterTest
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertNotNull
+import kotlin.test.assertNull
+import kotlin.test.assertTrue
+import kotlin.time.Clock
+import kotlin.time.Duration.Companion.days
+import kotlin.time.Instant
+
+class MeasurementReportStoreTest {
+    private val fileSystem = FileSystem.SYSTEM
+    private val baseFilesDir = FileSystem.SYSTEM_TEMPORARY_DIRECTORY.resolve("ooni_reports")
+    private val segmentsDir = baseFilesDir.resolve(MeasurementReportStore.SEGMENTS_PATH)
+
+    private var now = Clock.System.now()
+    private val clock = object : Clock {
+        override fun now(): Instant = now
+    }
+
+    private val subject = MeasurementReportStore(
+        fileSystem = fileSystem,
+        baseFileDir = baseFilesDir.toString(),
+        backgroundContext = Dispatchers.Default,
+        maxSegmentBytes = 1024,
+        clock = clock,
+    )
+
+    @AfterTest
+    fun tearDown() {
+        fileSystem.deleteRecursively(baseFilesDir)
+    }
+
+    @Test
+    fun writeAndRead() =
+        runTest {
+            val reports = (1..3).map { """{"index":$it,"test_keys":{"${"a".repeat(it * 100)}":true}}""" }
+
+            val measurements = reports.mapIndexed { index, report ->
+                val location = assertNotNull(subject.write(report))
+                MeasurementModelFactory.build(
+                    id = MeasurementModel.Id(index.toLong()),
+                    reportLocation = location,
+                )
+            }
+
+            measurements.zip(reports).forEach { (measurement, report) ->
+                assertEquals(report, subject.read(measurement))
+            }
+            // All reports are in the same segment, compressed
+            assertEquals(1, measurements.map { it.reportLocation?.segment }.toSet().size)
+            assertTrue(
+                fileSystem.list(segmentsDir).sumOf { fileSystem.metadata(it).size ?: 0L } <
+                    reports.sumOf { it.length.toLong() },
+            )
+        }
+
+    @Test
+    fun startsNewSegmentWhenFull() =
+        runTest {
+            // Random content doesn't compress, so each report takes a good part of a segment
+            val locations = (1..4).map {
+                subject.write(randomReport(500))
+            }
+
+            assertEquals(listOf(1L, 1L, 2L, 2L), locations.map { it?.segment })
+            assertEquals(0L, locations[2]?.offset)
+            assertEquals(locations[0]?.length, locations[1]?.offset)
+        }
+
+    @Test
+    fun compactDeletesSegmentsNotInUse() =
+        runTest {
+            val locations = (1..6).map { subject.write(randomReport(500)) }
+            assertEquals(3, fileSystem.list(segmentsDir).size)
+
+            // Segments just written could still be in use by a running test
+            subject.compact(liveSegments = emptySet())
+            assertEquals(3, fileSystem.list(segmentsDir).size)
+
+            now += 1.days
+            subject.compact(liveSegments = setOf(2L))
+
+            // The active segment is kept
+            assertEquals(listOf("2.seg", "3.seg"), fileSystem.list(segmentsDir).map { it.name }.sorted())
+            val measurement = MeasurementModelFactory.build(
+                id = MeasurementModel.Id(1),
+                reportLocation = locations[2],
+            )
+            assertNotNull(subject.read(measurement))
+        }
+
+    @Test
+    fun readsAndDeletesLegacyReportFile() =
+        runTest {
+            val measurement = MeasurementModelFactory.build(id = MeasurementModel.Id(1))
+            val path = baseFilesDir.resolve(measurement.reportFilePath!!)
+            fileSystem.createDirectories(path.parent!!)
+            fileSystem.write(path) { writeUtf8("{}") }
+
+            assertEquals("{}", subject.read(measurement))
+            assertEquals(measurement.reportFilePath, subject.export(measurement))
+
+            subject.delete(measurement)
+            assertFalse(fileSystem.exists(path))
+            assertNull(subject.read(measurement))
+        }
+
+    @Test
+    fun exportWritesReportToFile() =
+        runTest {
+            val measurement = MeasurementModelFactory.build(
+                id = MeasurementModel.Id(1),
+                reportLocation = subject.write("{\"a\":1}"),
+            )
+
+            val exported = assertNotNull(subject.export(measurement))
+
+            assertEquals("{\"a\":1}", fileSystem.read(baseFilesDir.resolve(exported)) { readUtf8() })
+        }
+
+    private fun randomReport(length: Int) = (1..length).map { ('!'..'~').random() }.joinToString("")
+}
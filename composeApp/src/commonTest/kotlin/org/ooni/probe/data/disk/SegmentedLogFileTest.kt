@@ -0,0 +1,82 @@
+package org.ooni.probe.data.disk
+
+import kotlinx.coroutines.test.runTest
+import okio.FileSystem
+import okio.Path.Companion.toPath
+import okio.SYSTEM
+import kotlin.test.AfterTest
+import kotlin.test.Test
+import kotlin.test.assertEquals
+
+class SegmentedLogFileTest {
+    private val fileSystem = FileSystem.SYSTEM
+    private val baseFilesDir = FileSystem.SYSTEM_TEMPORARY_DIRECTORY.resolve("ooni-log")
+    private val activePath = "Log/logger.txt".toPath()
+
+    @AfterTest
+    fun tearDown() {
+        fileSystem.deleteRecursively(baseFilesDir)
+    }
+
+    @Test
+    fun appendAndReadLastLines() =
+        runTest {
+            val logFile = buildLogFile()
+            logFile.append(listOf("one", "two"))
+            logFile.append(listOf("three"))
+
+            assertEquals(listOf("two", "three"), logFile.readLastLines(2))
+            assertEquals(listOf("one", "two", "three"), logFile.readLastLines(10))
+        }
+
+    @Test
+    fun rotatesSegmentsAndDropsTheOldest() =
+        runTest {
+            // Each line is 6 bytes with the new line, so every segment holds 2 lines
+            val logFile = buildLogFile(maxSegmentBytes = 10, maxSegments = 3)
+            (1..9).forEach { logFile.append(listOf("line$it")) }
+
+            assertEquals(3, logFile.segments().size)
+            assertEquals(listOf("line5", "line6", "line7", "line8", "line9"), logFile.readLastLines(10))
+            assertEquals(listOf("line9"), logFile.readLastLines(1))
+        }
+
+    @Test
+    fun exportConcatenatesSegments() =
+        runTest {
+            val logFile = buildLogFile(maxSegmentBytes = 10, maxSegments = 3)
+            (1..3).forEach { logFile.append(listOf("line$it")) }
+
+            val exported = logFile.export()
+
+            assertEquals("Log/logger-export.txt".toPath(), exported)
+            assertEquals("line1\nline2\nline3\n", fileSystem.read(baseFilesDir.resolve(exported)) { readUtf8() })
+        }
+
+    @Test
+    fun exportWithSingleSegmentUsesTheActiveFile() =
+        runTest {
+            val logFile = buildLogFile()
+
+            assertEquals(activePath, logFile.export())
+            logFile.append(listOf("line"))
+            assertEquals(activePath, logFile.export())
+        }
+
+    @Test
+    fun clear() =
+        runTest {
+            val logFile = buildLogFile(maxSegmentBytes = 10, maxSegments = 3)
+            (1..5).forEach { logFile.append(listOf("line$it")) }
+            logFile.clear()
+
+            assertEquals(emptyList(), logFile.segments())
+            logFile.append(listOf("again"))
+            assertEquals(listOf("again"), logFile.readLastLines(10))
+        }
+
+    private fun buildLogFile(
+        maxSegmentBytes: Long = 1024,
+        maxSegments: Int = 4,
+    ) = SegmentedLogFile(fileSystem, baseFilesDir.toString(), activePath, maxSegmentBytes, maxSegments)
+}
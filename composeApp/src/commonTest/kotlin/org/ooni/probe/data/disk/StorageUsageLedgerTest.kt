@@ -0,0 +1,159 @@
+package org.ooni.probe.data.disk
+
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.test.runTest
+import okio.FileSystem
+import okio.Path.Companion.toPath
+import okio.SYSTEM
+import org.ooni.probe.di.Dependencies
+import kotlin.test.AfterTest
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertTrue
+import kotlin.time.Clock
+import kotlin.time.Duration.Companion.days
+import kotlin.time.Instant
+
+class StorageUsageLedgerTest {
+    private val fileSystem = FileSystem.SYSTEM
+    private val testDir = FileSystem.SYSTEM_TEMPORARY_DIRECTORY.resolve("ooni_ledger")
+    private val baseFilesDir = testDir.resolve("files")
+    private val cacheDir = testDir.resolve("cache")
+    private val ledgerPath = testDir.resolve("storage_usage.json")
+
+    private var now = Instant.fromEpochSeconds(1_000_000)
+    private val clock = object : Clock {
+        override fun now() = now
+    }
+
+    private fun buildLedger() =
+        StorageUsageLedger(
+            fileSystem = fileSystem,
+            roots = listOf(baseFilesDir, cacheDir),
+            ledgerPath = ledgerPath,
+            json = Dependencies.buildJson(),
+            backgroundContext = Dispatchers.Default,
+            clock = clock,
+        )
+
+    private val ledger = buildLedger()
+    private val deleteFiles = DeleteFilesOkio(fileSystem, baseFilesDir.toString(), Dispatchers.Default, ledger)
+
+    @AfterTest
+    fun tearDown() {
+        fileSystem.deleteRecursively(testDir)
+    }
+
+    @Test
+    fun tracksWritesAndDeletes() =
+        runTest {
+            writeFile("a.txt", "hello")
+            assertEquals(5, ledger.total.value)
+
+            writeFile("a.txt", "hi")
+            writeFile("dir/b.txt", "world")
+            writeFile("dir/nested/c.txt", "!!")
+            assertEquals(9, ledger.total.value)
+
+            deleteFiles("dir/nested".toPath())
+            assertEquals(7, ledger.total.value)
+
+            deleteFiles("dir".toPath())
+            assertEquals(2, ledger.total.value)
+        }
+
+    @Test
+    fun deletingAFolderInsideARootDropsItsTotal() =
+        runTest {
+            writeFile("dir/b.txt", "world")
+            // Not tracked, so the folder total doesn't include it
+            fileSystem.write(baseFilesDir.resolve("dir/untracked.txt")) { writeUtf8("0123456789") }
+            writeFile("a.txt", "hi")
+
+            deleteFiles("dir".toPath())
+
+            assertEquals(2, ledger.total.value)
+            ledger.reconcile()
+            assertEquals(2, ledger.total.value)
+        }
+
+    @Test
+    fun deletingARootDropsEverythingInIt() =
+        runTest {
+            writeFile("a.txt", "hello")
+            writeFile("dir/b.txt", "world")
+
+            deleteFiles("".toPath())
+
+            assertEquals(0, ledger.total.value)
+        }
+
+    @Test
+    fun tracksSegmentedLog() =
+        runTest {
+            val logFile = SegmentedLogFile(
+                fileSystem = fileSystem,
+                baseFileDir = baseFilesDir.toString(),
+                activePath = "Log/logger.txt".toPath(),
+                maxSegmentBytes = 10,
+                maxSegments = 2,
+                storageLedger = ledger,
+            )
+
+            // Each line is 6 bytes with the new line, so a segment is rotated every 2 lines
+            // and the first one is dropped when the second is rotated
+            (1..5).forEach { logFile.append(listOf("line$it")) }
+            assertEquals(18, ledger.total.value)
+
+            logFile.clear()
+            assertEquals(0, ledger.total.value)
+        }
+
+    @Test
+    fun reconcileCountsUntrackedFiles() =
+        runTest {
+            writeFile("a.txt", "hello")
+            fileSystem.createDirectories(cacheDir)
+            fileSystem.write(cacheDir.resolve("engine.db")) { writeUtf8("0123456789") }
+            assertEquals(5, ledger.total.value)
+
+            ledger.reconcile()
+
+            assertEquals(15, ledger.total.value)
+        }
+
+    @Test
+    fun needsReconciliationWhenStale() =
+        runTest {
+            assertTrue(ledger.needsReconciliation())
+
+            ledger.reconcile()
+            assertFalse(ledger.needsReconciliation())
+
+            now += 1.days
+            assertTrue(ledger.needsReconciliation())
+        }
+
+    @Test
+    fun persistsAcrossInstances() =
+        runTest {
+            writeFile("a.txt", "hello")
+            ledger.reconcile()
+
+            val reloaded = buildLedger()
+            assertFalse(reloaded.needsReconciliation())
+            assertEquals(5, reloaded.total.value)
+        }
+
+    private suspend fun writeFile(
+        path: String,
+        contents: String,
+    ) {
+        val absolutePath = baseFilesDir.resolve(path)
+        ledger.track(absolutePath) {
+            absolutePath.parent?.let { fileSystem.createDirectories(it) }
+            fileSystem.write(absolutePath) { writeUtf8(contents) }
+        }
+    }
+}
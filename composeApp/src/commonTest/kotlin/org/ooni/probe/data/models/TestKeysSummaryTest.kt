@@ -0,0 +1,29 @@
+package org.ooni.probe.data.models
+
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertNull
+
+class TestKeysSummaryTest {
+    @Test
+    fun encodeAndDecode() {
+        listOf(
+            TestKeysSummary(),
+            TestKeysSummary(medianBitrate = 230936.0),
+            TestKeysSummary(upload = 6058.42, download = 554105.65, ping = 0.0),
+            TestKeysSummary(medianBitrate = -1.5, upload = 1.0, download = 2.0, ping = 3.0),
+        ).forEach { summary ->
+            val encoded = summary.encode()
+            assertEquals(34, encoded.size)
+            assertEquals(summary, TestKeysSummary.decode(encoded))
+        }
+    }
+
+    @Test
+    fun decodeUnknownVersion() {
+        val encoded = TestKeysSummary(ping = 1.0).encode()
+        encoded[0] = 2
+        assertNull(TestKeysSummary.decode(encoded))
+        assertNull(TestKeysSummary.decode(byteArrayOf(1, 0)))
+    }
+}
@@ -4,11 +4,12 @@ import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.flow.first
 import kotlinx.coroutines.test.runTest
 import org.ooni.passport.models.VerificationStatus
+import org.ooni.probe.Database
 import org.ooni.probe.data.models.MeasurementModel
 import org.ooni.probe.data.models.ResultModel
+import org.ooni.probe.data.models.TestKeysSummary
 import org.ooni.probe.di.Dependencies
 import org.ooni.testing.createTestDatabaseDriver
-import org.ooni.testing.factories.DescriptorFactory
 import org.ooni.testing.factories.MeasurementModelFactory
 import org.ooni.testing.factories.ResultModelFactory
 import kotlin.math.absoluteValue
@@ -19,13 +20,14 @@ import kotlin.test.assertEquals
 import kotlin.test.assertNotNull
 
 class MeasurementRepositoryTest {
+    private lateinit var database: Database
     private lateinit var subject: MeasurementRepository
     private lateinit var resultRepository: ResultRepository
     private val json = Dependencies.buildJson()
 
     @BeforeTest
     fun before() {
-        val database = Dependencies.buildDatabase(::createTestDatabaseDriver)
+        database = Dependencies.buildDatabase(::createTestDatabaseDriver)
         subject = MeasurementRepository(
             database = database,
             backgroundContext = Dispatchers.Default,
@@ -131,31 +133,50 @@ class MeasurementRepositoryTest {
         }
 
     @Test
-    fun selectTestKeys() =
+    fun selectTestKeysByResultIds() =
         runTest {
-            val descriptor = DescriptorFactory.buildDescriptorWithInstalled()
-            val installedDescriptor = descriptor.descriptor
-            val resultId1 = resultRepository.createOrUpdate(
-                ResultModelFactory.build(id = null, descriptorKey = installedDescriptor.key),
-            )
+            val resultId1 = resultRepository.createOrUpdate(ResultModelFactory.build(id = null))
             val resultId2 = resultRepository.createOrUpdate(
                 ResultModelFactory.build(id = null, descriptorName = "circumvention"),
             )
             val model1 = MeasurementModelFactory.build(
                 resultId = resultId1,
-                testKeys = "{\"blocking\":\"true\"}",
+                testKeysSummary = TestKeysSummary(download = 1000.0, ping = 12.5),
             )
             val model2 = MeasurementModelFactory.build(resultId = resultId2)
             val modelId1 = subject.createOrUpdate(model1)
             subject.createOrUpdate(model2)
 
-            val output = subject.selectTestKeys(listOf(descriptor)).first()
+            val output = subject.selectTestKeysByResultIds(listOf(resultId1)).first()
 
             assertEquals(1, output.size)
             with(output.first()) {
                 assertEquals(modelId1, id)
                 assertEquals(resultId1, resultId)
-                assertEquals("true", testKeys?.blocking)
+                assertEquals(TestKeysSummary(download = 1000.0, ping = 12.5), summary)
             }
         }
+
+    @Test
+    fun fillMissingTestKeysSummaries() =
+        runTest {
+            val resultId = resultRepository.createOrUpdate(ResultModelFactory.build(id = null))
+            val measurementId = subject.createOrUpdate(
+                MeasurementModelFactory.build(
+                    resultId = resultId,
+                    testKeys = """{"simple":{"median_bitrate":230936}}""",
+                ),
+            )
+            // Like a measurement stored before the summary existed
+            database.measurementQueries.updateTestKeysSummary(null, measurementId.value)
+            assertEquals(null, subject.list().first().first().testKeysSummary)
+
+            assertEquals(1, subject.fillMissingTestKeysSummaries())
+
+            assertEquals(
+                TestKeysSummary(medianBitrate = 230936.0),
+                subject.list().first().first().testKeysSummary,
+            )
+            assertEquals(0, subject.fillMissingTestKeysSummaries())
+        }
 }
@@ -1,5 +1,6 @@
 package org.ooni.probe.data.repositories
 
+import app.cash.sqldelight.db.SqlDriver
 import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.flow.first
 import kotlinx.coroutines.test.runTest
@@ -22,16 +23,19 @@ import kotlin.test.BeforeTest
 import kotlin.test.Test
 import kotlin.test.assertEquals
 import kotlin.test.assertNotNull
+import kotlin.test.assertNull
 import kotlin.test.assertTrue
 
 class ResultRepositoryTest {
     private lateinit var subject: ResultRepository
     private lateinit var measurementRepository: MeasurementRepository
+    private lateinit var driver: SqlDriver
     private val json = Dependencies.buildJson()
 
     @BeforeTest
     fun before() {
-        val database = Dependencies.buildDatabase(::createTestDatabaseDriver)
+        driver = createTestDatabaseDriver()
+        val database = Dependencies.buildDatabase { driver }
         subject = ResultRepository(database, Dispatchers.Default)
         measurementRepository = MeasurementRepository(
             database = database,
@@ -179,6 +183,116 @@ class ResultRepositoryTest {
             assertEquals(false, item.anyMeasurementUploadFailed)
         }
 
+    @Test
+    fun measurementCountersFollowMeasurementWrites() =
+        runTest {
+            val result = ResultModelFactory.build()
+            subject.createOrUpdate(result)
+            val measurement = MeasurementModelFactory.build(
+                id = MeasurementModel.Id(1),
+                resultId = result.id!!,
+                isDone = false,
+            )
+            measurementRepository.createOrUpdate(measurement)
+            measurementRepository.createOrUpdate(
+                measurement.copy(id = MeasurementModel.Id(2), isDone = true, isAnomaly = true),
+            )
+            // Replacing a measurement must not count it twice
+            measurementRepository.createOrUpdate(measurement.copy(isDone = true, isFailed = true))
+            // Updating the result must not reset its counters
+            subject.createOrUpdate(result.copy(isViewed = true))
+
+            with(subject.list().first().first()) {
+                assertEquals(2, measurementCounts.done)
+                assertEquals(1, measurementCounts.failed)
+                assertEquals(1, measurementCounts.anomaly)
+                assertEquals(false, allMeasurementsUploaded)
+            }
+
+            measurementRepository.deleteByIds(listOf(MeasurementModel.Id(2)))
+
+            with(subject.list().first().first()) {
+                assertEquals(1, measurementCounts.done)
+                assertEquals(0, measurementCounts.anomaly)
+            }
+            assertEquals(0, subject.checkCounters())
+        }
+
+    @Test
+    fun measurementCountersFollowMeasurementUpdates() =
+        runTest {
+            val result = ResultModelFactory.build()
+            subject.createOrUpdate(result)
+            val otherResult = ResultModelFactory.build()
+            subject.createOrUpdate(otherResult)
+            listOf(1L, 2L).forEach { id ->
+                measurementRepository.createOrUpdate(
+                    MeasurementModelFactory.build(
+                        id = MeasurementModel.Id(id),
+                        resultId = result.id!!,
+                        isDone = true,
+                        isUploaded = false,
+                        isUploadFailed = true,
+                    ),
+                )
+            }
+
+            // Updated in place, without going through INSERT OR REPLACE
+            driver.execute(null, "UPDATE Measurement SET is_uploaded = 1, is_upload_failed = 0 WHERE id = 1", 0)
+            driver.execute(null, "UPDATE Measurement SET result_id = ${otherResult.id!!.value} WHERE id = 2", 0)
+
+            val counters = subject.list().first().associate { it.result.id to it }
+            with(counters.getValue(result.id)) {
+                assertEquals(1, measurementCounts.done)
+                assertEquals(true, allMeasurementsUploaded)
+                assertEquals(false, anyMeasurementUploadFailed)
+            }
+            with(counters.getValue(otherResult.id)) {
+                assertEquals(1, measurementCounts.done)
+                assertEquals(false, allMeasurementsUploaded)
+                assertEquals(true, anyMeasurementUploadFailed)
+            }
+            assertEquals(0, subject.checkCounters())
+        }
+
+    @Test
+    fun listPages() =
+        runTest {
+            val today = LocalDate.today()
+            // Two results share the same start time, so pages are ordered by id too
+            val results = listOf(1L, 2L, 3L, 4L, 5L).map { id ->
+                ResultModelFactory.build(
+                    id = ResultModel.Id(id),
+                    startTime = today.atTime(5, 30, if (id <= 2) 0 else id.toInt()),
+                )
+            }
+            results.forEach { subject.createOrUpdate(it) }
+            val filter = ResultFilter()
+
+            val firstPage = subject.listPage(filter, limit = 2).first()
+            assertEquals(listOf(5L, 4L), firstPage.map { it.result.id?.value })
+
+            val cursors = subject.listPage(filter).first().associate { it.result.id?.value to it.pageCursor }
+            val firstPageEnd = firstPage.last().pageCursor!!
+            val secondPageEnd = subject.getNextPageEnd(filter, firstPageEnd, pageSize = 2)
+            assertEquals(cursors[2L], secondPageEnd)
+
+            // Results until the end of the second page, with any result that shows up in between
+            subject.createOrUpdate(ResultModelFactory.build(id = ResultModel.Id(6), startTime = today.atTime(6, 0)))
+            assertEquals(
+                listOf(6L, 5L, 4L, 3L, 2L),
+                subject.listPage(filter, until = secondPageEnd).first().map { it.result.id?.value },
+            )
+            assertEquals(
+                listOf(1L),
+                subject.listPage(filter, after = secondPageEnd).first().map { it.result.id?.value },
+            )
+
+            val lastPageEnd = subject.getNextPageEnd(filter, secondPageEnd!!, pageSize = 2)
+            assertEquals(cursors[1L], lastPageEnd)
+            assertNull(subject.getNextPageEnd(filter, lastPageEnd!!, pageSize = 2))
+        }
+
     @Test
     fun markAsViewed() =
         runTest {
@@ -199,9 +313,11 @@ class ResultRepositoryTest {
     fun markAllAsViewed() =
         runTest {
             subject.createOrUpdate(ResultModelFactory.build(isViewed = false))
+            assertEquals(1, subject.countByFilter(ResultFilter()).first().notViewed)
 
             subject.markAllAsViewed(ResultFilter())
 
+            assertEquals(0, subject.countByFilter(ResultFilter()).first().notViewed)
             assertTrue(
                 subject
                     .getLatest()
@@ -100,17 +100,24 @@ class UrlRepositoryTest {
         }
 
     @Test
-    fun getOrCreateByUrl() =
+    fun getOrCreateIdsByUrl() =
         runTest {
-            val url = "htts://example.org"
-            val model = UrlModelFactory.build(url = url)
+            val existingModel = subject.createOrUpdate(UrlModelFactory.build(url = "https://example.org"))
+            val urls = listOf(existingModel.url, "https://ooni.org", "https://ooni.org")
 
-            val createModel = subject.createOrUpdate(model)
-            val result = subject.getOrCreateByUrl(url)
+            val ids = subject.getOrCreateIdsByUrl(urls)
 
-            assertNotNull(result)
-            assertNotNull(createModel.id)
-            assertEquals(url, result.url)
-            assertEquals(createModel.id, result.id)
+            assertEquals(2, ids.size)
+            assertEquals(existingModel.id, ids[existingModel.url])
+            val allUrls = subject.list().first()
+            assertEquals(2, allUrls.size)
+            with(allUrls.first { it.url == "https://ooni.org" }) {
+                assertEquals(ids[url], id)
+                assertEquals(WebConnectivityCategory.MISC, category)
+            }
+
+            // Cached or not, the same URLs keep their ids
+            assertEquals(ids, subject.getOrCreateIdsByUrl(urls))
+            assertEquals(2, subject.list().first().size)
         }
 }
@@ -4,6 +4,8 @@ import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.flow.first
 import kotlinx.coroutines.test.runTest
 import okio.FileSystem
+import okio.Path.Companion.toPath
+import okio.SYSTEM
 import org.ooni.engine.models.Failure
 import org.ooni.engine.models.Result
 import org.ooni.engine.models.Success
@@ -33,6 +35,7 @@ class FetchGeoIpDbUpdatesTest {
     fun after() =
         runTest {
             preferences.clear()
+            FileSystem.SYSTEM.deleteRecursively(CACHE_DIR.toPath())
         }
 
     @Test
@@ -41,7 +44,7 @@ class FetchGeoIpDbUpdatesTest {
             var downloadsAttempted = 0
             val subject = subject(
                 passportGet = { Failure(PassportException.Offline("no active network")) },
-                downloadFile = { _, _ ->
+                downloadFile = { _, _, _ ->
                     downloadsAttempted++
                     Failure(GetBytesException(Exception("must not be reached")))
                 },
@@ -59,7 +62,7 @@ class FetchGeoIpDbUpdatesTest {
         runTest {
             val subject = subject(
                 passportGet = { Failure(PassportException.HttpClientError("HTTP 503")) },
-                downloadFile = { _, _ -> Failure(GetBytesException(Exception("unused"))) },
+                downloadFile = { _, _, _ -> Failure(GetBytesException(Exception("unused"))) },
             )
 
             val result = subject()
@@ -73,13 +76,8 @@ class FetchGeoIpDbUpdatesTest {
         runTest {
             var downloadsAttempted = 0
             val subject = subject(
-                // NOTE: a download is only attempted when the remote tag is *older* than the
-                // current one, because `isGeoIpDbLatest` returns `latestTag >= currentTag` and the
-                // caller treats that as "already up to date". That comparison looks inverted, but
-                // it is pre-existing behaviour and out of scope here; this test uses the route
-                // that actually reaches the download so the failure handling is covered.
-                passportGet = { Success(response("""{"tag_name":"20250101"}""")) },
-                downloadFile = { _, _ ->
+                passportGet = { Success(response("""{"tag_name":"20250901"}""")) },
+                downloadFile = { _, _, _ ->
                     downloadsAttempted++
                     Failure(GetBytesException(Exception("connection reset")))
                 },
@@ -92,6 +90,62 @@ class FetchGeoIpDbUpdatesTest {
             assertNoFreshnessStamped()
         }
 
+    @Test
+    fun invalidDeltaFallsBackToFullDownload() =
+        runTest {
+            val fileSystem = FileSystem.SYSTEM
+            val cacheDir = CACHE_DIR.toPath()
+            fileSystem.createDirectories(cacheDir)
+            fileSystem.write(cacheDir.resolve("20250801.mmdb")) { writeUtf8("installed") }
+            val downloads = mutableListOf<String>()
+            val subject = subject(
+                // A newer release, with a delta from the installed version
+                passportGet = {
+                    Success(
+                        response(
+                            """{"tag_name":"20250901","assets":[
+                            {"name":"20250901-ip2country_as.mmdb"},
+                            {"name":"20250801-20250901-ip2country_as.mmdb.delta"}]}""",
+                        ),
+                    )
+                },
+                downloadFile = { url, target, _ ->
+                    downloads += url.substringAfterLast("/")
+                    fileSystem.write(target.toPath()) { writeUtf8("not a delta") }
+                    Success(target.toPath())
+                },
+            )
+
+            val result = subject()
+
+            assertEquals(
+                listOf("20250801-20250901-ip2country_as.mmdb.delta", "20250901-ip2country_as.mmdb"),
+                downloads,
+            )
+            assertEquals(cacheDir.resolve("20250901.mmdb"), result.get())
+            assertEquals(listOf("20250901.mmdb"), fileSystem.list(cacheDir).map { it.name })
+            assertEquals("20250901", preferences.getValueByKey(SettingsKey.MMDB_VERSION).first())
+        }
+
+    @Test
+    fun olderReleaseIsNotDownloaded() =
+        runTest {
+            var downloadsAttempted = 0
+            val subject = subject(
+                passportGet = { Success(response("""{"tag_name":"20250101"}""")) },
+                downloadFile = { _, _, _ ->
+                    downloadsAttempted++
+                    Failure(GetBytesException(Exception("must not be reached")))
+                },
+            )
+
+            val result = subject()
+
+            assertEquals(0, downloadsAttempted)
+            assertNull(result.get())
+            assertNull(preferences.getValueByKey(SettingsKey.MMDB_VERSION).first())
+        }
+
     private suspend fun assertNoFreshnessStamped() {
         assertNull(
             preferences.getValueByKey(SettingsKey.MMDB_LAST_CHECK).first(),
@@ -105,10 +159,10 @@ class FetchGeoIpDbUpdatesTest {
 
     private fun subject(
         passportGet: suspend (String) -> Result<PassportHttpResponse, PassportException>,
-        downloadFile: suspend (String, String) -> Result<okio.Path, GetBytesException>,
+        downloadFile: suspend (String, String, String?) -> Result<okio.Path, GetBytesException>,
     ) = FetchGeoIpDbUpdates(
         downloadFile = downloadFile,
-        cacheDir = "/tmp/ooni-test-cache",
+        cacheDir = CACHE_DIR,
         passportGet = passportGet,
         preferencesRepository = preferences,
         json = Dependencies.buildJson(),
@@ -123,4 +177,8 @@ class FetchGeoIpDbUpdatesTest {
             headersListText = emptyList(),
             bodyText = body,
         )
+
+    companion object {
+        private const val CACHE_DIR = "/tmp/ooni-test-cache"
+    }
 }
@@ -0,0 +1,81 @@
+package org.ooni.probe.domain
+
+import kotlinx.coroutines.test.runTest
+import org.ooni.probe.data.models.MeasurementModel
+import org.ooni.testing.factories.MeasurementModelFactory
+import org.ooni.testing.factories.ResultModelFactory
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.time.Duration.Companion.milliseconds
+import kotlin.time.TestTimeSource
+
+class RunWriteBehindTest {
+    private val timeSource = TestTimeSource()
+    private val storedMeasurements = mutableListOf<List<MeasurementModel>>()
+    private var result = ResultModelFactory.build()
+    private var resultWrites = 0
+
+    private val subject = RunWriteBehind(
+        storeMeasurements = { storedMeasurements.add(it) },
+        storeResultUpdate = {
+            result = it(result)
+            resultWrites++
+        },
+        window = 100.milliseconds,
+        timeSource = timeSource,
+    )
+
+    @Test
+    fun coalescesUpdatesUntilFlush() =
+        runTest {
+            val measurement = MeasurementModelFactory.build(id = MeasurementModel.Id(1))
+            val otherMeasurement = MeasurementModelFactory.build(id = MeasurementModel.Id(2))
+
+            subject.updateMeasurement(measurement)
+            subject.updateMeasurement(otherMeasurement)
+            subject.updateMeasurement(measurement.copy(isDone = true))
+            subject.updateResult { it.copy(dataUsageUp = it.dataUsageUp + 1) }
+            subject.updateResult { it.copy(dataUsageUp = it.dataUsageUp * 10) }
+            assertEquals(0, storedMeasurements.size)
+            assertEquals(0, resultWrites)
+
+            subject.flush()
+
+            assertEquals(
+                listOf(listOf(measurement.copy(isDone = true), otherMeasurement)),
+                storedMeasurements,
+            )
+            // Result updates are applied in order
+            assertEquals(10, result.dataUsageUp)
+            assertEquals(1, resultWrites)
+
+            // Nothing left to write
+            subject.flush()
+            assertEquals(1, storedMeasurements.size)
+            assertEquals(1, resultWrites)
+        }
+
+    @Test
+    fun flushesOnceWindowPasses() =
+        runTest {
+            subject.updateMeasurement(MeasurementModelFactory.build(id = MeasurementModel.Id(1)))
+            timeSource += 50.milliseconds
+            subject.updateMeasurement(MeasurementModelFactory.build(id = MeasurementModel.Id(2)))
+            subject.flushIfDue()
+            assertEquals(0, storedMeasurements.size)
+
+            // The window starts with the oldest pending update
+            timeSource += 50.milliseconds
+            subject.flushIfDue()
+            assertEquals(1, storedMeasurements.size)
+            assertEquals(2, storedMeasurements.first().size)
+        }
+
+    @Test
+    fun ignoresMeasurementsWithoutId() =
+        runTest {
+            subject.updateMeasurement(MeasurementModelFactory.build(id = null))
+            subject.flush()
+            assertEquals(0, storedMeasurements.size)
+        }
+}
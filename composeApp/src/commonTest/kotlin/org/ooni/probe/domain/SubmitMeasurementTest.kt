@@ -23,7 +23,7 @@ class SubmitMeasurementTest {
         onRead: () -> Unit = {},
         onSubmit: () -> Unit = {},
         onUpdate: (MeasurementModel) -> Unit = {},
-        onDeleteFile: () -> Unit = {},
+        onDeleteReport: () -> Unit = {},
         onDeleteById: () -> Unit = {},
     ) = SubmitMeasurement(
         submitMeasurementWithUser = {
@@ -31,11 +31,11 @@ class SubmitMeasurementTest {
             Success(responseData)
         },
         engineSubmit = { error("legacy submit should not be used") },
-        readFile = {
+        readReport = {
             onRead()
             report
         },
-        deleteFiles = { onDeleteFile() },
+        deleteReport = { onDeleteReport() },
         updateMeasurement = { onUpdate(it) },
         deleteMeasurementById = { onDeleteById() },
         handleSubmitOutcome = { _, _ -> },
@@ -94,7 +94,7 @@ class SubmitMeasurementTest {
                     report = corruptReport,
                     onSubmit = { submitted = true },
                     onUpdate = { updated = it },
-                    onDeleteFile = { fileDeleted = true },
+                    onDeleteReport = { fileDeleted = true },
                     onDeleteById = { rowDeleted = true },
                 )
 
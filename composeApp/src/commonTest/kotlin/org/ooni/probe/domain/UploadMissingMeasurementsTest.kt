@@ -1,5 +1,6 @@
 package org.ooni.probe.domain
 
+import kotlinx.coroutines.delay
 import kotlinx.coroutines.flow.flowOf
 import kotlinx.coroutines.test.runTest
 import org.ooni.probe.data.models.MeasurementModel
@@ -20,7 +21,8 @@ class UploadMissingMeasurementsTest {
             )
             val subject = UploadMissingMeasurements(
                 getMeasurementsNotUploaded = { flowOf(listOf(model)) },
-                submitMeasurement = { model.copy(isUploaded = true) },
+                readReport = { REPORT },
+                submitMeasurement = { _, _ -> model.copy(isUploaded = true) },
             )
 
             val results = mutableListOf<UploadMissingMeasurements.State>()
@@ -39,7 +41,8 @@ class UploadMissingMeasurementsTest {
             )
             val subject = UploadMissingMeasurements(
                 getMeasurementsNotUploaded = { flowOf(listOf(model)) },
-                submitMeasurement = { model.copy(isUploaded = false) },
+                readReport = { REPORT },
+                submitMeasurement = { _, _ -> model.copy(isUploaded = false) },
             )
 
             val results = mutableListOf<UploadMissingMeasurements.State>()
@@ -62,7 +65,8 @@ class UploadMissingMeasurementsTest {
             var healthyUploaded = false
             val subject = UploadMissingMeasurements(
                 getMeasurementsNotUploaded = { flowOf(corrupt + healthy) },
-                submitMeasurement = { measurement ->
+                readReport = { REPORT },
+                submitMeasurement = { measurement, _ ->
                     if (measurement.id == healthy.id) {
                         healthyUploaded = true
                         measurement.copy(isUploaded = true)
@@ -79,4 +83,90 @@ class UploadMissingMeasurementsTest {
             assertTrue(healthyUploaded, "healthy measurement behind the corrupt ones is still uploaded")
             assertEquals(UploadMissingMeasurements.State.Finished(1, 5, 6), results.last())
         }
+
+    @Test
+    fun uploadsConcurrently() =
+        runTest {
+            val models = (1..10).map {
+                MeasurementModelFactory.build(id = MeasurementModel.Id(it.toLong()), isDone = true)
+            }
+            var inFlight = 0
+            var maxInFlight = 0
+            val subject = UploadMissingMeasurements(
+                getMeasurementsNotUploaded = { flowOf(models) },
+                readReport = { REPORT },
+                submitMeasurement = { measurement, _ ->
+                    inFlight++
+                    maxInFlight = maxOf(maxInFlight, inFlight)
+                    delay(100)
+                    inFlight--
+                    measurement.copy(isUploaded = true)
+                },
+                concurrency = 3,
+            )
+
+            val results = mutableListOf<UploadMissingMeasurements.State>()
+            subject(MeasurementsFilter.All).collect { results.add(it) }
+
+            assertEquals(3, maxInFlight)
+            assertEquals(10, results.count { it is UploadMissingMeasurements.State.Uploading })
+            assertEquals(UploadMissingMeasurements.State.Finished(10, 0, 10), results.last())
+            // 4 rounds of at most 3 uploads
+            assertEquals(400, testScheduler.currentTime)
+        }
+
+    @Test
+    fun abortsAfterSubsequentFailures() =
+        runTest {
+            val models = (1..20).map {
+                MeasurementModelFactory.build(id = MeasurementModel.Id(it.toLong()), isDone = true)
+            }
+            val subject = UploadMissingMeasurements(
+                getMeasurementsNotUploaded = { flowOf(models) },
+                readReport = { REPORT },
+                submitMeasurement = { measurement, _ ->
+                    delay(100)
+                    measurement.copy(isUploaded = false)
+                },
+                concurrency = 2,
+            )
+
+            val results = mutableListOf<UploadMissingMeasurements.State>()
+            subject(MeasurementsFilter.All).collect { results.add(it) }
+
+            // The uploads in flight when the limit is reached still finish
+            assertEquals(UploadMissingMeasurements.State.Finished(0, 6, 20), results.last())
+        }
+
+    @Test
+    fun readsReportsAheadOfUploads() =
+        runTest {
+            val models = (1..10).map {
+                MeasurementModelFactory.build(id = MeasurementModel.Id(it.toLong()), isDone = true)
+            }
+            val subject = UploadMissingMeasurements(
+                getMeasurementsNotUploaded = { flowOf(models) },
+                readReport = { measurement ->
+                    delay(50)
+                    "report ${measurement.id?.value}"
+                },
+                submitMeasurement = { measurement, report ->
+                    assertEquals("report ${measurement.id?.value}", report)
+                    delay(100)
+                    measurement.copy(isUploaded = true)
+                },
+                concurrency = 1,
+            )
+
+            val results = mutableListOf<UploadMissingMeasurements.State>()
+            subject(MeasurementsFilter.All).collect { results.add(it) }
+
+            assertEquals(UploadMissingMeasurements.State.Finished(10, 0, 10), results.last())
+            // Only the first read isn't overlapped with an upload
+            assertEquals(1050, testScheduler.currentTime)
+        }
+
+    companion object {
+        private const val REPORT = "{}"
+    }
 }
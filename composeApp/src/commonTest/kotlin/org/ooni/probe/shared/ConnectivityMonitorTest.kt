@@ -1,5 +1,7 @@
 package org.ooni.probe.shared
 
+import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.flow.flowOf
 import kotlinx.coroutines.flow.take
 import kotlinx.coroutines.flow.toList
 import kotlinx.coroutines.test.runTest
@@ -59,5 +61,33 @@ class ConnectivityMonitorTest {
             assertEquals(listOf(true), emissions)
         }
 
+    @Test
+    fun observeUsesPushedChangesWhenAvailable() =
+        runTest {
+            var polled = false
+            val subject = ConnectivityMonitor(
+                object : NetworkTypeFinder {
+                    override fun invoke(): NetworkType {
+                        polled = true
+                        return NetworkType.Wifi
+                    }
+
+                    override fun observe(): Flow<NetworkType> =
+                        flowOf(
+                            NetworkType.Wifi,
+                            NetworkType.Ethernet,
+                            NetworkType.NoInternet,
+                            NetworkType.NoInternet,
+                            NetworkType.VPN,
+                        )
+                },
+            )
+
+            val emissions = subject.observeIsOnline().toList()
+
+            assertEquals(listOf(true, false, true), emissions)
+            assertFalse(polled)
+        }
+
     private fun monitorOf(type: NetworkType) = ConnectivityMonitor(NetworkTypeFinder { type })
 }
@@ -0,0 +1,32 @@
+package org.ooni.probe.shared
+
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertNull
+
+class LruCacheTest {
+    @Test
+    fun evictsLeastRecentlyUsedEntry() {
+        val cache = LruCache<String, Int>(2)
+        cache["a"] = 1
+        cache["b"] = 2
+        // Reading "a" makes "b" the least recently used
+        assertEquals(1, cache["a"])
+        cache["c"] = 3
+
+        assertNull(cache["b"])
+        assertEquals(1, cache["a"])
+        assertEquals(3, cache["c"])
+        assertEquals(2, cache.size)
+    }
+
+    @Test
+    fun replacesExistingEntry() {
+        val cache = LruCache<String, Int>(2)
+        cache["a"] = 1
+        cache["a"] = 2
+
+        assertEquals(2, cache["a"])
+        assertEquals(1, cache.size)
+    }
+}
@@ -0,0 +1,35 @@
+package org.ooni.probe.shared
+
+import kotlin.test.Test
+import kotlin.test.assertEquals
+
+class RingBufferTest {
+    @Test
+    fun keepsItemsInOrderBelowCapacity() {
+        val buffer = RingBuffer<String>(3)
+        buffer.add("a")
+        buffer.add("b")
+
+        assertEquals(listOf("a", "b"), buffer.toList())
+        assertEquals(2, buffer.size)
+    }
+
+    @Test
+    fun overwritesOldestItemsWhenFull() {
+        val buffer = RingBuffer<Int>(3)
+        buffer.addAll(1..7)
+
+        assertEquals(listOf(5, 6, 7), buffer.toList())
+        assertEquals(3, buffer.size)
+    }
+
+    @Test
+    fun clear() {
+        val buffer = RingBuffer<Int>(2)
+        buffer.addAll(1..3)
+        buffer.clear()
+        buffer.add(4)
+
+        assertEquals(listOf(4), buffer.toList())
+    }
+}
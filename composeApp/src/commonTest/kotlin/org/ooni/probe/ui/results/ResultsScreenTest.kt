@@ -122,6 +122,7 @@ class ResultsScreenTest {
                         result = ResultModelFactory.build(),
                         descriptor = DescriptorFactory.buildDescriptorWithInstalled(),
                         network = NetworkModelFactory.build(),
+                        pageCursor = null,
                         measurementCounts = MeasurementCounts(
                             done = 4,
                             failed = 0,
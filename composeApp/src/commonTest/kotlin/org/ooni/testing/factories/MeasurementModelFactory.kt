@@ -5,6 +5,7 @@ import org.ooni.engine.models.TestType
 import org.ooni.probe.data.models.MeasurementModel
 import org.ooni.probe.data.models.MeasurementWithUrl
 import org.ooni.probe.data.models.ResultModel
+import org.ooni.probe.data.models.TestKeysSummary
 import org.ooni.probe.data.models.UrlModel
 import kotlin.math.absoluteValue
 import kotlin.random.Random
@@ -26,7 +27,9 @@ object MeasurementModelFactory {
         reportId: MeasurementModel.ReportId? = null,
         uid: MeasurementModel.Uid? = null,
         testKeys: String? = null,
+        testKeysSummary: TestKeysSummary? = null,
         rerunNetwork: String? = null,
+        reportLocation: MeasurementModel.ReportLocation? = null,
         urlId: UrlModel.Id? = null,
         resultId: ResultModel.Id = ResultModel.Id(Random.nextLong().absoluteValue),
     ) = MeasurementModel(
@@ -45,7 +48,9 @@ object MeasurementModelFactory {
         reportId = reportId,
         uid = uid,
         testKeys = testKeys,
+        testKeysSummary = testKeysSummary,
         rerunNetwork = rerunNetwork,
+        reportLocation = reportLocation,
         urlId = urlId,
         resultId = resultId,
     )
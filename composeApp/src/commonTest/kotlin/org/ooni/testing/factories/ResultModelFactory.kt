@@ -7,6 +7,7 @@ import org.ooni.engine.models.TaskOrigin
 import org.ooni.probe.data.models.Descriptor
 import org.ooni.probe.data.models.MeasurementCounts
 import org.ooni.probe.data.models.NetworkModel
+import org.ooni.probe.data.models.PageCursor
 import org.ooni.probe.data.models.ResultModel
 import org.ooni.probe.data.models.ResultWithNetworkAndAggregates
 import org.ooni.probe.data.models.RunModel
@@ -47,12 +48,14 @@ object ResultModelFactory {
     fun buildWithNetworkAndAggregates(
         result: ResultModel = build(),
         network: NetworkModel = NetworkModelFactory.build(),
+        pageCursor: PageCursor? = null,
         measurementCounts: MeasurementCounts = MeasurementCounts(0, 0, 0),
         allMeasurementsUploaded: Boolean = false,
         anyMeasurementUploadFailed: Boolean = false,
     ) = ResultWithNetworkAndAggregates(
         result = result,
         network = network,
+        pageCursor = pageCursor,
         measurementCounts = measurementCounts,
         allMeasurementsUploaded = allMeasurementsUploaded,
         anyMeasurementUploadFailed = anyMeasurementUploadFailed,
@@ -1,34 +1,156 @@
 package org.ooni.engine
 
 import co.touchlab.kermit.Logger
+import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.flow.MutableStateFlow
+import org.ooni.engine.models.NetworkSnapshot
 import org.ooni.engine.models.NetworkType
 import org.ooni.shared.DesktopBridgeLoader
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
 
 /** * DesktopNetworkTypeFinder is a class that implements NetworkTypeFinder
  * to determine the network type on desktop platforms.
  */
 class DesktopNetworkTypeFinder : NetworkTypeFinder {
+    // Still exported by the bridge, used when it predates nativeGetNetworkSnapshot
     private external fun getNetworkType(): String
 
-    override fun invoke(): NetworkType {
-        val networkTypeString = try {
-            if (DesktopBridgeLoader.ensureLoaded()) {
-                getNetworkType()
-            } else {
-                "unknown"
+    private external fun nativeGetNetworkSnapshot(buffer: ByteBuffer): Int
+
+    private external fun nativeSetNetworkChangeCallback(callback: NetworkChangeCallback?): Int
+
+    fun interface NetworkChangeCallback {
+        fun onNetworkTypeChanged(networkType: String)
+    }
+
+    // Reused for every call, filled by the native side with a struct network_snapshot
+    private val snapshotBuffer = ByteBuffer.allocateDirect(SNAPSHOT_SIZE).order(ByteOrder.nativeOrder())
+    private val interfaceNameBytes = ByteArray(INTERFACE_NAME_SIZE)
+
+    // False once the loaded bridge turned out not to export the snapshot API
+    @Volatile
+    private var hasSnapshotApi = true
+
+    // Registered once and shared by every collector, since the native bridge holds a single callback
+    private val networkTypeChanges: MutableStateFlow<NetworkType>? by lazy {
+        val state = MutableStateFlow(invoke())
+        val callback = NetworkChangeCallback { state.value = it.toNetworkType() }
+        val result = try {
+            if (DesktopBridgeLoader.ensureLoaded()) nativeSetNetworkChangeCallback(callback) else -1
+        } catch (e: Throwable) {
+            Logger.w("Error in native method call: ${e.message}")
+            -1
+        }
+        if (result == 0) {
+            // Catch up with any change that happened before the callback was registered
+            state.value = invoke()
+            state
+        } else {
+            Logger.i("Network change notifications not available ($result), falling back to polling")
+            null
+        }
+    }
+
+    override fun invoke(): NetworkType = snapshot().networkType
+
+    override fun snapshot(): NetworkSnapshot =
+        try {
+            when {
+                !DesktopBridgeLoader.ensureLoaded() -> UNKNOWN_SNAPSHOT
+                hasSnapshotApi -> nativeSnapshot()
+                else -> legacySnapshot()
             }
         } catch (e: Throwable) {
             Logger.w("Error in native method call: ${e.message}")
-            "unknown"
+            UNKNOWN_SNAPSHOT
         }
 
-        return when (networkTypeString) {
+    private fun nativeSnapshot(): NetworkSnapshot =
+        try {
+            synchronized(snapshotBuffer) {
+                val written = nativeGetNetworkSnapshot(snapshotBuffer)
+                if (written == SNAPSHOT_SIZE) {
+                    snapshotBuffer.toNetworkSnapshot()
+                } else {
+                    Logger.w("Unexpected network snapshot size: $written")
+                    UNKNOWN_SNAPSHOT
+                }
+            }
+        } catch (e: UnsatisfiedLinkError) {
+            Logger.i("Network snapshot not available in the desktop bridge, only reading the network type")
+            hasSnapshotApi = false
+            legacySnapshot()
+        }
+
+    private fun legacySnapshot() = NetworkSnapshot(networkType = getNetworkType().toNetworkType())
+
+    override fun observe(): Flow<NetworkType>? = networkTypeChanges
+
+    private fun ByteBuffer.toNetworkSnapshot(): NetworkSnapshot {
+        val flags = getInt(FLAGS_OFFSET)
+        val knownFlags = getInt(KNOWN_FLAGS_OFFSET)
+        var nameLength = 0
+        while (nameLength < INTERFACE_NAME_SIZE && get(INTERFACE_NAME_OFFSET + nameLength) != 0.toByte()) {
+            interfaceNameBytes[nameLength] = get(INTERFACE_NAME_OFFSET + nameLength)
+            nameLength++
+        }
+        return NetworkSnapshot(
+            networkType = NETWORK_TYPES.getOrElse(getInt(TYPE_OFFSET)) { UNKNOWN_SNAPSHOT.networkType },
+            interfaceName = if (nameLength > 0) String(interfaceNameBytes, 0, nameLength, Charsets.UTF_8) else null,
+            mtu = getInt(MTU_OFFSET).takeIf { it > 0 },
+            hasIpv6DefaultRoute = flag(flags, knownFlags, FLAG_IPV6_DEFAULT_ROUTE),
+            isMetered = flag(flags, knownFlags, FLAG_METERED),
+            vpnKind = VPN_KINDS.getOrNull(getInt(VPN_KIND_OFFSET)),
+            generation = getLong(GENERATION_OFFSET),
+        )
+    }
+
+    // Null when the platform couldn't tell, so the measurement annotation is left out
+    private fun flag(
+        flags: Int,
+        knownFlags: Int,
+        flag: Int,
+    ) = if ((knownFlags and flag) != 0) (flags and flag) != 0 else null
+
+    private fun String.toNetworkType() =
+        when (this) {
             "vpn" -> NetworkType.VPN
             "wifi" -> NetworkType.Wifi
             "mobile" -> NetworkType.Mobile
             "wired_ethernet" -> NetworkType.Ethernet
             "no_internet" -> NetworkType.NoInternet
-            else -> NetworkType.Unknown(networkTypeString)
+            else -> NetworkType.Unknown(this)
         }
+
+    companion object {
+        // Layout of struct network_snapshot in NetworkTypeFinder.h
+        private const val GENERATION_OFFSET = 0
+        private const val TYPE_OFFSET = 8
+        private const val VPN_KIND_OFFSET = 12
+        private const val MTU_OFFSET = 16
+        private const val FLAGS_OFFSET = 20
+        private const val KNOWN_FLAGS_OFFSET = 24
+        private const val INTERFACE_NAME_OFFSET = 28
+        private const val INTERFACE_NAME_SIZE = 16
+
+        // Including the tail padding up to the alignment of the generation
+        private const val SNAPSHOT_SIZE = 48
+
+        private const val FLAG_IPV6_DEFAULT_ROUTE = 0x1
+        private const val FLAG_METERED = 0x2
+
+        // Indexed by enum network_type and enum network_vpn_kind
+        private val NETWORK_TYPES = listOf(
+            NetworkType.Unknown("unknown"),
+            NetworkType.VPN,
+            NetworkType.Wifi,
+            NetworkType.Mobile,
+            NetworkType.Ethernet,
+            NetworkType.NoInternet,
+        )
+        private val VPN_KINDS = listOf(null) + NetworkSnapshot.VpnKind.entries
+
+        private val UNKNOWN_SNAPSHOT = NetworkSnapshot(networkType = NetworkType.Unknown("unknown"))
     }
 }
@@ -12,23 +12,26 @@ import java.util.Properties
 
 private const val DATABASE_FILE_NAME = "probe.db"
 
-fun buildDatabaseDriver(folder: String): SqlDriver {
+/**
+ * @param useReaderPool if true, reads go through a pool of read-only connections that don't wait
+ * for the writes (see [PooledSqliteDriver]). Otherwise every thread gets its own connection
+ * for both reads and writes.
+ */
+fun buildDatabaseDriver(
+    folder: String,
+    useReaderPool: Boolean = true,
+): SqlDriver {
     // sqlite-jdbc is a non-modular JAR; under jpackage + Mac App Store sandbox
     // the SPI lookup in DriverManager doesn't find META-INF/services/java.sql.Driver,
     // so force the driver class to load and self-register.
     Class.forName("org.sqlite.JDBC")
 
     val databasePath = folder.toPath().resolve(DATABASE_FILE_NAME)
-    val properties = Properties().apply {
-        put("journal_mode", "wal")
-        put("busy_timeout", "5000")
-        put("foreign_keys", "on")
+    val driver = if (useReaderPool) {
+        PooledSqliteDriver(databasePath.toFile())
+    } else {
+        buildJdbcSqliteDriver(databasePath)
     }
-    val driver = JdbcSqliteDriver("jdbc:sqlite:$databasePath", properties)
-
-    // Ensure PRAGMAs are active regardless of sqlite-jdbc Properties support
-    driver.execute(null, "PRAGMA journal_mode=WAL;", 0, null)
-    driver.execute(null, "PRAGMA busy_timeout=5000;", 0, null)
 
     val dbVersion = driver.getDatabaseVersion()
     val schemaVersion = Database.Schema.version
@@ -55,8 +58,26 @@ fun buildDatabaseDriver(folder: String): SqlDriver {
     return driver
 }
 
+private fun buildJdbcSqliteDriver(databasePath: Path): SqlDriver {
+    val properties = Properties().apply {
+        put("journal_mode", "wal")
+        put("busy_timeout", "5000")
+        put("foreign_keys", "on")
+    }
+    val driver = JdbcSqliteDriver("jdbc:sqlite:$databasePath", properties)
+
+    // Ensure PRAGMAs are active regardless of sqlite-jdbc Properties support
+    driver.execute(null, "PRAGMA journal_mode=WAL;", 0, null)
+    driver.execute(null, "PRAGMA busy_timeout=5000;", 0, null)
+    return driver
+}
+
 private fun SqlDriver.createDatabaseFromScratch(databasePath: Path) {
-    databasePath.toFile().delete()
+    if (this is PooledSqliteDriver) {
+        deleteDatabase()
+    } else {
+        databasePath.toFile().delete()
+    }
     Database.Schema.create(this)
     setDatabaseVersion(Database.Schema.version)
 }
@@ -0,0 +1,340 @@
+package org.ooni.probe.data
+
+import app.cash.sqldelight.Query
+import app.cash.sqldelight.Transacter
+import app.cash.sqldelight.db.QueryResult
+import app.cash.sqldelight.db.SqlCursor
+import app.cash.sqldelight.db.SqlDriver
+import app.cash.sqldelight.db.SqlPreparedStatement
+import co.touchlab.kermit.Logger
+import java.io.File
+import java.sql.Connection
+import java.sql.DriverManager
+import java.sql.PreparedStatement
+import java.sql.ResultSet
+import java.sql.SQLException
+import java.sql.Types
+import java.util.concurrent.LinkedBlockingQueue
+import java.util.concurrent.locks.ReentrantLock
+import kotlin.concurrent.withLock
+
+/**
+ * SQLite driver with one writer connection and a pool of read-only connections.
+ *
+ * In WAL mode readers work on a snapshot of the last commit and don't wait for the writer, so
+ * the UI queries don't queue behind the writes of a running test. Every write, and every read
+ * inside a transaction, goes through the single writer connection, one thread at a time.
+ * Each connection keeps its prepared statements around, as the same queries run over and over.
+ */
+class PooledSqliteDriver(
+    private val databaseFile: File,
+    private val readerCount: Int = DEFAULT_READER_COUNT,
+    private val statementCacheSize: Int = DEFAULT_STATEMENT_CACHE_SIZE,
+) : SqlDriver {
+    private val url = "jdbc:sqlite:${databaseFile.absolutePath}"
+
+    private val writerLock = ReentrantLock()
+    private var writer = openWriter()
+    private val transactions = ThreadLocal<Transaction?>()
+
+    private val idleReaders = LinkedBlockingQueue<CachedConnection>()
+    private val readers = mutableListOf<CachedConnection>()
+
+    private val listeners = mutableMapOf<String, MutableSet<Query.Listener>>()
+
+    override fun <R> executeQuery(
+        identifier: Int?,
+        sql: String,
+        mapper: (SqlCursor) -> QueryResult<R>,
+        parameters: Int,
+        binders: (SqlPreparedStatement.() -> Unit)?,
+    ): QueryResult<R> {
+        // Inside a transaction we need to see its own uncommitted writes
+        if (transactions.get() != null) {
+            return writerLock.withLock { writer.query(identifier, sql, mapper, binders) }
+        }
+        val reader = borrowReader()
+        try {
+            return reader.query(identifier, sql, mapper, binders)
+        } finally {
+            idleReaders.put(reader)
+        }
+    }
+
+    override fun execute(
+        identifier: Int?,
+        sql: String,
+        parameters: Int,
+        binders: (SqlPreparedStatement.() -> Unit)?,
+    ): QueryResult<Long> = writerLock.withLock { QueryResult.Value(writer.execute(identifier, sql, binders)) }
+
+    override fun newTransaction(): QueryResult<Transacter.Transaction> {
+        // Held until the transaction ends, nested transactions re-enter it
+        writerLock.lock()
+        val enclosing = transactions.get()
+        try {
+            if (enclosing == null) writer.connection.autoCommit = false
+        } catch (e: SQLException) {
+            writerLock.unlock()
+            throw e
+        }
+        return QueryResult.Value(Transaction(enclosing).also { transactions.set(it) })
+    }
+
+    override fun currentTransaction(): Transacter.Transaction? = transactions.get()
+
+    override fun addListener(
+        vararg queryKeys: String,
+        listener: Query.Listener,
+    ) {
+        synchronized(listeners) {
+            queryKeys.forEach { listeners.getOrPut(it) { linkedSetOf() }.add(listener) }
+        }
+    }
+
+    override fun removeListener(
+        vararg queryKeys: String,
+        listener: Query.Listener,
+    ) {
+        synchronized(listeners) {
+            queryKeys.forEach { listeners[it]?.remove(listener) }
+        }
+    }
+
+    override fun notifyListeners(vararg queryKeys: String) {
+        val listenersToNotify = synchronized(listeners) {
+            queryKeys.flatMap { listeners[it].orEmpty() }.toSet()
+        }
+        listenersToNotify.forEach { it.queryResultsChanged() }
+    }
+
+    override fun close() {
+        closeReaders()
+        writerLock.withLock { writer.close() }
+    }
+
+    /**
+     * Closes every connection, deletes the database with its WAL files and opens a new writer.
+     * Readers are opened again on demand.
+     */
+    fun deleteDatabase() {
+        writerLock.withLock {
+            closeReaders()
+            writer.close()
+            listOf("", "-wal", "-shm").forEach { File(databaseFile.path + it).delete() }
+            writer = openWriter()
+        }
+    }
+
+    private fun borrowReader(): CachedConnection {
+        idleReaders.poll()?.let { return it }
+        synchronized(readers) {
+            if (readers.size < readerCount) {
+                return openReader().also { readers.add(it) }
+            }
+        }
+        // All readers are busy, wait for one
+        return idleReaders.take()
+    }
+
+    private fun closeReaders() {
+        synchronized(readers) {
+            readers.forEach { it.close() }
+            readers.clear()
+            idleReaders.clear()
+        }
+    }
+
+    private fun openWriter() =
+        CachedConnection(DriverManager.getConnection(url), statementCacheSize).apply {
+            pragma("journal_mode=WAL")
+            // In WAL mode a commit is still atomic and durable enough without syncing every time
+            pragma("synchronous=NORMAL")
+            pragma("foreign_keys=ON")
+            applySharedPragmas()
+        }
+
+    private fun openReader() =
+        CachedConnection(DriverManager.getConnection(url), statementCacheSize).apply {
+            applySharedPragmas()
+            pragma("query_only=ON")
+        }
+
+    private fun CachedConnection.applySharedPragmas() {
+        pragma("busy_timeout=$BUSY_TIMEOUT_MS")
+        pragma("cache_size=-$CACHE_SIZE_KB")
+        pragma("mmap_size=$MMAP_SIZE_BYTES")
+    }
+
+    private inner class Transaction(
+        override val enclosingTransaction: Transaction?,
+    ) : Transacter.Transaction() {
+        override fun endTransaction(successful: Boolean): QueryResult<Unit> {
+            try {
+                if (enclosingTransaction == null) {
+                    try {
+                        if (successful) writer.connection.commit() else writer.connection.rollback()
+                    } finally {
+                        writer.connection.autoCommit = true
+                    }
+                }
+            } finally {
+                transactions.set(enclosingTransaction)
+                writerLock.unlock()
+            }
+            return QueryResult.Unit
+        }
+    }
+
+    private class CachedConnection(
+        val connection: Connection,
+        cacheSize: Int,
+    ) {
+        // Least recently used statements are closed once the cache is full
+        private val statements =
+            object : LinkedHashMap<String, PreparedStatement>(cacheSize, 0.75f, true) {
+                override fun removeEldestEntry(eldest: MutableMap.MutableEntry<String, PreparedStatement>?): Boolean {
+                    if (size <= cacheSize) return false
+                    eldest?.value?.closeQuietly()
+                    return true
+                }
+            }
+
+        fun <R> query(
+            identifier: Int?,
+            sql: String,
+            mapper: (SqlCursor) -> QueryResult<R>,
+            binders: (SqlPreparedStatement.() -> Unit)?,
+        ): QueryResult<R> =
+            withStatement(identifier, sql, binders) { statement ->
+                statement.executeQuery().use { mapper(ResultSetCursor(it)) }
+            }
+
+        fun execute(
+            identifier: Int?,
+            sql: String,
+            binders: (SqlPreparedStatement.() -> Unit)?,
+        ): Long =
+            withStatement(identifier, sql, binders) { statement ->
+                if (statement.execute()) {
+                    statement.resultSet.close()
+                    0L
+                } else {
+                    statement.updateCount.toLong()
+                }
+            }
+
+        fun pragma(pragma: String) {
+            connection.createStatement().use { it.execute("PRAGMA $pragma;") }
+        }
+
+        fun close() {
+            statements.values.forEach { it.closeQuietly() }
+            statements.clear()
+            try {
+                connection.close()
+            } catch (e: SQLException) {
+                Logger.w("Database: could not close connection", e)
+            }
+        }
+
+        // Only statements with an identifier are cached, the others have a dynamic SQL
+        private fun <T> withStatement(
+            identifier: Int?,
+            sql: String,
+            binders: (SqlPreparedStatement.() -> Unit)?,
+            block: (PreparedStatement) -> T,
+        ): T {
+            val cached = identifier != null
+            val statement = if (cached) {
+                statements.getOrPut(sql) { connection.prepareStatement(sql) }
+            } else {
+                connection.prepareStatement(sql)
+            }
+            try {
+                if (binders != null) StatementBinder(statement).binders()
+                return block(statement)
+            } catch (e: SQLException) {
+                // A failed statement might be left in a bad state
+                if (cached) statements.remove(sql)?.closeQuietly()
+                throw e
+            } finally {
+                if (cached) statement.clearParameters() else statement.closeQuietly()
+            }
+        }
+
+        private fun PreparedStatement.closeQuietly() {
+            try {
+                close()
+            } catch (_: SQLException) {
+            }
+        }
+    }
+
+    private class StatementBinder(
+        private val statement: PreparedStatement,
+    ) : SqlPreparedStatement {
+        override fun bindBytes(
+            index: Int,
+            bytes: ByteArray?,
+        ) {
+            if (bytes == null) statement.setNull(index + 1, Types.BLOB) else statement.setBytes(index + 1, bytes)
+        }
+
+        override fun bindLong(
+            index: Int,
+            long: Long?,
+        ) {
+            if (long == null) statement.setNull(index + 1, Types.INTEGER) else statement.setLong(index + 1, long)
+        }
+
+        override fun bindDouble(
+            index: Int,
+            double: Double?,
+        ) {
+            if (double == null) statement.setNull(index + 1, Types.REAL) else statement.setDouble(index + 1, double)
+        }
+
+        override fun bindString(
+            index: Int,
+            string: String?,
+        ) {
+            if (string == null) statement.setNull(index + 1, Types.VARCHAR) else statement.setString(index + 1, string)
+        }
+
+        override fun bindBoolean(
+            index: Int,
+            boolean: Boolean?,
+        ) {
+            if (boolean == null) {
+                statement.setNull(index + 1, Types.BOOLEAN)
+            } else {
+                statement.setLong(index + 1, if (boolean) 1 else 0)
+            }
+        }
+    }
+
+    private class ResultSetCursor(
+        private val resultSet: ResultSet,
+    ) : SqlCursor {
+        override fun next(): QueryResult<Boolean> = QueryResult.Value(resultSet.next())
+
+        override fun getString(index: Int): String? = resultSet.getString(index + 1)
+
+        override fun getLong(index: Int): Long? = resultSet.getLong(index + 1).takeUnless { resultSet.wasNull() }
+
+        override fun getBytes(index: Int): ByteArray? = resultSet.getBytes(index + 1)
+
+        override fun getDouble(index: Int): Double? = resultSet.getDouble(index + 1).takeUnless { resultSet.wasNull() }
+
+        override fun getBoolean(index: Int): Boolean? = getLong(index)?.let { it == 1L }
+    }
+
+    companion object {
+        private const val DEFAULT_READER_COUNT = 4
+        private const val DEFAULT_STATEMENT_CACHE_SIZE = 64
+        private const val BUSY_TIMEOUT_MS = 5000
+        private const val CACHE_SIZE_KB = 8 * 1024
+        private const val MMAP_SIZE_BYTES = 64L * 1024 * 1024
+    }
+}
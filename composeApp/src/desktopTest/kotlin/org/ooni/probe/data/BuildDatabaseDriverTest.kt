@@ -8,10 +8,15 @@ import kotlinx.coroutines.launch
 import kotlinx.coroutines.test.runTest
 import org.ooni.probe.Database
 import java.nio.file.Files
+import java.util.concurrent.CountDownLatch
+import java.util.concurrent.TimeUnit
+import kotlin.concurrent.thread
 import kotlin.test.AfterTest
 import kotlin.test.BeforeTest
 import kotlin.test.Test
 import kotlin.test.assertEquals
+import kotlin.test.assertNotNull
+import kotlin.test.assertNull
 
 class BuildDatabaseDriverTest {
     private lateinit var tempDir: java.nio.file.Path
@@ -98,4 +103,51 @@ class BuildDatabaseDriverTest {
             }
             (writeJobs + readJobs).joinAll()
         }
+
+    @Test
+    fun readsDontWaitForAnOpenWriteTransaction() {
+        val database = Database(driver)
+        val transactionStarted = CountDownLatch(1)
+        val readFinished = CountDownLatch(1)
+        val writer = thread {
+            database.transaction {
+                database.resultQueries.insertTestResult("uncommitted")
+                transactionStarted.countDown()
+                readFinished.await(5, TimeUnit.SECONDS)
+            }
+        }
+
+        transactionStarted.await(5, TimeUnit.SECONDS)
+        // The read sees the last commit, without the row being written
+        assertNull(database.resultQueries.selectLatest().executeAsOneOrNull())
+        readFinished.countDown()
+        writer.join()
+        assertNotNull(database.resultQueries.selectLatest().executeAsOneOrNull())
+    }
+
+    @Test
+    fun transactionReadsItsOwnWrites() {
+        val database = Database(driver)
+        database.transaction {
+            database.resultQueries.insertTestResult("in transaction")
+            assertNotNull(database.resultQueries.selectLatest().executeAsOneOrNull())
+        }
+    }
+
+    private fun ResultQueries.insertTestResult(name: String) =
+        insertOrReplace(
+            id = null,
+            descriptor_name = name,
+            start_time = System.currentTimeMillis(),
+            is_viewed = 0L,
+            is_done = 1L,
+            data_usage_up = 0L,
+            data_usage_down = 0L,
+            failure_msg = null,
+            task_origin = "test",
+            network_id = null,
+            descriptor_runId = null,
+            descriptor_revision = null,
+            run_id = null,
+        )
 }
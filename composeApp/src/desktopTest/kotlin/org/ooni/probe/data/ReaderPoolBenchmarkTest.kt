@@ -0,0 +1,149 @@
+package org.ooni.probe.data
+
+import org.ooni.probe.Database
+import java.nio.file.Files
+import java.util.concurrent.atomic.AtomicBoolean
+import kotlin.concurrent.thread
+import kotlin.test.Ignore
+import kotlin.test.Test
+
+/**
+ * Latency of the first page of the results screen while a test run keeps writing measurements,
+ * with the per-thread connections of the JDBC driver and with the writer and reader pool.
+ */
+@Ignore
+class ReaderPoolBenchmarkTest {
+    @Test
+    fun resultsPageWhileWritingBenchmark() {
+        println("results page latency while writing (median / p90 / max over $ITERS reads, ms)")
+        println("%-28s | %8s | %8s | %8s | %7s".format("driver", "median", "p90", "max", "writes"))
+        benchmark("per-thread connections", useReaderPool = false)
+        benchmark("writer + reader pool", useReaderPool = true)
+    }
+
+    private fun benchmark(
+        label: String,
+        useReaderPool: Boolean,
+    ) {
+        val folder = Files.createTempDirectory("reader_pool_bench").toFile()
+        val driver = buildDatabaseDriver(folder.absolutePath, useReaderPool)
+        try {
+            val database = Database(driver)
+            seedResults(database)
+
+            val isWriting = AtomicBoolean(true)
+            var writes = 0
+            val writer = thread {
+                var measurementId = 1L
+                while (isWriting.get()) {
+                    // Like a running test, a transaction for each few measurement updates
+                    database.transaction {
+                        repeat(WRITES_PER_TRANSACTION) {
+                            database.measurementQueries.insertTestMeasurement(measurementId++)
+                        }
+                    }
+                    writes += WRITES_PER_TRANSACTION
+                }
+            }
+
+            repeat(WARMUP) { readFirstPage(database) }
+            val times = DoubleArray(ITERS) {
+                val start = System.nanoTime()
+                readFirstPage(database)
+                (System.nanoTime() - start) / 1_000_000.0
+            }
+            isWriting.set(false)
+            writer.join()
+
+            times.sort()
+            println(
+                "%-28s | %8.3f | %8.3f | %8.3f | %7d".format(
+                    label,
+                    times[ITERS / 2],
+                    times[(ITERS * 0.9).toInt()],
+                    times.last(),
+                    writes,
+                ),
+            )
+        } finally {
+            driver.close()
+            folder.deleteRecursively()
+        }
+    }
+
+    private fun seedResults(database: Database) {
+        database.transaction {
+            for (id in 1L..RESULTS) {
+                database.resultQueries.insertOrReplace(
+                    id = id,
+                    descriptor_name = "websites",
+                    start_time = id,
+                    is_viewed = 1L,
+                    is_done = 1L,
+                    data_usage_up = 0L,
+                    data_usage_down = 0L,
+                    failure_msg = null,
+                    task_origin = "manual",
+                    network_id = null,
+                    descriptor_runId = null,
+                    descriptor_revision = null,
+                    run_id = null,
+                )
+            }
+        }
+    }
+
+    private fun readFirstPage(database: Database) =
+        database.resultQueries
+            .selectPageWithNetwork(
+                filterByDescriptors = 0,
+                descriptorsKeys = emptyList(),
+                filterByNetworks = 0,
+                networkIds = emptyList(),
+                filterByTaskOrigin = 0,
+                taskOrigin = null,
+                startFrom = 0,
+                startUntil = Long.MAX_VALUE,
+                hasAfter = 0,
+                afterStartTime = null,
+                afterId = 0,
+                hasUntil = 0,
+                untilStartTime = null,
+                untilId = 0,
+                limit = 100,
+            ).executeAsList()
+
+    private fun MeasurementQueries.insertTestMeasurement(id: Long) =
+        insertOrReplace(
+            id = id,
+            test_name = "web_connectivity",
+            start_time = id,
+            runtime = 1.0,
+            is_done = 1L,
+            is_uploaded = 0L,
+            is_failed = 0L,
+            failure_msg = null,
+            is_upload_failed = 0L,
+            upload_failure_msg = null,
+            is_rerun = 0L,
+            is_anomaly = 0L,
+            report_id = null,
+            uid = null,
+            test_keys = null,
+            rerun_network = null,
+            url_id = null,
+            result_id = RESULTS,
+            verification_status = null,
+            report_segment = null,
+            report_offset = null,
+            report_length = null,
+            test_keys_summary = null,
+        )
+
+    private companion object {
+        const val RESULTS = 5_000L
+        const val WRITES_PER_TRANSACTION = 20
+        const val WARMUP = 20
+        const val ITERS = 200
+    }
+}
@@ -0,0 +1,117 @@
+package org.ooni.probe.data.disk
+
+import okio.ByteString.Companion.toByteString
+import okio.FileSystem
+import okio.IOException
+import okio.SYSTEM
+import org.ooni.probe.tools.MmdbDeltaGenerator
+import kotlin.random.Random
+import kotlin.test.AfterTest
+import kotlin.test.BeforeTest
+import kotlin.test.Test
+import kotlin.test.assertContentEquals
+import kotlin.test.assertEquals
+import kotlin.test.assertFailsWith
+import kotlin.test.assertFalse
+import kotlin.test.assertTrue
+
+class MmdbDeltaTest {
+    private val fileSystem = FileSystem.SYSTEM
+    private val testDir = FileSystem.SYSTEM_TEMPORARY_DIRECTORY.resolve("ooni_mmdb_delta")
+    private val source = testDir.resolve("20250801.mmdb")
+    private val delta = testDir.resolve("20250801-20250901-ip2country_as.mmdb.delta")
+    private val target = testDir.resolve("20250901.mmdb")
+
+    private val random = Random(2025)
+
+    // About the size of an ip2country_as database
+    private val previous = syntheticDatabase(8 * 1024 * 1024)
+    private val next = nextMonth(previous)
+
+    @BeforeTest
+    fun setUp() {
+        fileSystem.createDirectories(testDir)
+    }
+
+    @AfterTest
+    fun tearDown() {
+        fileSystem.deleteRecursively(testDir)
+    }
+
+    @Test
+    fun roundTrip() {
+        val deltaBytes = MmdbDeltaGenerator.create(previous, next)
+        fileSystem.write(source) { write(previous) }
+        fileSystem.write(delta) { write(deltaBytes) }
+
+        MmdbDelta.apply(fileSystem, source, delta, target, next.toByteString().sha256().hex())
+
+        assertContentEquals(next, fileSystem.read(target) { readByteArray() })
+        assertTrue(deltaBytes.size < next.size / 20, "delta of ${deltaBytes.size} bytes")
+        assertEquals(listOf(delta, source, target), fileSystem.list(testDir).sorted())
+    }
+
+    @Test
+    fun wrongSourceLeavesTargetUntouched() {
+        fileSystem.write(source) { write(next) }
+        fileSystem.write(delta) { write(MmdbDeltaGenerator.create(previous, next)) }
+        fileSystem.write(target) { writeUtf8("installed") }
+
+        assertFailsWith<IOException> { MmdbDelta.apply(fileSystem, source, delta, target) }
+
+        assertEquals("installed", fileSystem.read(target) { readUtf8() })
+        assertEquals(3, fileSystem.list(testDir).size)
+    }
+
+    @Test
+    fun unexpectedChecksumIsRejected() {
+        fileSystem.write(source) { write(previous) }
+        fileSystem.write(delta) { write(MmdbDeltaGenerator.create(previous, next)) }
+
+        assertFailsWith<IOException> {
+            MmdbDelta.apply(fileSystem, source, delta, target, expectedSha256 = "00".repeat(32))
+        }
+        assertFalse(fileSystem.exists(target))
+    }
+
+    @Test
+    fun corruptDeltaIsRejected() {
+        val deltaBytes = MmdbDeltaGenerator.create(previous, next)
+        deltaBytes[deltaBytes.size / 2] = (deltaBytes[deltaBytes.size / 2] + 1).toByte()
+        fileSystem.write(source) { write(previous) }
+        fileSystem.write(delta) { write(deltaBytes) }
+
+        assertFailsWith<IOException> { MmdbDelta.apply(fileSystem, source, delta, target) }
+        assertFalse(fileSystem.exists(target))
+    }
+
+    // A search tree of 24-bit records, a data section and the metadata, like an MMDB file
+    private fun syntheticDatabase(size: Int): ByteArray {
+        val treeSize = size / 2 / RECORD_SIZE * RECORD_SIZE
+        val tree = random.nextBytes(treeSize)
+        val data = ByteArray(size - treeSize - METADATA.size) { index ->
+            // Country codes and AS names repeat a lot
+            "US DE IT AS13335 Cloudflare AS15169 Google "[index % 43].code.toByte()
+        }
+        random.nextBytes(data.size / 4).copyInto(data, destinationOffset = data.size / 2)
+        return tree + data + METADATA
+    }
+
+    // A new month changes some records here and there, and adds networks to the data section
+    private fun nextMonth(database: ByteArray): ByteArray {
+        val updated = database.copyOf()
+        repeat(2_000) {
+            val record = random.nextInt(database.size / 2 / RECORD_SIZE) * RECORD_SIZE
+            random.nextBytes(RECORD_SIZE).copyInto(updated, destinationOffset = record)
+        }
+        val insertAt = database.size * 3 / 4
+        return updated.copyOfRange(0, insertAt) +
+            random.nextBytes(16 * 1024) +
+            updated.copyOfRange(insertAt, updated.size)
+    }
+
+    companion object {
+        private const val RECORD_SIZE = 3
+        private val METADATA = "«ÍïMaxMind.com build_epoch".encodeToByteArray()
+    }
+}
@@ -0,0 +1,143 @@
+package org.ooni.probe.domain
+
+import com.sun.net.httpserver.HttpServer
+import kotlinx.coroutines.test.runTest
+import okio.ByteString.Companion.toByteString
+import okio.FileSystem
+import okio.SYSTEM
+import java.net.InetSocketAddress
+import kotlin.random.Random
+import kotlin.test.AfterTest
+import kotlin.test.BeforeTest
+import kotlin.test.Test
+import kotlin.test.assertContentEquals
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertNull
+import kotlin.test.assertTrue
+
+class DownloadFileServerTest {
+    private val fileSystem = FileSystem.SYSTEM
+    private val testDir = FileSystem.SYSTEM_TEMPORARY_DIRECTORY.resolve("ooni_download")
+    private val target = testDir.resolve("20250801.mmdb")
+    private val partial = testDir.resolve("20250801.mmdb.part")
+
+    private val content = Random(42).nextBytes(300_000)
+    private val sha256 = content.toByteString().sha256().hex()
+
+    private var supportsRange = true
+    private val rangeHeaders = mutableListOf<String?>()
+    private lateinit var server: HttpServer
+
+    private val subject = DownloadFile(fileSystem = fileSystem, isOnline = { true })
+
+    @BeforeTest
+    fun setUp() {
+        server = HttpServer.create(InetSocketAddress("127.0.0.1", 0), 0)
+        server.createContext("/db.mmdb") { exchange ->
+            val range = exchange.requestHeaders.getFirst("Range")
+            rangeHeaders += range
+            val start = range
+                ?.takeIf { supportsRange }
+                ?.removePrefix("bytes=")
+                ?.removeSuffix("-")
+                ?.toInt()
+            exchange.use {
+                when {
+                    start == null -> {
+                        exchange.sendResponseHeaders(200, content.size.toLong())
+                        exchange.responseBody.write(content)
+                    }
+
+                    start >= content.size -> exchange.sendResponseHeaders(416, -1)
+
+                    else -> {
+                        exchange.responseHeaders.add(
+                            "Content-Range",
+                            "bytes $start-${content.size - 1}/${content.size}",
+                        )
+                        exchange.sendResponseHeaders(206, (content.size - start).toLong())
+                        exchange.responseBody.write(content, start, content.size - start)
+                    }
+                }
+            }
+        }
+        server.start()
+        fileSystem.createDirectories(testDir)
+    }
+
+    @AfterTest
+    fun tearDown() {
+        server.stop(0)
+        fileSystem.deleteRecursively(testDir)
+    }
+
+    @Test
+    fun downloadsWholeFile() =
+        runTest {
+            val result = subject(url, target.toString(), sha256)
+
+            assertEquals(target, result.get())
+            assertContentEquals(content, fileSystem.read(target) { readByteArray() })
+            assertFalse(fileSystem.exists(partial))
+            assertEquals(listOf<String?>(null), rangeHeaders)
+        }
+
+    @Test
+    fun resumesFromPartialFile() =
+        runTest {
+            fileSystem.write(partial) { write(content, 0, 100_000) }
+
+            val result = subject(url, target.toString(), sha256)
+
+            assertEquals(target, result.get())
+            assertContentEquals(content, fileSystem.read(target) { readByteArray() })
+            assertEquals(listOf<String?>("bytes=100000-"), rangeHeaders)
+        }
+
+    @Test
+    fun completePartialFileIsVerifiedAndMoved() =
+        runTest {
+            fileSystem.write(partial) { write(content) }
+
+            val result = subject(url, target.toString(), sha256)
+
+            assertEquals(target, result.get())
+            assertFalse(fileSystem.exists(partial))
+        }
+
+    @Test
+    fun restartsWhenServerIgnoresRange() =
+        runTest {
+            supportsRange = false
+            fileSystem.write(partial) { write(content, 0, 100_000) }
+
+            val result = subject(url, target.toString(), sha256)
+
+            assertEquals(target, result.get())
+            assertContentEquals(content, fileSystem.read(target) { readByteArray() })
+        }
+
+    @Test
+    fun checksumMismatchDeletesPartialFile() =
+        runTest {
+            val result = subject(url, target.toString(), "00".repeat(32))
+
+            assertNull(result.get())
+            assertFalse(fileSystem.exists(partial))
+            assertFalse(fileSystem.exists(target))
+        }
+
+    @Test
+    fun failedDownloadKeepsTheExistingTarget() =
+        runTest {
+            fileSystem.write(target) { writeUtf8("previous") }
+
+            val result = subject("http://127.0.0.1:${server.address.port}/missing.mmdb", target.toString())
+
+            assertTrue(result.getError() != null)
+            assertEquals("previous", fileSystem.read(target) { readUtf8() })
+        }
+
+    private val url get() = "http://127.0.0.1:${server.address.port}/db.mmdb"
+}
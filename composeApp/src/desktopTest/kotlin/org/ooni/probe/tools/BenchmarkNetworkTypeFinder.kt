@@ -0,0 +1,47 @@
+package org.ooni.probe.tools
+
+import org.ooni.engine.DesktopNetworkTypeFinder
+import org.ooni.shared.DesktopBridgeLoader
+import kotlin.system.exitProcess
+
+/**
+ * Measures what the app pays per [DesktopNetworkTypeFinder] call on this machine: the JNI
+ * crossing, reading the snapshot kept by the native network monitor and turning it into Kotlin
+ * objects. The classifier itself, on generated topologies or live rtnetlink dumps, is measured by
+ * `make -C desktopApp/src/main bench-linux`. Build the bridge first with `make -C desktopApp/src/main`:
+ *
+ *     ./gradlew :composeApp:benchmarkNetworkTypeFinder --args="[iterations]"
+ */
+fun main(args: Array<String>) {
+    if (!DesktopBridgeLoader.ensureLoaded()) {
+        System.err.println("desktopbridge not found, build it with make -C desktopApp/src/main")
+        exitProcess(1)
+    }
+    val iterations = args.firstOrNull()?.toIntOrNull() ?: DEFAULT_ITERATIONS
+    val subject = DesktopNetworkTypeFinder()
+    println("network: ${subject.snapshot()}")
+    timeRow("invoke", iterations) { subject() }
+    timeRow("snapshot", iterations) { subject.snapshot() }
+}
+
+private fun timeRow(
+    label: String,
+    iterations: Int,
+    call: () -> Unit,
+) {
+    repeat(WARMUP_ITERATIONS) { call() }
+    val times = DoubleArray(iterations)
+    for (i in 0 until iterations) {
+        val start = System.nanoTime()
+        call()
+        times[i] = (System.nanoTime() - start) / 1_000.0
+    }
+    times.sort()
+    println(
+        "%-10s | p50 %9.1f us | p99 %9.1f us | max %9.1f us"
+            .format(label, times[iterations / 2], times[(iterations * 0.99).toInt()], times.last()),
+    )
+}
+
+private const val WARMUP_ITERATIONS = 2_000
+private const val DEFAULT_ITERATIONS = 20_000
@@ -0,0 +1,146 @@
+package org.ooni.probe.tools
+
+import okio.Buffer
+import okio.BufferedSink
+import okio.ByteString.Companion.toByteString
+import okio.Deflater
+import okio.DeflaterSink
+import okio.FileSystem
+import okio.Path.Companion.toPath
+import okio.SYSTEM
+import okio.buffer
+import okio.use
+import org.ooni.probe.data.disk.MmdbDelta
+import kotlin.system.exitProcess
+
+/**
+ * Generates the delta between two GeoIP databases, to publish next to the newer one as
+ * `<from>-<to>-ip2country_as.mmdb.delta`:
+ *
+ *     ./gradlew :composeApp:generateMmdbDelta --args="<from.mmdb> <to.mmdb> <output.delta>"
+ */
+fun main(args: Array<String>) {
+    if (args.size != 3) {
+        System.err.println("Usage: generateMmdbDelta <from.mmdb> <to.mmdb> <output.delta>")
+        exitProcess(1)
+    }
+    val fileSystem = FileSystem.SYSTEM
+    val (from, to, output) = args.map { it.toPath() }
+    val delta = MmdbDeltaGenerator.create(
+        source = fileSystem.read(from) { readByteArray() },
+        target = fileSystem.read(to) { readByteArray() },
+    )
+    fileSystem.write(output) { write(delta) }
+    println("${delta.size} bytes, sha256:${delta.toByteString().sha256().hex()}")
+}
+
+/**
+ * Finds the blocks of the target that are already in the source, rsync-style: the source is
+ * indexed by the hash of each aligned block, and a rolling hash over the target looks them up at
+ * every offset. Matches are extended byte by byte and become copies, everything else is inserted.
+ */
+object MmdbDeltaGenerator {
+    private const val BLOCK_SIZE = 32
+    private const val PRIME = 31
+
+    fun create(
+        source: ByteArray,
+        target: ByteArray,
+    ): ByteArray {
+        val output = Buffer()
+        MmdbDelta.writeHeader(
+            output,
+            MmdbDelta.Header(
+                sourceSha256 = source.toByteString().sha256(),
+                targetSize = target.size.toLong(),
+                targetSha256 = target.toByteString().sha256(),
+            ),
+        )
+        DeflaterSink(output, Deflater()).buffer().use { writeOperations(source, target, it) }
+        return output.readByteArray()
+    }
+
+    private fun writeOperations(
+        source: ByteArray,
+        target: ByteArray,
+        output: BufferedSink,
+    ) {
+        val index = HashMap<Int, Int>(source.size / BLOCK_SIZE + 1)
+        for (offset in 0..source.size - BLOCK_SIZE step BLOCK_SIZE) {
+            index.putIfAbsent(hash(source, offset), offset)
+        }
+        // PRIME^(BLOCK_SIZE - 1), to drop the outgoing byte from the rolling hash
+        val outFactor = (1 until BLOCK_SIZE).fold(1) { acc, _ -> acc * PRIME }
+
+        var insertStart = 0
+        var position = 0
+        var rolling = if (target.size >= BLOCK_SIZE) hash(target, 0) else 0
+        while (position + BLOCK_SIZE <= target.size) {
+            val match = index[rolling]?.takeIf { matches(source, it, target, position, BLOCK_SIZE) }
+            if (match == null) {
+                if (position + BLOCK_SIZE < target.size) {
+                    rolling = (rolling - target.unsigned(position) * outFactor) * PRIME +
+                        target.unsigned(position + BLOCK_SIZE)
+                }
+                position++
+                continue
+            }
+
+            var sourceStart = match
+            var targetStart = position
+            while (targetStart > insertStart && sourceStart > 0 &&
+                source[sourceStart - 1] == target[targetStart - 1]
+            ) {
+                sourceStart--
+                targetStart--
+            }
+            var length = position - targetStart + BLOCK_SIZE
+            while (sourceStart + length < source.size && targetStart + length < target.size &&
+                source[sourceStart + length] == target[targetStart + length]
+            ) {
+                length++
+            }
+
+            output.writeInsert(target, insertStart, targetStart)
+            output.writeByte(MmdbDelta.OP_COPY)
+            output.writeLong(sourceStart.toLong())
+            output.writeInt(length)
+
+            position = targetStart + length
+            insertStart = position
+            if (position + BLOCK_SIZE <= target.size) rolling = hash(target, position)
+        }
+        output.writeInsert(target, insertStart, target.size)
+        output.writeByte(MmdbDelta.OP_END)
+    }
+
+    private fun BufferedSink.writeInsert(
+        target: ByteArray,
+        start: Int,
+        end: Int,
+    ) {
+        if (end <= start) return
+        writeByte(MmdbDelta.OP_INSERT)
+        writeInt(end - start)
+        write(target, start, end - start)
+    }
+
+    private fun hash(
+        bytes: ByteArray,
+        offset: Int,
+    ): Int {
+        var hash = 0
+        for (i in offset until offset + BLOCK_SIZE) hash = hash * PRIME + bytes.unsigned(i)
+        return hash
+    }
+
+    private fun matches(
+        a: ByteArray,
+        aOffset: Int,
+        b: ByteArray,
+        bOffset: Int,
+        length: Int,
+    ) = (0 until length).all { a[aOffset + it] == b[bOffset + it] }
+
+    private fun ByteArray.unsigned(index: Int) = this[index].toInt() and 0xff
+}
@@ -0,0 +1,189 @@
+// clock_gettime under strict C11
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "LogRingBuffer.h"
+
+#include <string.h>
+
+#ifndef _WIN32
+#include <time.h>
+#endif
+
+#define LOG_RING_MASK (LOG_RING_CAPACITY - 1)
+
+static int64_t wall_clock_ms(void) {
+#ifdef _WIN32
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    // 100 ns intervals since 1601-01-01
+    int64_t ticks = ((int64_t)now.dwHighDateTime << 32) | now.dwLowDateTime;
+    return ticks / 10000 - 11644473600000LL;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+#endif
+}
+
+static uint16_t copy_text(char* dst, size_t size, const char* src) {
+    size_t length = src != NULL ? strlen(src) : 0;
+    if (length < size) {
+        if (length > 0) memcpy(dst, src, length);
+        dst[length] = '\0';
+        return (uint16_t)length;
+    }
+    // Room for the mark, without splitting a multi-byte character (continuation bytes are 10xxxxxx)
+    size_t mark_length = sizeof(LOG_RECORD_TRUNCATION_MARK) - 1;
+    length = size - 1 - mark_length;
+    while (length > 0 && ((unsigned char)src[length] & 0xC0) == 0x80) length--;
+    memcpy(dst, src, length);
+    memcpy(dst + length, LOG_RECORD_TRUNCATION_MARK, mark_length + 1);
+    return (uint16_t)(length + mark_length);
+}
+
+static bool has_record(struct log_ring* ring) {
+    struct log_ring_slot* slot = &ring->slots[ring->dequeue_position & LOG_RING_MASK];
+    return atomic_load_explicit(&slot->sequence, memory_order_acquire) == ring->dequeue_position + 1;
+}
+
+static void lock_ring(struct log_ring* ring) {
+#ifdef _WIN32
+    AcquireSRWLockExclusive(&ring->lock);
+#else
+    pthread_mutex_lock(&ring->lock);
+#endif
+}
+
+static void unlock_ring(struct log_ring* ring) {
+#ifdef _WIN32
+    ReleaseSRWLockExclusive(&ring->lock);
+#else
+    pthread_mutex_unlock(&ring->lock);
+#endif
+}
+
+static void signal_ring(struct log_ring* ring) {
+    lock_ring(ring);
+#ifdef _WIN32
+    WakeConditionVariable(&ring->records_available);
+#else
+    pthread_cond_signal(&ring->records_available);
+#endif
+    unlock_ring(ring);
+}
+
+void log_ring_init(struct log_ring* ring) {
+    for (size_t i = 0; i < LOG_RING_CAPACITY; i++) {
+        atomic_init(&ring->slots[i].sequence, i);
+    }
+    atomic_init(&ring->enqueue_position, 0);
+    ring->dequeue_position = 0;
+    atomic_flag_clear(&ring->draining);
+    atomic_init(&ring->dropped, 0);
+    atomic_init(&ring->waiting, false);
+    ring->woken = false;
+#ifdef _WIN32
+    InitializeSRWLock(&ring->lock);
+    InitializeConditionVariable(&ring->records_available);
+#else
+    pthread_mutex_init(&ring->lock, NULL);
+    pthread_cond_init(&ring->records_available, NULL);
+#endif
+}
+
+bool log_ring_push(struct log_ring* ring, int32_t level, const char* operation, const char* message) {
+    struct log_ring_slot* slot;
+    size_t position = atomic_load_explicit(&ring->enqueue_position, memory_order_relaxed);
+    for (;;) {
+        slot = &ring->slots[position & LOG_RING_MASK];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+        if (difference == 0) {
+            // Free slot: claim it, or retry from wherever the winner left the position
+            if (atomic_compare_exchange_weak_explicit(&ring->enqueue_position, &position, position + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            // The consumer hasn't freed this slot yet: the ring is full
+            atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+            return false;
+        } else {
+            position = atomic_load_explicit(&ring->enqueue_position, memory_order_relaxed);
+        }
+    }
+
+    struct log_record* record = &slot->record;
+    record->timestamp_ms = wall_clock_ms();
+    record->level = level;
+    record->operation_length = copy_text(record->operation, sizeof(record->operation), operation);
+    record->message_length = copy_text(record->message, sizeof(record->message), message);
+    atomic_store_explicit(&slot->sequence, position + 1, memory_order_release);
+    // Pairs with the fence in log_ring_wait: either the consumer sees this record
+    // before sleeping, or this producer sees it waiting
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&ring->waiting, memory_order_relaxed)) signal_ring(ring);
+    return true;
+}
+
+size_t log_ring_drain(struct log_ring* ring, struct log_record* out, size_t max_records) {
+    if (atomic_flag_test_and_set_explicit(&ring->draining, memory_order_acquire)) {
+        return 0;
+    }
+    size_t count = 0;
+    while (count < max_records) {
+        size_t position = ring->dequeue_position;
+        struct log_ring_slot* slot = &ring->slots[position & LOG_RING_MASK];
+        if (atomic_load_explicit(&slot->sequence, memory_order_acquire) != position + 1) {
+            break;
+        }
+        out[count++] = slot->record;
+        // Hand the slot back to producers for the next lap
+        atomic_store_explicit(&slot->sequence, position + LOG_RING_CAPACITY, memory_order_release);
+        ring->dequeue_position = position + 1;
+    }
+    atomic_flag_clear_explicit(&ring->draining, memory_order_release);
+    return count;
+}
+
+bool log_ring_wait(struct log_ring* ring, int32_t timeout_ms) {
+    lock_ring(ring);
+    atomic_store_explicit(&ring->waiting, true, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    if (!has_record(ring) && !ring->woken) {
+#ifdef _WIN32
+        SleepConditionVariableSRW(&ring->records_available, &ring->lock, (DWORD)timeout_ms, 0);
+#else
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&ring->records_available, &ring->lock, &deadline);
+#endif
+    }
+    atomic_store_explicit(&ring->waiting, false, memory_order_relaxed);
+    ring->woken = false;
+    unlock_ring(ring);
+    return has_record(ring);
+}
+
+void log_ring_wake(struct log_ring* ring) {
+    lock_ring(ring);
+    ring->woken = true;
+#ifdef _WIN32
+    WakeConditionVariable(&ring->records_available);
+#else
+    pthread_cond_signal(&ring->records_available);
+#endif
+    unlock_ring(ring);
+}
+
+uint64_t log_ring_dropped(struct log_ring* ring) {
+    return atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+}
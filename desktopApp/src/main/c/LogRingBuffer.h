@@ -0,0 +1,111 @@
+#ifndef LogRingBuffer_h
+#define LogRingBuffer_h
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LOG_RECORD_OPERATION_SIZE 32
+#define LOG_RECORD_MESSAGE_SIZE 464
+// Ends the text of truncated operations and messages: U+2026 in UTF-8
+#define LOG_RECORD_TRUNCATION_MARK "\xE2\x80\xA6"
+// Must be a power of two
+#define LOG_RING_CAPACITY 256
+
+/**
+ * Fixed-size log record, 512 bytes, copied as-is into the drain buffer in
+ * native byte order. Keep the layout in sync with UpdateLogDrain.kt.
+ * Longer operations and messages are cut on a UTF-8 character boundary and
+ * end with LOG_RECORD_TRUNCATION_MARK.
+ */
+struct log_record {
+    // Wall clock time of the log call, in milliseconds since the epoch
+    int64_t timestamp_ms;
+    int32_t level;
+    uint16_t operation_length;
+    uint16_t message_length;
+    char operation[LOG_RECORD_OPERATION_SIZE];
+    char message[LOG_RECORD_MESSAGE_SIZE];
+};
+
+struct log_ring_slot {
+    // Equals the enqueue position when the slot is free, that position + 1 once filled
+    atomic_size_t sequence;
+    struct log_record record;
+};
+
+/**
+ * Bounded multi-producer single-consumer queue of log records. Producers never
+ * allocate, and only take a lock to wake a consumer sleeping in log_ring_wait:
+ * when the ring is full the record is dropped and counted.
+ */
+struct log_ring {
+    struct log_ring_slot slots[LOG_RING_CAPACITY];
+    atomic_size_t enqueue_position;
+    size_t dequeue_position;
+    // Only one drain runs at a time, concurrent callers get nothing
+    atomic_flag draining;
+    atomic_uint_least64_t dropped;
+    // Set while the consumer sleeps in log_ring_wait, so producers only take
+    // the lock to wake it then, not for every record
+    atomic_bool waiting;
+    bool woken;
+#ifdef _WIN32
+    SRWLOCK lock;
+    CONDITION_VARIABLE records_available;
+#else
+    pthread_mutex_t lock;
+    pthread_cond_t records_available;
+#endif
+};
+
+/**
+ * Prepares an empty ring. Must run before any producer or consumer uses it.
+ */
+void log_ring_init(struct log_ring* ring);
+
+/**
+ * Queues a record, from any thread.
+ * @return false if the ring was full and the record was dropped
+ */
+bool log_ring_push(struct log_ring* ring, int32_t level, const char* operation, const char* message);
+
+/**
+ * Moves up to max_records records, oldest first, into out.
+ * @return the number of records copied
+ */
+size_t log_ring_drain(struct log_ring* ring, struct log_record* out, size_t max_records);
+
+/**
+ * Blocks the consumer until a record is queued, log_ring_wake is called or
+ * timeout_ms elapse.
+ * @return true if records are waiting to be drained
+ */
+bool log_ring_wait(struct log_ring* ring, int32_t timeout_ms);
+
+/**
+ * Makes the current or next log_ring_wait call return right away.
+ */
+void log_ring_wake(struct log_ring* ring);
+
+/**
+ * Number of records dropped because the ring was full, since init.
+ */
+uint64_t log_ring_dropped(struct log_ring* ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
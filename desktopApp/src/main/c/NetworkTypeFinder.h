@@ -2,12 +2,69 @@
 #define NetworkTypeFinder_h
 
 #include <jni.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-JNIEXPORT jstring JNICALL Java_org_ooni_engine_MacOsNetworkTypeFinder_getNetworkType(JNIEnv *env, jobject obj);
+// Classifies the current network: "vpn", "wifi", "mobile", "wired_ethernet",
+// "no_internet" or "unknown"
+const char* getNetworkTypeImpl(void);
+
+// Network types, in the order of their names above. Also used by DesktopNetworkTypeFinder.kt.
+enum network_type {
+    NETWORK_TYPE_UNKNOWN,
+    NETWORK_TYPE_VPN,
+    NETWORK_TYPE_WIFI,
+    NETWORK_TYPE_MOBILE,
+    NETWORK_TYPE_WIRED_ETHERNET,
+    NETWORK_TYPE_NO_INTERNET,
+};
+
+enum network_vpn_kind {
+    NETWORK_VPN_NONE,
+    NETWORK_VPN_WIREGUARD,
+    NETWORK_VPN_TUN,
+    NETWORK_VPN_PPP,
+    NETWORK_VPN_IPSEC,
+    NETWORK_VPN_OTHER,
+};
+
+#define NETWORK_SNAPSHOT_IPV6_DEFAULT_ROUTE 0x1
+#define NETWORK_SNAPSHOT_METERED 0x2
+
+// Everything known about the current network, copied as-is into a direct
+// ByteBuffer in native byte order, 48 bytes with the tail padding. Keep the
+// layout in sync with DesktopNetworkTypeFinder.kt.
+struct network_snapshot {
+    // Bumped every time any other field changes
+    int64_t generation;
+    int32_t type;
+    int32_t vpn_kind;
+    // 0 when unknown
+    int32_t mtu;
+    int32_t flags;
+    // NETWORK_SNAPSHOT_* bits of flags the platform actually determined. The
+    // others are unknown, not false.
+    int32_t known_flags;
+    // Interface carrying the traffic (the VPN one when connected), NUL-terminated
+    char interface_name[16];
+};
+
+// Fills the snapshot of the current network
+void getNetworkSnapshotImpl(struct network_snapshot *snapshot);
+
+#if defined(__linux__) && defined(NETWORK_TYPE_FINDER_TESTING)
+// Reads /sys and /proc below root instead of the real system (NULL or "" to reset)
+void setNetworkTypeFinderRoot(const char *root);
+
+// Classifies right away, bypassing the snapshot kept by the netlink monitor
+void classifyNetworkImpl(struct network_snapshot *snapshot);
+#endif
+
+JNIEXPORT jstring JNICALL Java_org_ooni_engine_DesktopNetworkTypeFinder_getNetworkType(JNIEnv *env, jobject obj);
+JNIEXPORT jint JNICALL Java_org_ooni_engine_DesktopNetworkTypeFinder_nativeGetNetworkSnapshot(JNIEnv *env, jobject obj, jobject buffer);
 
 #ifdef __cplusplus
 }
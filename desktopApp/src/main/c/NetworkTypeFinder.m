@@ -1,13 +1,138 @@
 #import <jni.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "NetworkTypeFinder.h"
+
+// Indexed by enum network_type. The classifiers only ever return these literals,
+// so callers never have to free the result.
+static const char *const network_type_names[] = {
+    "unknown", "vpn", "wifi", "mobile", "wired_ethernet", "no_internet",
+};
+
+#if defined(__APPLE__) || defined(_WIN32)
+// The Apple and Windows classifiers return names, the Linux one the enum itself
+static enum network_type network_type_of(const char *name) {
+    for (size_t i = 0; i < sizeof(network_type_names) / sizeof(network_type_names[0]); i++) {
+        if (strcmp(network_type_names[i], name) == 0) return (enum network_type)i;
+    }
+    return NETWORK_TYPE_UNKNOWN;
+}
+#endif
+
+// Carries the generation over from the previous snapshot, bumping it when any
+// other field changed. Snapshots are zeroed before being filled, so memcmp is safe.
+static void network_snapshot_stamp(const struct network_snapshot *previous, struct network_snapshot *next) {
+    size_t offset = offsetof(struct network_snapshot, type);
+    next->generation = previous->generation;
+    if (memcmp((const char *)previous + offset, (const char *)next + offset, sizeof(*next) - offset) != 0) {
+        next->generation++;
+    }
+}
+
+#if defined(__APPLE__) || defined(__linux__)
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+// Kotlin listener notified when the classified network type changes
+static JavaVM* g_jvm = NULL;
+static jobject g_networkCallbackObject = NULL;
+static jmethodID g_networkCallbackMethod = NULL;
+static pthread_mutex_t g_networkCallbackLock = PTHREAD_MUTEX_INITIALIZER;
+static char g_lastNotifiedType[32] = "";
+
+#if defined(__APPLE__)
+static bool has_network_change_callback(void) {
+    pthread_mutex_lock(&g_networkCallbackLock);
+    bool registered = g_networkCallbackObject != NULL;
+    pthread_mutex_unlock(&g_networkCallbackLock);
+    return registered;
+}
+#endif
+
+// Threads delivering notifications (the Linux monitor thread, the path monitor's
+// dispatch queue threads) are attached to the JVM the first time they notify and
+// stay attached until they exit, like the updater threads in UpdateBridge.c
+static pthread_key_t g_attachedEnvKey;
+static bool g_attachedEnvKeyCreated = false;
+static pthread_once_t g_attachedEnvOnce = PTHREAD_ONCE_INIT;
+
+static void detach_current_thread(void *env) {
+    if (env != NULL && g_jvm != NULL) {
+        (*g_jvm)->DetachCurrentThread(g_jvm);
+    }
+}
+
+static void create_attached_env_key(void) {
+    g_attachedEnvKeyCreated = pthread_key_create(&g_attachedEnvKey, detach_current_thread) == 0;
+}
+
+// Returns the JNIEnv of the current thread, attaching it as a daemon the first time
+static JNIEnv *current_thread_env(JavaVM *jvm) {
+    JNIEnv *env = NULL;
+    jint status = (*jvm)->GetEnv(jvm, (void **)&env, JNI_VERSION_1_6);
+    if (status == JNI_OK) return env;
+    if (status != JNI_EDETACHED || (*jvm)->AttachCurrentThreadAsDaemon(jvm, (void **)&env, NULL) != JNI_OK) {
+        return NULL;
+    }
+    pthread_once(&g_attachedEnvOnce, create_attached_env_key);
+    if (!g_attachedEnvKeyCreated || pthread_setspecific(g_attachedEnvKey, env) != 0) {
+        // Nothing would detach the thread at exit, so don't keep it attached
+        (*jvm)->DetachCurrentThread(jvm);
+        return NULL;
+    }
+    return env;
+}
+
+// Forwards the network type to Java, only if it differs from the last one sent
+static void notify_network_type_changed(const char* networkType) {
+    pthread_mutex_lock(&g_networkCallbackLock);
+    JavaVM *jvm = g_jvm;
+    bool registered = g_networkCallbackObject != NULL && strcmp(g_lastNotifiedType, networkType) != 0;
+    pthread_mutex_unlock(&g_networkCallbackLock);
+    if (jvm == NULL || !registered) return;
+
+    // Attaching can be slow, so it happens before taking the lock
+    JNIEnv* env = current_thread_env(jvm);
+    if (env == NULL) return;
+
+    pthread_mutex_lock(&g_networkCallbackLock);
+    // The callback might have been replaced or cleared in the meantime
+    if (g_networkCallbackObject == NULL || g_networkCallbackMethod == NULL ||
+        strcmp(g_lastNotifiedType, networkType) == 0) {
+        pthread_mutex_unlock(&g_networkCallbackLock);
+        return;
+    }
+    snprintf(g_lastNotifiedType, sizeof(g_lastNotifiedType), "%s", networkType);
+
+    jstring jNetworkType = (*env)->NewStringUTF(env, networkType);
+    if (jNetworkType != NULL) {
+        (*env)->CallVoidMethod(env, g_networkCallbackObject, g_networkCallbackMethod, jNetworkType);
+        if ((*env)->ExceptionCheck(env)) {
+            (*env)->ExceptionClear(env);
+        }
+        (*env)->DeleteLocalRef(env, jNetworkType);
+    }
+    pthread_mutex_unlock(&g_networkCallbackLock);
+}
+#endif
+
 #if defined(__APPLE__)
 #import <Foundation/Foundation.h>
 #import <SystemConfiguration/SystemConfiguration.h>
 #import <NetworkExtension/NetworkExtension.h>
 #import <Network/Network.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
 
 @interface NetworkTypeFinder : NSObject
 - (NSString *)getNetworkType;
 - (BOOL)isVpnActive;
+- (enum network_vpn_kind)activeVpnKind;
+- (void)fillSnapshot:(struct network_snapshot *)snapshot;
 @end
 
 @implementation NetworkTypeFinder {
@@ -28,6 +153,12 @@
                 nw_release(self->_currentPath);
             }
             self->_currentPath = nw_retain(path);
+
+            if (has_network_change_callback()) {
+                @autoreleasepool {
+                    notify_network_type_changed([[self getNetworkType] UTF8String]);
+                }
+            }
         });
 
         nw_path_monitor_start(_pathMonitor);
@@ -47,12 +178,18 @@
 }
 
 - (NSString *)getNetworkType {
+    nw_path_t currentPath = _currentPath;
+
+    // The path monitor already knows when there is no usable route, without any network I/O
+    if (currentPath && nw_path_get_status(currentPath) == nw_path_status_unsatisfied) {
+        return @"no_internet";
+    }
+
     if ([self isVpnActive]) {
         return @"vpn";
     }
 
     NSString *result = @"unknown";
-    nw_path_t currentPath = _currentPath;
     
     if (currentPath && nw_path_get_status(currentPath) == nw_path_status_satisfied) {
         if (nw_path_uses_interface_type(currentPath, nw_interface_type_wifi)) {
@@ -115,21 +252,28 @@
 }
 
 - (BOOL)isVpnActive {
+    return [self activeVpnKind] != NETWORK_VPN_NONE;
+}
+
+- (enum network_vpn_kind)activeVpnKind {
     NSDictionary *proxySettings = CFBridgingRelease(CFNetworkCopySystemProxySettings());
     NSDictionary *scoped = proxySettings[@"__SCOPED__"];
     NSArray *keys = scoped.allKeys;
 
-    NSArray *vpnProtocols = @[@"tap", @"tun", @"ppp", @"ipsec", @"utun"];
+    NSDictionary *vpnProtocols = @{
+        @"tap": @(NETWORK_VPN_TUN), @"tun": @(NETWORK_VPN_TUN), @"utun": @(NETWORK_VPN_TUN),
+        @"ppp": @(NETWORK_VPN_PPP), @"ipsec": @(NETWORK_VPN_IPSEC),
+    };
     for (NSString *key in keys) {
         for (NSString *protocol in vpnProtocols) {
             if ([key hasPrefix:protocol]) {
-                return YES;
+                return (enum network_vpn_kind)[vpnProtocols[protocol] intValue];
             }
         }
     }
     
     SCDynamicStoreRef store = SCDynamicStoreCreate(NULL, CFSTR("VPNCheck"), NULL, NULL);
-    if (!store) return NO;
+    if (!store) return NETWORK_VPN_NONE;
     
     CFPropertyListRef globalIPv4 = SCDynamicStoreCopyValue(store, CFSTR("State:/Network/Global/IPv4"));
     if (globalIPv4) {
@@ -142,32 +286,86 @@
                 CFRelease(vpnSettings);
                 CFRelease(globalIPv4);
                 CFRelease(store);
-                return YES;
+                return NETWORK_VPN_OTHER;
             }
         }
         CFRelease(globalIPv4);
     }
     CFRelease(store);
 
-    return NO;
+    return NETWORK_VPN_NONE;
+}
+
+- (void)fillSnapshot:(struct network_snapshot *)snapshot {
+    memset(snapshot, 0, sizeof(*snapshot));
+    snapshot->type = network_type_of([[self getNetworkType] UTF8String]);
+    if (snapshot->type == NETWORK_TYPE_VPN) {
+        snapshot->vpn_kind = [self activeVpnKind];
+    }
+
+    nw_path_t currentPath = _currentPath;
+    if (!currentPath || nw_path_get_status(currentPath) != nw_path_status_satisfied) return;
+    nw_retain(currentPath);
+    snapshot->known_flags = NETWORK_SNAPSHOT_IPV6_DEFAULT_ROUTE | NETWORK_SNAPSHOT_METERED;
+    if (nw_path_has_ipv6(currentPath)) snapshot->flags |= NETWORK_SNAPSHOT_IPV6_DEFAULT_ROUTE;
+    if (nw_path_is_expensive(currentPath)) snapshot->flags |= NETWORK_SNAPSHOT_METERED;
+    // Interfaces are enumerated in order of preference, the first one carries the traffic
+    nw_path_enumerate_interfaces(currentPath, ^bool(nw_interface_t interface) {
+        snprintf(snapshot->interface_name, sizeof(snapshot->interface_name), "%s", nw_interface_get_name(interface));
+        return false;
+    });
+    nw_release(currentPath);
+
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd >= 0 && snapshot->interface_name[0]) {
+        struct ifreq ifr;
+        memset(&ifr, 0, sizeof(ifr));
+        strlcpy(ifr.ifr_name, snapshot->interface_name, sizeof(ifr.ifr_name));
+        if (ioctl(fd, SIOCGIFMTU, &ifr) == 0) snapshot->mtu = ifr.ifr_mtu;
+    }
+    if (fd >= 0) close(fd);
 }
 @end
 
 static NetworkTypeFinder *sharedFinder = nil;
 
+static pthread_mutex_t g_snapshotLock = PTHREAD_MUTEX_INITIALIZER;
+static struct network_snapshot g_lastSnapshot;
+
+static NetworkTypeFinder *shared_finder(void) {
+    if (!sharedFinder) {
+        sharedFinder = [[NetworkTypeFinder alloc] init];
+        usleep(100000);
+    }
+    return sharedFinder;
+}
+
 const char* getNetworkTypeImpl() {
     @autoreleasepool {
-        if (!sharedFinder) {
-            sharedFinder = [[NetworkTypeFinder alloc] init];
-            usleep(100000);
-        }
-        NSString *networkType = [sharedFinder getNetworkType];
-        return strdup([networkType UTF8String]);
+        NSString *networkType = [shared_finder() getNetworkType];
+        return network_type_names[network_type_of([networkType UTF8String])];
+    }
+}
+
+void getNetworkSnapshotImpl(struct network_snapshot *snapshot) {
+    @autoreleasepool {
+        [shared_finder() fillSnapshot:snapshot];
     }
+    pthread_mutex_lock(&g_snapshotLock);
+    network_snapshot_stamp(&g_lastSnapshot, snapshot);
+    g_lastSnapshot = *snapshot;
+    pthread_mutex_unlock(&g_snapshotLock);
+}
+
+// The path monitor reports every change, so notifications are always available
+static bool network_change_notifications_supported(void) {
+    getNetworkTypeImpl();
+    return true;
 }
 #elif defined(_WIN32)
 
 #include <winsock2.h>
+#include <ws2tcpip.h>
 #include <iphlpapi.h>
 #include <stdio.h>
 #pragma comment(lib, "iphlpapi.lib")
@@ -179,12 +377,14 @@ const char* getNetworkTypeImpl() {
     ULONG outBufLen = 0;
     DWORD dwRetVal = 0;
     int found_vpn = 0, found_wifi = 0, found_wired = 0, found_mobile = 0;
+    int found_gateway = 0, found_global_address = 0;
+    ULONG flags = GAA_FLAG_INCLUDE_ALL_INTERFACES | GAA_FLAG_INCLUDE_GATEWAYS | GAA_FLAG_SKIP_DNS_SERVER | GAA_FLAG_SKIP_MULTICAST;
 
     // Get required buffer size
-    GetAdaptersAddresses(AF_UNSPEC, GAA_FLAG_INCLUDE_ALL_INTERFACES, NULL, adapters, &outBufLen);
+    GetAdaptersAddresses(AF_UNSPEC, flags, NULL, adapters, &outBufLen);
     adapters = (IP_ADAPTER_ADDRESSES*)malloc(outBufLen);
     if (!adapters) return "unknown";
-    dwRetVal = GetAdaptersAddresses(AF_UNSPEC, GAA_FLAG_INCLUDE_ALL_INTERFACES, NULL, adapters, &outBufLen);
+    dwRetVal = GetAdaptersAddresses(AF_UNSPEC, flags, NULL, adapters, &outBufLen);
     if (dwRetVal != NO_ERROR) {
         free(adapters);
         return "unknown";
@@ -194,6 +394,20 @@ const char* getNetworkTypeImpl() {
         // Skip loopback and not up
         if (adapter->OperStatus != IfOperStatusUp) continue;
         if (adapter->IfType == IF_TYPE_SOFTWARE_LOOPBACK) continue;
+        // Reachability hints for "no_internet": a default gateway, or a non link-local address
+        if (adapter->FirstGatewayAddress != NULL) {
+            found_gateway = 1;
+        }
+        for (IP_ADAPTER_UNICAST_ADDRESS *address = adapter->FirstUnicastAddress; address != NULL; address = address->Next) {
+            SOCKADDR *sa = address->Address.lpSockaddr;
+            if (sa->sa_family == AF_INET) {
+                unsigned char *ip = (unsigned char *)&((SOCKADDR_IN *)sa)->sin_addr;
+                if (!(ip[0] == 169 && ip[1] == 254)) found_global_address = 1;
+            } else if (sa->sa_family == AF_INET6) {
+                unsigned char *ip = ((SOCKADDR_IN6 *)sa)->sin6_addr.s6_addr;
+                if (!(ip[0] == 0xfe && (ip[1] & 0xc0) == 0x80)) found_global_address = 1;
+            }
+        }
         // VPN detection: name or description contains VPN, TAP, TUN, PPP, WAN Miniport
         if (adapter->IfType == IF_TYPE_PPP ||
             strstr(adapter->Description, "VPN") || strstr(adapter->Description, "TAP") || strstr(adapter->Description, "TUN") ||
@@ -218,11 +432,27 @@ const char* getNetworkTypeImpl() {
     }
     free(adapters);
     if (found_vpn) return "vpn";
+    if (!found_gateway && !found_global_address) return "no_internet";
     if (found_wifi) return "wifi";
     if (found_mobile) return "mobile";
     if (found_wired) return "wired_ethernet";
     return "unknown";
 }
+
+static SRWLOCK g_snapshotLock = SRWLOCK_INIT;
+static struct network_snapshot g_lastSnapshot;
+
+// Only the type is known here; the adapter list doesn't tell which tunnel protocol is in
+// use, nor whether the connection is metered, so no flag is known either
+void getNetworkSnapshotImpl(struct network_snapshot *snapshot) {
+    memset(snapshot, 0, sizeof(*snapshot));
+    snapshot->type = network_type_of(getNetworkTypeImpl());
+    if (snapshot->type == NETWORK_TYPE_VPN) snapshot->vpn_kind = NETWORK_VPN_OTHER;
+    AcquireSRWLockExclusive(&g_snapshotLock);
+    network_snapshot_stamp(&g_lastSnapshot, snapshot);
+    g_lastSnapshot = *snapshot;
+    ReleaseSRWLockExclusive(&g_snapshotLock);
+}
 #elif defined(__linux__)
 
 #include <string.h>
@@ -231,131 +461,699 @@ const char* getNetworkTypeImpl() {
 #include <dirent.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/socket.h>
 #include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
 #include <net/if.h>
 #include <arpa/inet.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
 #include <stdlib.h>
+#include <limits.h>
 #include <stdbool.h>
 
-// Helper to check if a given interface is a VPN
-static bool is_vpn_iface(const char *iface) {
-    return strncmp(iface, "tun", 3) == 0 || strncmp(iface, "tap", 3) == 0 ||
-           strncmp(iface, "ppp", 3) == 0 || strncmp(iface, "wg", 2) == 0 ||
-           strncmp(iface, "ipsec", 5) == 0 || strncmp(iface, "utun", 4) == 0;
+// From <linux/if.h>, which cannot be included together with <net/if.h>
+#ifndef IF_OPER_UP
+#define IF_OPER_UNKNOWN 0
+#define IF_OPER_UP 6
+#endif
+
+// Interface families, derived once from the name when the interface is loaded
+enum iface_kind {
+    IFACE_OTHER,
+    // Container, bridge and overlay plumbing, never the network the user is on
+    IFACE_VIRTUAL,
+    IFACE_VPN,
+    IFACE_MOBILE,
+    IFACE_WIRED,
+};
+
+// Link state and IPv4 presence of one interface, as reported by rtnetlink
+struct iface_info {
+    int index;
+    char name[IF_NAMESIZE];
+    enum iface_kind kind;
+    bool oper_up;
+    // Tunnels (tun, wg, ppp) have no carrier and stay in the "unknown" operstate
+    bool oper_unknown;
+    bool has_ipv4;
+    unsigned int mtu;
+};
+
+// All interfaces known to the kernel, loaded once per classification
+struct iface_table {
+    struct iface_info *items;
+    size_t count;
+    size_t capacity;
+    // Reachability hints: an IPv4 or IPv6 default route, and a global address
+    // on an interface that isn't container or bridge plumbing
+    bool has_default_route;
+    bool has_global_address;
+    bool has_ipv6_default_route;
+    // Interface of the preferred default route: IPv4 first, then lowest metric
+    int default_route_index;
+    unsigned char default_route_family;
+    unsigned int default_route_metric;
+};
+
+static bool has_prefix(const char *name, const char *prefix) {
+    return strncmp(name, prefix, strlen(prefix)) == 0;
 }
 
-// Helper to check if interface is up and has an IP address
-static bool iface_is_up_and_has_ip(const char *iface) {
-    char path[256];
-    snprintf(path, sizeof(path), "/sys/class/net/%s/operstate", iface);
-    FILE *fp = fopen(path, "r");
-    if (!fp) return false;
-    char state[32] = "";
-    fgets(state, sizeof(state), fp);
-    fclose(fp);
-    if (strncmp(state, "up", 2) != 0) return false;
-    // Check if has IP address
-    char cmd[256];
-    snprintf(cmd, sizeof(cmd), "ip addr show %s | grep 'inet ' > /dev/null", iface);
-    int ret = system(cmd);
-    return ret == 0;
+static enum iface_kind iface_kind_of(const char *name) {
+    // Checked first: Calico's "tunl0" IP-in-IP device would otherwise look like a "tun" VPN
+    static const char *virtual_prefixes[] = {
+        "veth", "cali", "tunl", "docker", "br-", "virbr", "vxlan", "flannel", "cni",
+        "lxc", "vnet", "kube", "cilium", "weave", "dummy",
+    };
+    if (strcmp(name, "lo") == 0) return IFACE_VIRTUAL;
+    for (size_t i = 0; i < sizeof(virtual_prefixes) / sizeof(virtual_prefixes[0]); i++) {
+        if (has_prefix(name, virtual_prefixes[i])) return IFACE_VIRTUAL;
+    }
+    if (has_prefix(name, "tun") || has_prefix(name, "tap") || has_prefix(name, "ppp") ||
+        has_prefix(name, "wg") || has_prefix(name, "ipsec") || has_prefix(name, "utun")) {
+        return IFACE_VPN;
+    }
+    if (has_prefix(name, "wwan")) return IFACE_MOBILE;
+    if (has_prefix(name, "eth") || has_prefix(name, "en")) return IFACE_WIRED;
+    return IFACE_OTHER;
 }
 
-const char* getNetworkTypeImpl() {
-    // 1. Check for VPN by looking for default route via VPN interface
-    FILE *route_fp = fopen("/proc/net/route", "r");
+static void iface_table_free(struct iface_table *table) {
+    free(table->items);
+    table->items = NULL;
+    table->count = 0;
+    table->capacity = 0;
+}
+
+static struct iface_info *iface_table_by_index(struct iface_table *table, int index) {
+    for (size_t i = 0; i < table->count; i++) {
+        if (table->items[i].index == index) return &table->items[i];
+    }
+    return NULL;
+}
+
+static struct iface_info *iface_table_by_name(struct iface_table *table, const char *name) {
+    for (size_t i = 0; i < table->count; i++) {
+        if (strcmp(table->items[i].name, name) == 0) return &table->items[i];
+    }
+    return NULL;
+}
+
+static void iface_table_add_default_route(struct iface_table *table, unsigned char family, int index,
+                                         unsigned int metric) {
+    table->has_default_route = true;
+    if (family == AF_INET6) table->has_ipv6_default_route = true;
+    if (index <= 0) return;
+    bool better = table->default_route_index == 0 ||
+                  (family == AF_INET && table->default_route_family != AF_INET) ||
+                  (family == table->default_route_family && metric < table->default_route_metric);
+    if (better) {
+        table->default_route_index = index;
+        table->default_route_family = family;
+        table->default_route_metric = metric;
+    }
+}
+
+// Returns a zeroed slot at the end of the table, which only counts once the caller commits it
+static struct iface_info *iface_table_next(struct iface_table *table) {
+    if (table->count == table->capacity) {
+        size_t capacity = table->capacity ? table->capacity * 2 : 32;
+        struct iface_info *items = realloc(table->items, capacity * sizeof(*items));
+        if (!items) return NULL;
+        table->items = items;
+        table->capacity = capacity;
+    }
+    struct iface_info *info = &table->items[table->count];
+    memset(info, 0, sizeof(*info));
+    return info;
+}
+
+static void iface_table_on_link(struct iface_table *table, struct nlmsghdr *nh) {
+    if (nh->nlmsg_type != RTM_NEWLINK) return;
+    struct ifinfomsg *ifi = NLMSG_DATA(nh);
+    struct iface_info *info = iface_table_next(table);
+    if (!info) return;
+    info->index = ifi->ifi_index;
+
+    int len = (int)IFLA_PAYLOAD(nh);
+    for (struct rtattr *rta = IFLA_RTA(ifi); RTA_OK(rta, len); rta = RTA_NEXT(rta, len)) {
+        if (rta->rta_type == IFLA_IFNAME) {
+            snprintf(info->name, sizeof(info->name), "%s", (const char *)RTA_DATA(rta));
+        } else if (rta->rta_type == IFLA_OPERSTATE) {
+            // Same value the kernel exposes as "up" in /sys/class/net/<iface>/operstate
+            unsigned char operstate = *(unsigned char *)RTA_DATA(rta);
+            info->oper_up = operstate == IF_OPER_UP;
+            info->oper_unknown = operstate == IF_OPER_UNKNOWN;
+        } else if (rta->rta_type == IFLA_MTU) {
+            info->mtu = *(unsigned int *)RTA_DATA(rta);
+        }
+    }
+    if (info->name[0]) {
+        info->kind = iface_kind_of(info->name);
+        table->count++;
+    }
+}
+
+static void iface_table_on_addr(struct iface_table *table, struct nlmsghdr *nh) {
+    if (nh->nlmsg_type != RTM_NEWADDR) return;
+    struct ifaddrmsg *ifa = NLMSG_DATA(nh);
+    struct iface_info *info = iface_table_by_index(table, (int)ifa->ifa_index);
+    if (!info) return;
+    if (ifa->ifa_family == AF_INET) info->has_ipv4 = true;
+    if (ifa->ifa_scope == RT_SCOPE_UNIVERSE && info->kind != IFACE_VIRTUAL) {
+        table->has_global_address = true;
+    }
+}
+
+static void iface_table_on_route(struct iface_table *table, struct nlmsghdr *nh) {
+    if (nh->nlmsg_type != RTM_NEWROUTE) return;
+    struct rtmsg *rtm = NLMSG_DATA(nh);
+    // Any routing table counts, since VPN clients often install their default route in their own
+    if (rtm->rtm_dst_len != 0 || rtm->rtm_type != RTN_UNICAST) return;
+    int index = 0;
+    unsigned int metric = 0;
+    int len = (int)RTM_PAYLOAD(nh);
+    for (struct rtattr *rta = RTM_RTA(rtm); RTA_OK(rta, len); rta = RTA_NEXT(rta, len)) {
+        if (rta->rta_type == RTA_OIF) index = *(int *)RTA_DATA(rta);
+        else if (rta->rta_type == RTA_PRIORITY) metric = *(unsigned int *)RTA_DATA(rta);
+    }
+    iface_table_add_default_route(table, rtm->rtm_family, index, metric);
+}
+
+// Upper bound for all the rtnetlink dumps of one classification, so a stalled
+// kernel reply can't block the caller
+#define NETLINK_DEADLINE_MS 250
+
+static long long monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Feeds the messages of one rtnetlink reply buffer to the handler, skipping the
+// ones of other requests (any seq when 0). Returns 1 at NLMSG_DONE, -1 on
+// NLMSG_ERROR and 0 when the dump continues in the next buffer.
+static int netlink_parse(const void *buf, int len, unsigned int seq, struct iface_table *table,
+                         void (*handler)(struct iface_table *, struct nlmsghdr *)) {
+    for (const struct nlmsghdr *nh = buf; NLMSG_OK(nh, len); nh = NLMSG_NEXT(nh, len)) {
+        if (seq != 0 && nh->nlmsg_seq != seq) continue;
+        if (nh->nlmsg_type == NLMSG_DONE) return 1;
+        if (nh->nlmsg_type == NLMSG_ERROR) return -1;
+        handler(table, (struct nlmsghdr *)nh);
+    }
+    return 0;
+}
+
+// Sends one rtnetlink dump request and feeds every reply message to the handler
+static bool netlink_dump(int fd, unsigned short type, unsigned char family, unsigned int seq,
+                         long long deadline, struct iface_table *table,
+                         void (*handler)(struct iface_table *, struct nlmsghdr *)) {
+    struct {
+        struct nlmsghdr nh;
+        struct rtgenmsg gen;
+    } req;
+    memset(&req, 0, sizeof(req));
+    req.nh.nlmsg_len = NLMSG_LENGTH(sizeof(struct rtgenmsg));
+    req.nh.nlmsg_type = type;
+    req.nh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    req.nh.nlmsg_seq = seq;
+    req.gen.rtgen_family = family;
+
+    struct sockaddr_nl kernel = { .nl_family = AF_NETLINK };
+    if (sendto(fd, &req, req.nh.nlmsg_len, 0, (struct sockaddr *)&kernel, sizeof(kernel)) < 0) {
+        return false;
+    }
+
+    char buf[16384] __attribute__((aligned(NLMSG_ALIGNTO)));
+    for (;;) {
+        long long remaining = deadline - monotonic_ms();
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        if (remaining <= 0 || poll(&pfd, 1, (int)remaining) <= 0) return false;
+        ssize_t len = recv(fd, buf, sizeof(buf), 0);
+        if (len <= 0) return false;
+        int status = netlink_parse(buf, (int)len, seq, table, handler);
+        if (status != 0) return status > 0;
+    }
+}
+
+// Prefix prepended to every /proc and /sys path. Only set by the native tests
+// and benchmarks (NETWORK_TYPE_FINDER_TESTING), which also read the interface
+// table from that directory instead of rtnetlink to classify a fake topology.
+static char g_fs_root[256] = "";
+
+static const char *fs_path(char *buf, size_t size, const char *path) {
+    snprintf(buf, size, "%s%s", g_fs_root, path);
+    return buf;
+}
+
+#ifdef NETWORK_TYPE_FINDER_TESTING
+// Loads the interface table from a fake root: operstate from
+// <root>/sys/class/net/<iface>/operstate and addresses from <root>/ip-addr,
+// which holds the output of `ip -o addr` captured on the host being modelled
+static bool iface_table_load_fixture(struct iface_table *table) {
+    char path[512];
+    DIR *d = opendir(fs_path(path, sizeof(path), "/sys/class/net"));
+    if (!d) return false;
+    struct dirent *dir;
+    while ((dir = readdir(d)) != NULL) {
+        if (dir->d_name[0] == '.') continue;
+        struct iface_info *info = iface_table_next(table);
+        if (!info) break;
+        // Longer than any interface name, leave the slot for the next entry
+        if (snprintf(info->name, sizeof(info->name), "%s", dir->d_name) >= (int)sizeof(info->name)) continue;
+        info->index = (int)table->count + 1;
+        info->kind = iface_kind_of(info->name);
+        table->count++;
+        if (info->kind == IFACE_VIRTUAL) continue;
+
+        int length = snprintf(path, sizeof(path), "%s/sys/class/net/%s/operstate", g_fs_root, info->name);
+        FILE *fp = length < (int)sizeof(path) ? fopen(path, "r") : NULL;
+        if (fp) {
+            char state[32] = "";
+            fgets(state, sizeof(state), fp);
+            fclose(fp);
+            info->oper_up = strncmp(state, "up", 2) == 0;
+            info->oper_unknown = strncmp(state, "unknown", 7) == 0;
+        }
+
+        length = snprintf(path, sizeof(path), "%s/sys/class/net/%s/mtu", g_fs_root, info->name);
+        fp = length < (int)sizeof(path) ? fopen(path, "r") : NULL;
+        if (fp) {
+            if (fscanf(fp, "%u", &info->mtu) != 1) info->mtu = 0;
+            fclose(fp);
+        }
+    }
+    closedir(d);
+
     char line[512];
-    char vpn_iface[64] = "";
-    if (route_fp) {
-        // Skip header
-        fgets(line, sizeof(line), route_fp);
-        while (fgets(line, sizeof(line), route_fp)) {
+    FILE *fp = fopen(fs_path(path, sizeof(path), "/ip-addr"), "r");
+    if (fp) {
+        while (fgets(line, sizeof(line), fp)) {
+            char name[IF_NAMESIZE + 1], family[16], scope[16] = "";
+            if (sscanf(line, "%*d: %16s %15s", name, family) != 2) continue;
+            name[strcspn(name, "@:")] = '\0';
+            char *scope_field = strstr(line, " scope ");
+            if (scope_field) sscanf(scope_field, " scope %15s", scope);
+            struct iface_info *info = iface_table_by_name(table, name);
+            if (!info) continue;
+            if (strcmp(family, "inet") == 0) info->has_ipv4 = true;
+            if (strcmp(scope, "global") == 0 && info->kind != IFACE_VIRTUAL) table->has_global_address = true;
+        }
+        fclose(fp);
+    }
+
+    // Default routes: destination 0 in /proc/net/route, ::/0 in /proc/net/ipv6_route
+    fp = fopen(fs_path(path, sizeof(path), "/proc/net/route"), "r");
+    if (fp) {
+        fgets(line, sizeof(line), fp);
+        while (fgets(line, sizeof(line), fp)) {
             char iface[64];
-            unsigned long dest, gw;
-            unsigned int flags, refcnt, use, metric, mask, mtu, win, irtt;
-            int n = sscanf(line, "%63s %lx %lx %X %u %u %u %x %u %u %u", iface, &dest, &gw, &flags, &refcnt, &use, &metric, &mask, &mtu, &win, &irtt);
-            if (n >= 11 && dest == 0) { // default route
-                if (is_vpn_iface(iface) && iface_is_up_and_has_ip(iface)) {
-                    strcpy(vpn_iface, iface);
-                    break;
-                }
+            unsigned long dest;
+            unsigned int metric;
+            if (sscanf(line, "%63s %lx %*s %*s %*s %*s %u", iface, &dest, &metric) == 3 && dest == 0) {
+                struct iface_info *info = iface_table_by_name(table, iface);
+                iface_table_add_default_route(table, AF_INET, info ? info->index : 0, metric);
             }
         }
-        fclose(route_fp);
-    }
-    if (vpn_iface[0]) return "vpn";
-
-    // 2. Check for active WireGuard tunnels
-    struct stat st;
-    if (stat("/proc/net/wireguard", &st) == 0) {
-        FILE *wg_fp = fopen("/proc/net/wireguard", "r");
-        if (wg_fp) {
-            char buf[256];
-            while (fgets(buf, sizeof(buf), wg_fp)) {
-                char *iface = strtok(buf, " ");
-                if (iface && iface_is_up_and_has_ip(iface)) {
-                    fclose(wg_fp);
-                    return "vpn";
-                }
+        fclose(fp);
+    }
+    fp = fopen(fs_path(path, sizeof(path), "/proc/net/ipv6_route"), "r");
+    if (fp) {
+        while (fgets(line, sizeof(line), fp)) {
+            char dest[33], iface[64];
+            unsigned int dest_len, metric, flags;
+            // RTF_UP without RTF_REJECT: skips the unreachable default kept on lo
+            if (sscanf(line, "%32s %x %*s %*s %*s %x %*s %*s %x %63s", dest, &dest_len, &metric, &flags, iface) == 5 &&
+                dest_len == 0 && (flags & 0x0001) && !(flags & 0x0200)) {
+                struct iface_info *info = iface_table_by_name(table, iface);
+                iface_table_add_default_route(table, AF_INET6, info ? info->index : 0, metric);
             }
-            fclose(wg_fp);
         }
+        fclose(fp);
     }
+    return true;
+}
 
-    // 3. Check for active PPP connections
-    if (stat("/proc/net/ppp", &st) == 0) {
-        FILE *ppp_fp = fopen("/proc/net/ppp", "r");
-        if (ppp_fp) {
-            char buf[256];
-            // skip header
-            fgets(buf, sizeof(buf), ppp_fp);
-            while (fgets(buf, sizeof(buf), ppp_fp)) {
-                char *iface = strtok(buf, ":");
-                if (iface && iface_is_up_and_has_ip(iface)) {
-                    fclose(ppp_fp);
-                    return "vpn";
-                }
+// Feeds a dump captured from a real kernel, the reply messages saved as-is,
+// through the same parser and handlers as a live dump
+static bool netlink_load_capture(const char *relative, struct iface_table *table,
+                                 void (*handler)(struct iface_table *, struct nlmsghdr *)) {
+    char path[512];
+    FILE *fp = fopen(fs_path(path, sizeof(path), relative), "rb");
+    if (!fp) return false;
+    size_t capacity = 16384, len = 0, n;
+    char *buf = malloc(capacity);
+    while (buf && (n = fread(buf + len, 1, capacity - len, fp)) > 0) {
+        len += n;
+        if (len == capacity) {
+            char *grown = realloc(buf, capacity * 2);
+            if (!grown) {
+                free(buf);
+                buf = NULL;
+                break;
             }
-            fclose(ppp_fp);
+            buf = grown;
+            capacity *= 2;
         }
     }
+    fclose(fp);
+    // A capture that stops before NLMSG_DONE is as broken as a truncated live dump
+    bool ok = buf && len <= INT_MAX && netlink_parse(buf, (int)len, 0, table, handler) > 0;
+    free(buf);
+    return ok;
+}
 
-    // 4. Fallback: check for VPN interfaces present and up
-    DIR *d = opendir("/sys/class/net/");
-    if (!d) return "unknown";
-    struct dirent *dir;
-    int found_vpn = 0, found_wifi = 0, found_wired = 0, found_mobile = 0;
-    while ((dir = readdir(d)) != NULL) {
-        if (dir->d_name[0] == '.') continue;
-        if (is_vpn_iface(dir->d_name) && iface_is_up_and_has_ip(dir->d_name)) {
-            found_vpn = 1;
+// A fake root holds either rtnetlink dumps in <root>/netlink/{link,addr,route},
+// or the text files read by iface_table_load_fixture
+static bool iface_table_load_fake(struct iface_table *table) {
+    char path[512];
+    if (access(fs_path(path, sizeof(path), "/netlink/link"), F_OK) != 0) return iface_table_load_fixture(table);
+    return netlink_load_capture("/netlink/link", table, iface_table_on_link) &&
+           netlink_load_capture("/netlink/addr", table, iface_table_on_addr) &&
+           netlink_load_capture("/netlink/route", table, iface_table_on_route);
+}
+#endif
+
+// Loads link states, addresses and default routes with one RTM_GETLINK, one
+// RTM_GETADDR and one RTM_GETROUTE dump, instead of running `ip addr` per interface
+static bool iface_table_load(struct iface_table *table) {
+#ifdef NETWORK_TYPE_FINDER_TESTING
+    if (g_fs_root[0]) return iface_table_load_fake(table);
+#endif
+
+    int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd < 0) return false;
+
+    long long deadline = monotonic_ms() + NETLINK_DEADLINE_MS;
+    bool ok = netlink_dump(fd, RTM_GETLINK, AF_UNSPEC, 1, deadline, table, iface_table_on_link) &&
+              netlink_dump(fd, RTM_GETADDR, AF_UNSPEC, 2, deadline, table, iface_table_on_addr) &&
+              netlink_dump(fd, RTM_GETROUTE, AF_UNSPEC, 3, deadline, table, iface_table_on_route);
+    close(fd);
+    return ok;
+}
+
+// Helper to check if interface is up and has an IP address. Tunnels have no
+// carrier, so for them the "unknown" operstate counts as up too.
+static bool iface_is_usable(const struct iface_info *info, bool tunnel) {
+    if (!info->has_ipv4) return false;
+    return info->oper_up || (tunnel && info->oper_unknown);
+}
+
+// Checks the interfaces listed one per line in a /proc/net file, e.g. WireGuard
+// or PPP tunnels, which don't necessarily follow the naming conventions
+static const struct iface_info *proc_list_usable_tunnel(struct iface_table *ifaces, const char *proc_path,
+                                                        bool has_header, const char *delimiters) {
+    char path[512];
+    FILE *fp = fopen(fs_path(path, sizeof(path), proc_path), "r");
+    if (!fp) return NULL;
+    char buf[256];
+    if (has_header) fgets(buf, sizeof(buf), fp);
+    const struct iface_info *found = NULL;
+    while (!found && fgets(buf, sizeof(buf), fp)) {
+        char *iface = strtok(buf, delimiters);
+        struct iface_info *info = iface ? iface_table_by_name(ifaces, iface) : NULL;
+        if (info && iface_is_usable(info, true)) found = info;
+    }
+    fclose(fp);
+    return found;
+}
+
+static enum network_vpn_kind vpn_kind_of(const char *name) {
+    if (has_prefix(name, "wg")) return NETWORK_VPN_WIREGUARD;
+    if (has_prefix(name, "tun") || has_prefix(name, "tap") || has_prefix(name, "utun")) return NETWORK_VPN_TUN;
+    if (has_prefix(name, "ppp")) return NETWORK_VPN_PPP;
+    if (has_prefix(name, "ipsec")) return NETWORK_VPN_IPSEC;
+    return NETWORK_VPN_OTHER;
+}
+
+// Classifies the current network using the given interface table, in a single
+// pass that looks at each interface once and stops at the first usable VPN
+static void classify_network(struct iface_table *ifaces, struct network_snapshot *snapshot) {
+    // The kernel has no notion of metered links: only known for the mobile guess below
+    snapshot->known_flags = NETWORK_SNAPSHOT_IPV6_DEFAULT_ROUTE;
+    if (ifaces->has_ipv6_default_route) snapshot->flags |= NETWORK_SNAPSHOT_IPV6_DEFAULT_ROUTE;
+
+    // Nothing to route through: no need to start the engine. Only local state is
+    // checked, no DNS or network I/O, so this stays cheap on the hot path.
+    if (!ifaces->has_default_route && !ifaces->has_global_address) {
+        snapshot->type = NETWORK_TYPE_NO_INTERNET;
+        return;
+    }
+
+    const struct iface_info *vpn = NULL, *wifi = NULL, *mobile = NULL, *wired = NULL;
+
+    for (size_t i = 0; i < ifaces->count && !vpn; i++) {
+        const struct iface_info *info = &ifaces->items[i];
+        if (info->kind == IFACE_VIRTUAL) continue;
+        if (!iface_is_usable(info, info->kind == IFACE_VPN)) continue;
+        if (info->kind == IFACE_VPN) vpn = info;
+        if (info->kind == IFACE_MOBILE && !mobile) mobile = info;
+        if (info->kind == IFACE_WIRED && !wired) wired = info;
+        // Wi-Fi: has /sys/class/net/<iface>/wireless, no need to look once one is found
+        if (!wifi) {
+            char wireless_path[512];
+            snprintf(wireless_path, sizeof(wireless_path), "%s/sys/class/net/%s/wireless", g_fs_root, info->name);
+            if (access(wireless_path, F_OK) == 0) wifi = info;
         }
-        // Mobile: wwan, ppp
-        if ((strncmp(dir->d_name, "wwan", 4) == 0 || strncmp(dir->d_name, "ppp", 3) == 0) && iface_is_up_and_has_ip(dir->d_name)) {
-            found_mobile = 1;
+    }
+
+    enum network_vpn_kind vpn_kind = vpn ? vpn_kind_of(vpn->name) : NETWORK_VPN_NONE;
+    if (!vpn && (vpn = proc_list_usable_tunnel(ifaces, "/proc/net/wireguard", false, " \n"))) {
+        vpn_kind = NETWORK_VPN_WIREGUARD;
+    }
+    if (!vpn && (vpn = proc_list_usable_tunnel(ifaces, "/proc/net/ppp", true, ":"))) {
+        vpn_kind = NETWORK_VPN_PPP;
+    }
+
+    // The interface carrying the traffic: the tunnel when connected, otherwise
+    // the one holding the preferred default route
+    const struct iface_info *primary = iface_table_by_index(ifaces, ifaces->default_route_index);
+    if (vpn) {
+        snapshot->type = NETWORK_TYPE_VPN;
+        snapshot->vpn_kind = vpn_kind;
+        primary = vpn;
+    } else if (wifi) {
+        snapshot->type = NETWORK_TYPE_WIFI;
+    } else if (mobile) {
+        // Same guess NetworkManager makes for cellular connections without an explicit setting
+        snapshot->type = NETWORK_TYPE_MOBILE;
+        snapshot->flags |= NETWORK_SNAPSHOT_METERED;
+        snapshot->known_flags |= NETWORK_SNAPSHOT_METERED;
+    } else if (wired) {
+        snapshot->type = NETWORK_TYPE_WIRED_ETHERNET;
+    } else {
+        snapshot->type = NETWORK_TYPE_UNKNOWN;
+    }
+
+    if (primary) {
+        snprintf(snapshot->interface_name, sizeof(snapshot->interface_name), "%s", primary->name);
+        snapshot->mtu = (int32_t)primary->mtu;
+    }
+}
+
+static void compute_network_snapshot(struct network_snapshot *snapshot) {
+    memset(snapshot, 0, sizeof(*snapshot));
+    struct iface_table ifaces = { 0 };
+    if (iface_table_load(&ifaces)) {
+        classify_network(&ifaces, snapshot);
+    } else {
+        snapshot->type = NETWORK_TYPE_UNKNOWN;
+    }
+    iface_table_free(&ifaces);
+}
+
+// Latest snapshot, kept up to date by the monitor thread. Readers don't lock:
+// g_snapshot_seq is odd while a write is in progress, and a reader retries until
+// it sees the same even value before and after copying.
+static struct network_snapshot g_snapshot;
+static atomic_uint g_snapshot_seq = 0;
+// Only serializes writers, e.g. on-demand classifications when the monitor isn't running
+static pthread_mutex_t g_snapshot_write_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void network_snapshot_publish(struct network_snapshot *snapshot) {
+    pthread_mutex_lock(&g_snapshot_write_lock);
+    network_snapshot_stamp(&g_snapshot, snapshot);
+    unsigned int seq = atomic_load_explicit(&g_snapshot_seq, memory_order_relaxed);
+    atomic_store_explicit(&g_snapshot_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    g_snapshot = *snapshot;
+    atomic_store_explicit(&g_snapshot_seq, seq + 2, memory_order_release);
+    pthread_mutex_unlock(&g_snapshot_write_lock);
+}
+
+static void network_snapshot_read(struct network_snapshot *snapshot) {
+    for (;;) {
+        unsigned int seq = atomic_load_explicit(&g_snapshot_seq, memory_order_acquire);
+        if (seq & 1) continue;
+        *snapshot = g_snapshot;
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&g_snapshot_seq, memory_order_relaxed) == seq) return;
+    }
+}
+
+static atomic_bool g_monitor_running = false;
+// Set once the monitor thread exists, which then runs for the lifetime of the process
+static atomic_bool g_monitor_started = false;
+static pthread_once_t g_monitor_once = PTHREAD_ONCE_INIT;
+
+// Quiet period used to coalesce the burst of link/address/route messages
+// that a single network change produces
+#define MONITOR_SETTLE_MS 100
+// Delay before re-subscribing after the netlink socket failed, doubled on
+// every failed attempt up to the maximum
+#define MONITOR_RESTART_MIN_MS 1000
+#define MONITOR_RESTART_MAX_MS 60000
+
+// Subscribes to rtnetlink link, address and route notifications. Returns the socket or -1.
+static int network_monitor_open(void) {
+    int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd < 0) return -1;
+
+    struct sockaddr_nl local = {
+        .nl_family = AF_NETLINK,
+        .nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR | RTMGRP_IPV4_ROUTE |
+                     RTMGRP_IPV6_ROUTE,
+    };
+    if (bind(fd, (struct sockaddr *)&local, sizeof(local)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Re-classifies after every burst of notifications, until the socket fails
+static void network_monitor_run(int fd) {
+    char buf[16384] __attribute__((aligned(NLMSG_ALIGNTO)));
+    for (;;) {
+        ssize_t len = recv(fd, buf, sizeof(buf), 0);
+        if (len < 0) {
+            if (errno == EINTR) continue;
+            // ENOBUFS means we missed messages, which is fine since we re-classify anyway
+            if (errno != ENOBUFS) return;
+        } else if (len == 0) {
+            return;
         }
-        // Wi-Fi: has /sys/class/net/<iface>/wireless
-        char wireless_path[256];
-        snprintf(wireless_path, sizeof(wireless_path), "/sys/class/net/%s/wireless", dir->d_name);
-        if (access(wireless_path, F_OK) == 0 && iface_is_up_and_has_ip(dir->d_name)) {
-            found_wifi = 1;
+
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        while (poll(&pfd, 1, MONITOR_SETTLE_MS) > 0) {
+            if (recv(fd, buf, sizeof(buf), MSG_DONTWAIT) < 0 && errno != ENOBUFS && errno != EINTR) break;
         }
-        // Wired: eth*, en*
-        if ((strncmp(dir->d_name, "eth", 3) == 0 || strncmp(dir->d_name, "en", 2) == 0) && iface_is_up_and_has_ip(dir->d_name)) {
-            found_wired = 1;
+
+        struct network_snapshot snapshot;
+        compute_network_snapshot(&snapshot);
+        network_snapshot_publish(&snapshot);
+        notify_network_type_changed(network_type_names[snapshot.type]);
+    }
+}
+
+static void sleep_ms(unsigned int ms) {
+    struct timespec ts = { .tv_sec = ms / 1000, .tv_nsec = (long)(ms % 1000) * 1000000 };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {}
+}
+
+// Runs for the lifetime of the process. When the socket fails, callers classify
+// on demand while the thread re-subscribes with backoff, then it catches up with
+// any change it missed, so Kotlin observers keep getting notified.
+static void *network_monitor_thread(void *arg) {
+    int fd = (int)(intptr_t)arg;
+    unsigned int backoff_ms = MONITOR_RESTART_MIN_MS;
+    for (;;) {
+        long long started = monotonic_ms();
+        network_monitor_run(fd);
+        close(fd);
+        atomic_store(&g_monitor_running, false);
+
+        // A monitor that ran for a while failed on its own, not in a restart loop
+        if (monotonic_ms() - started > MONITOR_RESTART_MAX_MS) backoff_ms = MONITOR_RESTART_MIN_MS;
+        do {
+            sleep_ms(backoff_ms);
+            backoff_ms = backoff_ms * 2 < MONITOR_RESTART_MAX_MS ? backoff_ms * 2 : MONITOR_RESTART_MAX_MS;
+        } while ((fd = network_monitor_open()) < 0);
+
+        struct network_snapshot snapshot;
+        compute_network_snapshot(&snapshot);
+        network_snapshot_publish(&snapshot);
+        atomic_store(&g_monitor_running, true);
+        notify_network_type_changed(network_type_names[snapshot.type]);
+    }
+    return NULL;
+}
+
+// Starts a thread that re-classifies the network only when something changes
+static void network_monitor_start(void) {
+    int fd = network_monitor_open();
+    if (fd < 0) return;
+
+    // Take the first snapshot after subscribing, so no change can be missed in between
+    struct network_snapshot snapshot;
+    compute_network_snapshot(&snapshot);
+    network_snapshot_publish(&snapshot);
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    pthread_t thread;
+    atomic_store(&g_monitor_running, true);
+    if (pthread_create(&thread, &attr, network_monitor_thread, (void *)(intptr_t)fd) == 0) {
+        atomic_store(&g_monitor_started, true);
+    } else {
+        atomic_store(&g_monitor_running, false);
+        close(fd);
+    }
+    pthread_attr_destroy(&attr);
+}
+
+#ifdef NETWORK_TYPE_FINDER_TESTING
+// Points the classifier at a fake filesystem root, or back at the real system
+// with NULL or "". Not thread-safe: meant to be called before classifying.
+void setNetworkTypeFinderRoot(const char *root) {
+    snprintf(g_fs_root, sizeof(g_fs_root), "%s", root ? root : "");
+}
+
+void classifyNetworkImpl(struct network_snapshot *snapshot) {
+    compute_network_snapshot(snapshot);
+}
+#endif
+
+void getNetworkSnapshotImpl(struct network_snapshot *snapshot) {
+    // A fake root doesn't produce netlink notifications, so always classify on demand
+    if (!g_fs_root[0]) {
+        pthread_once(&g_monitor_once, network_monitor_start);
+        if (atomic_load(&g_monitor_running)) {
+            network_snapshot_read(snapshot);
+            return;
         }
     }
-    closedir(d);
-    if (found_vpn) return "vpn";
-    if (found_wifi) return "wifi";
-    if (found_mobile) return "mobile";
-    if (found_wired) return "wired_ethernet";
-    return "unknown";
+    // Monitor unavailable (e.g. netlink blocked by a sandbox): classify on demand
+    compute_network_snapshot(snapshot);
+    network_snapshot_publish(snapshot);
+}
+
+const char* getNetworkTypeImpl() {
+    struct network_snapshot snapshot;
+    getNetworkSnapshotImpl(&snapshot);
+    return network_type_names[snapshot.type];
+}
+
+// Changes are pushed once the netlink monitor thread started, which then keeps
+// running and re-subscribes on its own if the socket fails
+static bool network_change_notifications_supported(void) {
+    pthread_once(&g_monitor_once, network_monitor_start);
+    return atomic_load(&g_monitor_started);
 }
 #else
 const char* getNetworkTypeImpl() {
     return "unknown";
 }
+
+void getNetworkSnapshotImpl(struct network_snapshot *snapshot) {
+    memset(snapshot, 0, sizeof(*snapshot));
+}
 #endif
 
 const char* getNetworkType() {
@@ -367,3 +1165,76 @@ JNIEXPORT jstring JNICALL Java_org_ooni_engine_DesktopNetworkTypeFinder_getNetwo
     const char* networkType = getNetworkType();
     return (*env)->NewStringUTF(env, networkType);
 }
+
+// JNI function to fill a direct ByteBuffer with a struct network_snapshot in one
+// call, without allocating any Java object. Returns the number of bytes written,
+// -1 if the buffer isn't direct or -2 if it's too small.
+JNIEXPORT jint JNICALL Java_org_ooni_engine_DesktopNetworkTypeFinder_nativeGetNetworkSnapshot(JNIEnv *env, jobject obj, jobject buffer)
+{
+    void *address = (*env)->GetDirectBufferAddress(env, buffer);
+    if (address == NULL) return -1;
+    if ((*env)->GetDirectBufferCapacity(env, buffer) < (jlong)sizeof(struct network_snapshot)) return -2;
+
+    struct network_snapshot snapshot;
+    getNetworkSnapshotImpl(&snapshot);
+    memcpy(address, &snapshot, sizeof(snapshot));
+    return (jint)sizeof(snapshot);
+}
+
+// JNI function to set the network change callback. Returns 0 on success, -4 when
+// this platform cannot push changes and the caller should keep polling.
+JNIEXPORT jint JNICALL Java_org_ooni_engine_DesktopNetworkTypeFinder_nativeSetNetworkChangeCallback(JNIEnv *env, jobject obj, jobject callback)
+{
+#if defined(__APPLE__) || defined(__linux__)
+    pthread_mutex_lock(&g_networkCallbackLock);
+
+    // Get JavaVM for later use
+    if (g_jvm == NULL) {
+        if ((*env)->GetJavaVM(env, &g_jvm) != JNI_OK) {
+            pthread_mutex_unlock(&g_networkCallbackLock);
+            return -1;
+        }
+    }
+
+    // Clear existing callback
+    if (g_networkCallbackObject != NULL) {
+        (*env)->DeleteGlobalRef(env, g_networkCallbackObject);
+        g_networkCallbackObject = NULL;
+        g_networkCallbackMethod = NULL;
+    }
+    g_lastNotifiedType[0] = '\0';
+
+    if (callback == NULL) {
+        pthread_mutex_unlock(&g_networkCallbackLock);
+        return 0;
+    }
+
+    // Create global reference to callback object
+    g_networkCallbackObject = (*env)->NewGlobalRef(env, callback);
+    if (g_networkCallbackObject == NULL) {
+        pthread_mutex_unlock(&g_networkCallbackLock);
+        return -2;
+    }
+
+    // Get the callback method
+    jclass callbackClass = (*env)->GetObjectClass(env, callback);
+    g_networkCallbackMethod = (*env)->GetMethodID(env, callbackClass, "onNetworkTypeChanged", "(Ljava/lang/String;)V");
+    (*env)->DeleteLocalRef(env, callbackClass);
+
+    if (g_networkCallbackMethod == NULL) {
+        (*env)->DeleteGlobalRef(env, g_networkCallbackObject);
+        g_networkCallbackObject = NULL;
+        pthread_mutex_unlock(&g_networkCallbackLock);
+        return -3;
+    }
+    pthread_mutex_unlock(&g_networkCallbackLock);
+
+    if (!network_change_notifications_supported()) {
+        Java_org_ooni_engine_DesktopNetworkTypeFinder_nativeSetNetworkChangeCallback(env, obj, NULL);
+        return -4;
+    }
+    return 0;
+#else
+    return -4;
+#endif
+}
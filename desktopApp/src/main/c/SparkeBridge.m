@@ -6,7 +6,8 @@ static SPUStandardUpdaterController* updaterController = nil;
 static SparkleLogCallback logCallback = NULL;
 static SparkleShutdownCallback shutdownCallback = NULL;
 
-// Internal logging function that handles both NSLog and callback
+// Internal logging function: queues the record through the callback when one is
+// set, and only falls back to a synchronous NSLog otherwise
 static void sparkle_log(SparkleLogLevel level, const char* operation, const char* format, ...) {
     va_list args;
     va_start(args, format);
@@ -16,7 +17,13 @@ static void sparkle_log(SparkleLogLevel level, const char* operation, const char
     vsnprintf(message, sizeof(message), format, args);
     va_end(args);
 
-    // Always log to NSLog with level prefix
+    // The callback only queues the record, it never blocks on the JVM
+    if (logCallback != NULL) {
+        logCallback(level, operation, message);
+        return;
+    }
+
+    // Log to NSLog with level prefix
     const char* levelStr = "";
     switch (level) {
         case SPARKLE_LOG_DEBUG: levelStr = "DEBUG"; break;
@@ -26,11 +33,6 @@ static void sparkle_log(SparkleLogLevel level, const char* operation, const char
     }
 
     NSLog(@"SparkleHelper [%s] %s: %s", levelStr, operation, message);
-
-    // Call callback if set
-    if (logCallback != NULL) {
-        logCallback(level, operation, message);
-    }
 }
 
 @interface OONIUpdaterDelegate : NSObject <SPUUpdaterDelegate>
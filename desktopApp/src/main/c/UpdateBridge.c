@@ -1,8 +1,11 @@
 #include <jni.h>
 #include <string.h>
 
+#include "LogRingBuffer.h"
+
 #ifdef __APPLE__
 #include "SparkeBridge.h"
+#include <pthread.h>
 #else
 #include "WinSparkleBridge.h"
 #include <windows.h>
@@ -35,11 +38,76 @@ static void release_cstring(JNIEnv* env, jstring jstr, const char* cstr);
 
 // Global JVM and callback references
 static JavaVM* g_jvm = NULL;
-static jobject g_logCallbackObject = NULL;
-static jmethodID g_logCallbackMethod = NULL;
 static jobject g_shutdownCallbackObject = NULL;
 static jmethodID g_shutdownCallbackMethod = NULL;
 
+// Log records queued by the updater threads, drained in batches by UpdateLogDrain.kt
+static struct log_ring g_logRing;
+static int g_logRingReady = 0;
+
+// Native threads (Sparkle/WinSparkle workers) are attached to the JVM the first
+// time they call back into Java and stay attached until they exit, instead of
+// attaching and detaching around every log line. The thread-local slot only
+// holds a value for threads attached here, which are the only ones to detach.
+static void detach_current_thread(void* env) {
+    if (env != NULL && g_jvm != NULL) {
+        (*g_jvm)->DetachCurrentThread(g_jvm);
+    }
+}
+
+#ifdef _WIN32
+// Fiber-local storage: unlike pthread keys, its destructor also runs for threads
+// not created through pthreads, like the WinSparkle worker threads
+static DWORD g_attachedEnvSlot = FLS_OUT_OF_INDEXES;
+static INIT_ONCE g_attachedEnvOnce = INIT_ONCE_STATIC_INIT;
+
+static void WINAPI detach_current_thread_fls(void* env) {
+    detach_current_thread(env);
+}
+
+static BOOL CALLBACK create_attached_env_slot(PINIT_ONCE once, PVOID param, PVOID* context) {
+    g_attachedEnvSlot = FlsAlloc(detach_current_thread_fls);
+    return TRUE;
+}
+
+static int remember_attached_env(JNIEnv* env) {
+    InitOnceExecuteOnce(&g_attachedEnvOnce, create_attached_env_slot, NULL, NULL);
+    return g_attachedEnvSlot != FLS_OUT_OF_INDEXES && FlsSetValue(g_attachedEnvSlot, env);
+}
+#else
+static pthread_key_t g_attachedEnvKey;
+static int g_attachedEnvKeyCreated = 0;
+static pthread_once_t g_attachedEnvOnce = PTHREAD_ONCE_INIT;
+
+static void create_attached_env_key(void) {
+    g_attachedEnvKeyCreated = pthread_key_create(&g_attachedEnvKey, detach_current_thread) == 0;
+}
+
+static int remember_attached_env(JNIEnv* env) {
+    pthread_once(&g_attachedEnvOnce, create_attached_env_key);
+    return g_attachedEnvKeyCreated && pthread_setspecific(g_attachedEnvKey, env) == 0;
+}
+#endif
+
+// Returns the JNIEnv of the current thread, attaching it as a daemon the first time
+static JNIEnv* current_thread_env(void) {
+    JNIEnv* env = NULL;
+    jint status = (*g_jvm)->GetEnv(g_jvm, (void**)&env, JNI_VERSION_1_6);
+    if (status == JNI_OK) {
+        return env;
+    }
+    if (status != JNI_EDETACHED ||
+        (*g_jvm)->AttachCurrentThreadAsDaemon(g_jvm, (void**)&env, NULL) != JNI_OK) {
+        return NULL;
+    }
+    if (!remember_attached_env(env)) {
+        // Nothing would detach the thread at exit, so don't keep it attached
+        (*g_jvm)->DetachCurrentThread(g_jvm);
+        return NULL;
+    }
+    return env;
+}
+
 // Helper function to convert jstring to C string
 static const char* jstring_to_cstring(JNIEnv* env, jstring jstr) {
     if (jstr == NULL) return NULL;
@@ -53,36 +121,14 @@ static void release_cstring(JNIEnv* env, jstring jstr, const char* cstr) {
     }
 }
 
-// Log callback function that forwards to Java
+// Log callback function that queues the record for the Java drain thread, so
+// updater threads never block on JVM logging
 #ifdef __APPLE__
 static void native_log_callback(SparkleLogLevel level, const char* operation, const char* message) {
 #else
 static void native_log_callback(WinSparkleLogLevel level, const char* operation, const char* message) {
 #endif
-    if (g_jvm == NULL || g_logCallbackObject == NULL || g_logCallbackMethod == NULL) {
-        return;
-    }
-
-    JNIEnv* env = NULL;
-    if ((*g_jvm)->AttachCurrentThread(g_jvm, (void**)&env, NULL) != JNI_OK) {
-        return;
-    }
-
-    // Create Java strings
-    jstring jOperation = (*env)->NewStringUTF(env, operation);
-    jstring jMessage = (*env)->NewStringUTF(env, message);
-
-    if (jOperation != NULL && jMessage != NULL) {
-        // Call Java callback method
-        (*env)->CallVoidMethod(env, g_logCallbackObject, g_logCallbackMethod,
-                (jint)level, jOperation, jMessage);
-    }
-
-    // Clean up local references
-    if (jOperation != NULL) (*env)->DeleteLocalRef(env, jOperation);
-    if (jMessage != NULL) (*env)->DeleteLocalRef(env, jMessage);
-
-    (*g_jvm)->DetachCurrentThread(g_jvm);
+    log_ring_push(&g_logRing, (int32_t)level, operation, message);
 }
 
 // Shutdown callback function that forwards to Java
@@ -91,71 +137,80 @@ static void native_shutdown_callback(void) {
         return;
     }
 
-    JNIEnv* env = NULL;
-    if ((*g_jvm)->AttachCurrentThread(g_jvm, (void**)&env, NULL) != JNI_OK) {
+    JNIEnv* env = current_thread_env();
+    if (env == NULL) {
         return;
     }
 
     // Call Java shutdown callback method
     (*env)->CallVoidMethod(env, g_shutdownCallbackObject, g_shutdownCallbackMethod);
-
-    (*g_jvm)->DetachCurrentThread(g_jvm);
+    if ((*env)->ExceptionCheck(env)) {
+        (*env)->ExceptionClear(env);
+    }
 }
 
-// JNI function to set log callback
+// JNI function to start or stop queueing native log records
 JNIEXPORT jint JNICALL
-Java_org_ooni_probe_shared_UpdateManagerBase_nativeSetLogCallback(JNIEnv* env, jobject obj, jobject callback) {
-    // Get JavaVM for later use
-    if (g_jvm == NULL) {
-        if ((*env)->GetJavaVM(env, &g_jvm) != JNI_OK) {
-            return -1;
-        }
-    }
-
-    // Clear existing callback
-    if (g_logCallbackObject != NULL) {
-        (*env)->DeleteGlobalRef(env, g_logCallbackObject);
-        g_logCallbackObject = NULL;
-        g_logCallbackMethod = NULL;
-    }
-
-    if (callback == NULL) {
-        // Disable callback
+Java_org_ooni_probe_shared_UpdateLogDrain_nativeSetEnabled(JNIEnv* env, jobject obj, jboolean enabled) {
+    if (!enabled) {
 #ifdef __APPLE__
         sparkle_set_log_callback(NULL);
 #else
         winsparkle_set_log_callback(NULL);
 #endif
+        // Lets the drain thread see it was stopped
+        if (g_logRingReady) {
+            log_ring_wake(&g_logRing);
+        }
         return 0;
     }
 
-    // Create global reference to callback object
-    g_logCallbackObject = (*env)->NewGlobalRef(env, callback);
-    if (g_logCallbackObject == NULL) {
-        return -2;
+    // Initialized once: records still queued from a previous session are kept
+    if (!g_logRingReady) {
+        log_ring_init(&g_logRing);
+        g_logRingReady = 1;
     }
-
-    // Get the callback method
-    jclass callbackClass = (*env)->GetObjectClass(env, callback);
-    g_logCallbackMethod = (*env)->GetMethodID(env, callbackClass, "onLog", "(ILjava/lang/String;Ljava/lang/String;)V");
-    (*env)->DeleteLocalRef(env, callbackClass);
-
-    if (g_logCallbackMethod == NULL) {
-        (*env)->DeleteGlobalRef(env, g_logCallbackObject);
-        g_logCallbackObject = NULL;
-        return -3;
-    }
-
-    // Set native callback
 #ifdef __APPLE__
     sparkle_set_log_callback(native_log_callback);
 #else
     winsparkle_set_log_callback(native_log_callback);
 #endif
-
     return 0;
 }
 
+// JNI function to move queued log records into a direct ByteBuffer, as
+// consecutive struct log_record. Returns the number of records, or -1 if the
+// buffer isn't direct.
+JNIEXPORT jint JNICALL
+Java_org_ooni_probe_shared_UpdateLogDrain_nativeDrain(JNIEnv* env, jobject obj, jobject buffer) {
+    void* address = (*env)->GetDirectBufferAddress(env, buffer);
+    jlong capacity = (*env)->GetDirectBufferCapacity(env, buffer);
+    if (address == NULL || capacity < 0) {
+        return -1;
+    }
+    if (!g_logRingReady) {
+        return 0;
+    }
+    size_t maxRecords = (size_t)capacity / sizeof(struct log_record);
+    return (jint)log_ring_drain(&g_logRing, (struct log_record*)address, maxRecords);
+}
+
+// JNI function parking the drain thread until a log record is queued, the drain
+// is stopped or timeoutMs elapse. Returns whether records are waiting.
+JNIEXPORT jboolean JNICALL
+Java_org_ooni_probe_shared_UpdateLogDrain_nativeWait(JNIEnv* env, jobject obj, jint timeoutMs) {
+    if (!g_logRingReady) {
+        return JNI_FALSE;
+    }
+    return log_ring_wait(&g_logRing, (int32_t)timeoutMs) ? JNI_TRUE : JNI_FALSE;
+}
+
+// JNI function returning how many log records were dropped because the ring was full
+JNIEXPORT jlong JNICALL
+Java_org_ooni_probe_shared_UpdateLogDrain_nativeDroppedCount(JNIEnv* env, jobject obj) {
+    return g_logRingReady ? (jlong)log_ring_dropped(&g_logRing) : 0;
+}
+
 // JNI function to set shutdown callback
 JNIEXPORT jint JNICALL
 Java_org_ooni_probe_shared_WinSparkleUpdateManager_nativeSetShutdownCallback(JNIEnv* env, jobject obj, jobject callback) {
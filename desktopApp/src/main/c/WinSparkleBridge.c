@@ -33,7 +33,8 @@ static win_sparkle_set_app_details_func ws_set_app_details = NULL;
 static win_sparkle_set_can_shutdown_callback_func ws_set_can_shutdown_callback = NULL;
 static win_sparkle_set_shutdown_request_callback_func ws_set_shutdown_request_callback = NULL;
 
-// Internal logging function that handles both printf and callback
+// Internal logging function: queues the record through the callback when one is
+// set, and only falls back to a synchronous printf otherwise
 static void winsparkle_log(WinSparkleLogLevel level, const char* operation, const char* format, ...) {
     va_list args;
     va_start(args, format);
@@ -43,7 +44,13 @@ static void winsparkle_log(WinSparkleLogLevel level, const char* operation, cons
     vsnprintf(message, sizeof(message), format, args);
     va_end(args);
 
-    // Always log to stdout with level prefix
+    // The callback only queues the record, it never blocks on the JVM
+    if (logCallback != NULL) {
+        logCallback(level, operation, message);
+        return;
+    }
+
+    // Log to stdout with level prefix
     const char* levelStr = "";
     switch (level) {
         case WINSPARKLE_LOG_DEBUG: levelStr = "DEBUG"; break;
@@ -54,11 +61,6 @@ static void winsparkle_log(WinSparkleLogLevel level, const char* operation, cons
 
     printf("WinSparkleHelper [%s] %s: %s\n", levelStr, operation, message);
     fflush(stdout);
-
-    // Call callback if set
-    if (logCallback != NULL) {
-        logCallback(level, operation, message);
-    }
 }
 
 // Callbacks for WinSparkle state tracking
@@ -311,6 +311,7 @@ private fun ApplicationScope.onQuitApplicationClicked(
         Logger.i("Application shutdown initiated")
         CoroutineScope(Dispatchers.IO).launch {
             updateController.cleanup()
+            dependencies.engine.shutdown()
             exitApplication()
             instanceManager.shutdown()
         }
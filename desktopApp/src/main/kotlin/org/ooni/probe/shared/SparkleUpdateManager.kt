@@ -53,8 +53,6 @@ class SparkleUpdateManager : UpdateManager {
 
     private external fun nativeSetUpdateCheckInterval(hours: Int): Int
 
-    private external fun nativeSetLogCallback(callback: Any?): Int
-
     private external fun nativeSetShutdownCallback(callback: Any?): Int
 
     private external fun nativeCleanup(): Int
@@ -90,18 +88,6 @@ class SparkleUpdateManager : UpdateManager {
         logErrorAndUpdateState(errorCode, errorMessage, "updateCheck")
     }
 
-    // Callback from native code for log messages
-    @Suppress("unused")
-    fun onLog(
-        level: Int,
-        operation: String,
-        message: String,
-    ) {
-        val logLevel = UpdateLogLevel.values().find { it.value == level } ?: UpdateLogLevel.INFO
-        val logMessage = UpdateLogMessage(logLevel, operation, message)
-        logCallback?.invoke(logMessage)
-    }
-
     // Callback from native code for shutdown requests
     @Suppress("unused")
     fun onShutdownRequested() {
@@ -288,8 +274,8 @@ class SparkleUpdateManager : UpdateManager {
 
     override fun setLogCallback(callback: UpdateLogCallback?) {
         logCallback = callback
-        // Set native callback - pass this object so native code can call onLog
-        nativeSetLogCallback(if (callback != null) this else null)
+        // Native log records are queued and forwarded in batches by UpdateLogDrain
+        UpdateLogDrain.setCallback(callback)
     }
 
     fun setShutdownCallback(callback: (() -> Unit)?) {
@@ -0,0 +1,142 @@
+package org.ooni.probe.shared
+
+import co.touchlab.kermit.Logger
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Forwards the log records queued by the native update bridges, in batches, from a single
+ * daemon thread. Updater threads only copy their records into a native ring buffer, they
+ * never call into the JVM to log. Records that don't fit in the ring are dropped and counted.
+ * Between batches the thread is parked in the native side until a record is queued.
+ *
+ * Requires the `updatebridge` library to be loaded. A library built before the drain existed
+ * doesn't export it: native log records are then not forwarded, and updates work as before.
+ */
+object UpdateLogDrain {
+    private external fun nativeSetEnabled(enabled: Boolean): Int
+
+    private external fun nativeDrain(buffer: ByteBuffer): Int
+
+    private external fun nativeDroppedCount(): Long
+
+    private external fun nativeWait(timeoutMs: Int): Boolean
+
+    // Layout of struct log_record in LogRingBuffer.h
+    private const val RECORD_SIZE = 512
+    private const val TIMESTAMP_OFFSET = 0
+    private const val LEVEL_OFFSET = 8
+    private const val OPERATION_LENGTH_OFFSET = 12
+    private const val MESSAGE_LENGTH_OFFSET = 14
+    private const val OPERATION_OFFSET = 16
+    private const val MESSAGE_OFFSET = 48
+    private const val MESSAGE_SIZE = 464
+
+    private const val BATCH_RECORDS = 64
+
+    // Only bounds how long a lost wake-up could delay records, the drain is woken when stopped
+    private const val WAIT_TIMEOUT_MS = 60_000
+
+    // Polling interval with a library built before nativeWait existed
+    private const val IDLE_DELAY_MS = 200L
+
+    private val buffer = ByteBuffer.allocateDirect(RECORD_SIZE * BATCH_RECORDS).order(ByteOrder.nativeOrder())
+    private val textBytes = ByteArray(MESSAGE_SIZE)
+    private var callback: UpdateLogCallback? = null
+    private var thread: Thread? = null
+    private var reportedDropped = 0L
+
+    @Volatile
+    private var isAvailable = true
+
+    private var canWait = true
+
+    /** Records dropped so far because the native ring buffer was full */
+    val droppedCount: Long
+        get() = if (isAvailable) nativeDroppedCount() else 0L
+
+    /**
+     * Starts forwarding native log records to [callback], or stops with null.
+     * @return the native result, or -1 if the loaded library has no drain
+     */
+    @Synchronized
+    fun setCallback(callback: UpdateLogCallback?): Int {
+        if (!isAvailable) return -1
+        val result = try {
+            nativeSetEnabled(callback != null)
+        } catch (e: UnsatisfiedLinkError) {
+            Logger.w("Update log drain not available in the update bridge: ${e.message}")
+            isAvailable = false
+            this.callback = null
+            return -1
+        }
+        this.callback = callback
+        if (callback != null && thread == null) {
+            thread = Thread(::drainLoop, "update-log-drain").apply {
+                isDaemon = true
+                start()
+            }
+        }
+        return result
+    }
+
+    private fun drainLoop() {
+        while (true) {
+            val callback = synchronized(this) {
+                this.callback ?: run {
+                    thread = null
+                    return
+                }
+            }
+            // A full batch means more records are probably waiting
+            if (drain(callback) < BATCH_RECORDS) waitForRecords()
+        }
+    }
+
+    private fun waitForRecords() {
+        if (canWait) {
+            try {
+                nativeWait(WAIT_TIMEOUT_MS)
+                return
+            } catch (e: UnsatisfiedLinkError) {
+                canWait = false
+            }
+        }
+        Thread.sleep(IDLE_DELAY_MS)
+    }
+
+    private fun drain(callback: UpdateLogCallback): Int {
+        buffer.clear()
+        val count = nativeDrain(buffer)
+        for (index in 0 until count) {
+            val offset = index * RECORD_SIZE
+            val level = buffer.getInt(offset + LEVEL_OFFSET)
+            callback(
+                UpdateLogMessage(
+                    level = UpdateLogLevel.entries.find { it.value == level } ?: UpdateLogLevel.INFO,
+                    operation = readText(offset + OPERATION_OFFSET, buffer.getShort(offset + OPERATION_LENGTH_OFFSET)),
+                    message = readText(offset + MESSAGE_OFFSET, buffer.getShort(offset + MESSAGE_LENGTH_OFFSET)),
+                    timestamp = buffer.getLong(offset + TIMESTAMP_OFFSET),
+                ),
+            )
+        }
+
+        val dropped = nativeDroppedCount()
+        if (dropped > reportedDropped) {
+            callback(
+                UpdateLogMessage(UpdateLogLevel.WARN, "log", "Dropped ${dropped - reportedDropped} native log records"),
+            )
+            reportedDropped = dropped
+        }
+        return count.coerceAtLeast(0)
+    }
+
+    private fun readText(
+        offset: Int,
+        length: Short,
+    ): String {
+        val size = length.toInt().coerceIn(0, MESSAGE_SIZE)
+        buffer.get(offset, textBytes, 0, size)
+        return String(textBytes, 0, size, Charsets.UTF_8)
+    }
+}
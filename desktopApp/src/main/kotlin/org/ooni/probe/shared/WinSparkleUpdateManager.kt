@@ -36,26 +36,12 @@ class WinSparkleUpdateManager : UpdateManager {
         appVersion: String,
     ): Int
 
-    private external fun nativeSetLogCallback(callback: Any?): Int
-
     private external fun nativeSetShutdownCallback(callback: Any?): Int
 
     private external fun nativeSetDllRoot(rootPath: String)
 
     private external fun nativeCleanup(): Int
 
-    // Callback from native code for log messages
-    @Suppress("unused")
-    fun onLog(
-        level: Int,
-        operation: String,
-        message: String,
-    ) {
-        val logLevel = UpdateLogLevel.values().find { it.value == level } ?: UpdateLogLevel.INFO
-        val logMessage = UpdateLogMessage(logLevel, operation, message)
-        logCallback?.invoke(logMessage)
-    }
-
     // Callback from native code for shutdown requests
     @Suppress("unused")
     fun onShutdownRequested() {
@@ -204,8 +190,8 @@ class WinSparkleUpdateManager : UpdateManager {
 
     override fun setLogCallback(callback: UpdateLogCallback?) {
         logCallback = callback
-        // Set native callback - pass this object so native code can call onLog
-        nativeSetLogCallback(if (callback != null) this else null)
+        // Native log records are queued and forwarded in batches by UpdateLogDrain
+        UpdateLogDrain.setCallback(callback)
     }
 
     fun setShutdownCallback(callback: (() -> Unit)?) {
@@ -0,0 +1,266 @@
+#define _GNU_SOURCE
+
+#include "FakeNetworkRoot.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <ftw.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <net/if.h>
+#include <net/if_arp.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Sequence number of the captured dumps, any value matches when loading them
+#define FAKE_ROOT_SEQ 1
+
+static void make_dir(struct fake_root *root, const char *relative) {
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/%s", root->path, relative);
+    if (mkdir(path, 0755) != 0 && errno != EEXIST) {
+        perror(path);
+        exit(1);
+    }
+}
+
+void fake_root_write(struct fake_root *root, const char *relative, const char *content) {
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/%s", root->path, relative);
+    FILE *fp = fopen(path, "w");
+    if (!fp) {
+        perror(path);
+        exit(1);
+    }
+    fputs(content, fp);
+    fclose(fp);
+}
+
+static FILE *open_capture(struct fake_root *root, const char *relative) {
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/%s", root->path, relative);
+    FILE *fp = fopen(path, "wb");
+    if (!fp) perror(path);
+    return fp;
+}
+
+int fake_root_create(struct fake_root *root, enum fake_root_format format) {
+    memset(root, 0, sizeof(*root));
+    snprintf(root->path, sizeof(root->path), "/tmp/ntf-root-XXXXXX");
+    if (!mkdtemp(root->path)) return -1;
+    root->format = format;
+    root->next_index = 1;
+    make_dir(root, "sys");
+    make_dir(root, "sys/class");
+    make_dir(root, "sys/class/net");
+    make_dir(root, "proc");
+    make_dir(root, "proc/net");
+
+    if (format == FAKE_ROOT_NETLINK) {
+        make_dir(root, "netlink");
+        root->links = open_capture(root, "netlink/link");
+        root->addrs = open_capture(root, "netlink/addr");
+        root->routes = open_capture(root, "netlink/route");
+        return root->links && root->addrs && root->routes ? 0 : -1;
+    }
+    root->addrs = open_capture(root, "ip-addr");
+    root->routes = open_capture(root, "proc/net/route");
+    if (!root->addrs || !root->routes) return -1;
+    fputs("Iface\tDestination\tGateway \tFlags\tRefCnt\tUse\tMetric\tMask\t\tMTU\tWindow\tIRTT\n", root->routes);
+    return 0;
+}
+
+// One rtnetlink message being built, header and body followed by attributes
+struct nl_message {
+    union {
+        struct nlmsghdr nh;
+        char buf[512];
+    };
+};
+
+static void *nl_begin(struct nl_message *msg, unsigned short type, size_t body_size) {
+    memset(msg, 0, sizeof(*msg));
+    msg->nh.nlmsg_len = NLMSG_LENGTH(body_size);
+    msg->nh.nlmsg_type = type;
+    msg->nh.nlmsg_flags = NLM_F_MULTI;
+    msg->nh.nlmsg_seq = FAKE_ROOT_SEQ;
+    return NLMSG_DATA(&msg->nh);
+}
+
+static void nl_attr(struct nl_message *msg, unsigned short type, const void *data, size_t size) {
+    struct rtattr *rta = (struct rtattr *)(msg->buf + NLMSG_ALIGN(msg->nh.nlmsg_len));
+    rta->rta_type = type;
+    rta->rta_len = RTA_LENGTH(size);
+    memcpy(RTA_DATA(rta), data, size);
+    msg->nh.nlmsg_len = NLMSG_ALIGN(msg->nh.nlmsg_len) + RTA_ALIGN(rta->rta_len);
+}
+
+static void nl_write(struct nl_message *msg, FILE *fp) {
+    fwrite(msg->buf, 1, NLMSG_ALIGN(msg->nh.nlmsg_len), fp);
+}
+
+static void nl_write_done(FILE *fp) {
+    struct nl_message msg;
+    int *status = nl_begin(&msg, NLMSG_DONE, sizeof(int));
+    *status = 0;
+    nl_write(&msg, fp);
+}
+
+// Values of IFLA_OPERSTATE, in the order of RFC 2863
+static unsigned char operstate_value(const char *operstate) {
+    static const char *names[] = {
+        "unknown", "notpresent", "down", "lowerlayerdown", "testing", "dormant", "up",
+    };
+    for (unsigned char i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (strcmp(operstate, names[i]) == 0) return i;
+    }
+    return 0;
+}
+
+// Splits "a.b.c.d/len" into a network order address and a prefix length
+static int parse_cidr(const char *cidr, struct in_addr *address, unsigned char *prefix_len) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%s", cidr);
+    char *slash = strchr(buf, '/');
+    *prefix_len = 32;
+    if (slash) {
+        *slash = '\0';
+        *prefix_len = (unsigned char)atoi(slash + 1);
+    }
+    return inet_pton(AF_INET, buf, address) == 1 ? 0 : -1;
+}
+
+static void write_netlink_iface(struct fake_root *root, int index, const char *name, const char *operstate,
+                                const char *inet) {
+    int loopback = strcmp(name, "lo") == 0;
+    struct nl_message msg;
+    struct ifinfomsg *ifi = nl_begin(&msg, RTM_NEWLINK, sizeof(*ifi));
+    ifi->ifi_family = AF_UNSPEC;
+    ifi->ifi_type = loopback ? ARPHRD_LOOPBACK : ARPHRD_ETHER;
+    ifi->ifi_index = index;
+    ifi->ifi_flags = IFF_UP | (strcmp(operstate, "down") != 0 ? IFF_RUNNING : 0);
+    nl_attr(&msg, IFLA_IFNAME, name, strlen(name) + 1);
+    unsigned int mtu = loopback ? 65536 : 1500;
+    nl_attr(&msg, IFLA_MTU, &mtu, sizeof(mtu));
+    unsigned char state = operstate_value(operstate);
+    nl_attr(&msg, IFLA_OPERSTATE, &state, sizeof(state));
+    nl_write(&msg, root->links);
+
+    struct in_addr address;
+    unsigned char prefix_len;
+    if (!inet || parse_cidr(inet, &address, &prefix_len) != 0) return;
+    struct ifaddrmsg *ifa = nl_begin(&msg, RTM_NEWADDR, sizeof(*ifa));
+    ifa->ifa_family = AF_INET;
+    ifa->ifa_prefixlen = prefix_len;
+    ifa->ifa_flags = IFA_F_PERMANENT;
+    ifa->ifa_scope = loopback ? RT_SCOPE_HOST : RT_SCOPE_UNIVERSE;
+    ifa->ifa_index = (unsigned int)index;
+    nl_attr(&msg, IFA_ADDRESS, &address, sizeof(address));
+    nl_attr(&msg, IFA_LOCAL, &address, sizeof(address));
+    nl_attr(&msg, IFA_LABEL, name, strlen(name) + 1);
+    nl_write(&msg, root->addrs);
+}
+
+int fake_root_add_iface(struct fake_root *root, const char *name, const char *operstate,
+                        const char *inet, int wireless) {
+    int index = root->next_index++;
+    char relative[256];
+    if (root->format == FAKE_ROOT_NETLINK) {
+        write_netlink_iface(root, index, name, operstate, inet);
+    } else {
+        snprintf(relative, sizeof(relative), "sys/class/net/%s", name);
+        make_dir(root, relative);
+        snprintf(relative, sizeof(relative), "sys/class/net/%s/operstate", name);
+        char state[32];
+        snprintf(state, sizeof(state), "%s\n", operstate);
+        fake_root_write(root, relative, state);
+        if (inet) {
+            fprintf(root->addrs, "%d: %s    inet %s scope %s %s\\       valid_lft forever preferred_lft forever\n",
+                    index, name, inet, strcmp(name, "lo") == 0 ? "host" : "global", name);
+        }
+    }
+    if (wireless) {
+        snprintf(relative, sizeof(relative), "sys/class/net/%s", name);
+        make_dir(root, relative);
+        snprintf(relative, sizeof(relative), "sys/class/net/%s/wireless", name);
+        make_dir(root, relative);
+    }
+    return index;
+}
+
+void fake_root_add_route(struct fake_root *root, const char *iface, int index, const char *destination,
+                         int metric) {
+    struct in_addr dest;
+    unsigned char prefix_len;
+    if (parse_cidr(destination, &dest, &prefix_len) != 0) return;
+    // The classifier only looks at the output interface, any gateway will do
+    struct in_addr gateway = { .s_addr = htonl(0x0a000001) };
+    uint32_t mask = prefix_len ? htonl(0xffffffffu << (32 - prefix_len)) : 0;
+
+    if (root->format == FAKE_ROOT_TEXT) {
+        // Addresses in network order printed as host integers, like the kernel does
+        fprintf(root->routes, "%s\t%08X\t%08X\t%04X\t0\t0\t%d\t%08X\t0\t0\t0\n", iface, dest.s_addr,
+                prefix_len ? 0 : gateway.s_addr, prefix_len ? 0x1 : 0x3, metric, mask);
+        return;
+    }
+    struct nl_message msg;
+    struct rtmsg *rtm = nl_begin(&msg, RTM_NEWROUTE, sizeof(*rtm));
+    rtm->rtm_family = AF_INET;
+    rtm->rtm_dst_len = prefix_len;
+    rtm->rtm_table = RT_TABLE_MAIN;
+    rtm->rtm_protocol = prefix_len ? RTPROT_KERNEL : RTPROT_DHCP;
+    rtm->rtm_scope = prefix_len ? RT_SCOPE_LINK : RT_SCOPE_UNIVERSE;
+    rtm->rtm_type = RTN_UNICAST;
+    unsigned int table = RT_TABLE_MAIN;
+    nl_attr(&msg, RTA_TABLE, &table, sizeof(table));
+    if (metric) nl_attr(&msg, RTA_PRIORITY, &metric, sizeof(metric));
+    if (prefix_len) nl_attr(&msg, RTA_DST, &dest, sizeof(dest));
+    else nl_attr(&msg, RTA_GATEWAY, &gateway, sizeof(gateway));
+    nl_attr(&msg, RTA_OIF, &index, sizeof(index));
+    nl_write(&msg, root->routes);
+}
+
+static void close_capture(FILE **fp, int done) {
+    if (!*fp) return;
+    if (done) nl_write_done(*fp);
+    fclose(*fp);
+    *fp = NULL;
+}
+
+void fake_root_finish(struct fake_root *root) {
+    int netlink = root->format == FAKE_ROOT_NETLINK;
+    close_capture(&root->links, netlink);
+    close_capture(&root->addrs, netlink);
+    close_capture(&root->routes, netlink);
+}
+
+static int remove_entry(const char *path, const struct stat *st, int flag, struct FTW *ftw) {
+    (void)st;
+    (void)flag;
+    (void)ftw;
+    return remove(path);
+}
+
+void fake_root_remove(struct fake_root *root) {
+    fake_root_finish(root);
+    nftw(root->path, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+void fake_root_container_host(struct fake_root *root, int virtual_ifaces) {
+    fake_root_add_iface(root, "lo", "unknown", "127.0.0.1/8", 0);
+    fake_root_add_iface(root, "eth0", "down", NULL, 0);
+    int wlan0 = fake_root_add_iface(root, "wlan0", "up", "192.168.1.20/24", 1);
+    int docker0 = fake_root_add_iface(root, "docker0", "up", "172.17.0.1/16", 0);
+    for (int i = 0; i < virtual_ifaces; i++) {
+        char name[32];
+        snprintf(name, sizeof(name), "veth%07x", i);
+        fake_root_add_iface(root, name, "up", NULL, 0);
+    }
+    fake_root_add_route(root, "wlan0", wlan0, "0.0.0.0/0", 600);
+    fake_root_add_route(root, "wlan0", wlan0, "192.168.1.0/24", 600);
+    fake_root_add_route(root, "docker0", docker0, "172.17.0.0/16", 0);
+    fake_root_finish(root);
+}
@@ -0,0 +1,52 @@
+#ifndef FakeNetworkRoot_h
+#define FakeNetworkRoot_h
+
+#include <stdio.h>
+
+// How the interface table is stored in a fake root
+enum fake_root_format {
+    // /sys/class/net operstate and mtu files, an `ip -o addr` capture and /proc/net/route
+    FAKE_ROOT_TEXT,
+    // RTM_NEWLINK, RTM_NEWADDR and RTM_NEWROUTE dumps in netlink/, laid out as
+    // the kernel replies to the classifier's requests
+    FAKE_ROOT_NETLINK,
+};
+
+// Fake topology that the Linux network classifier reads when pointed at it with
+// setNetworkTypeFinderRoot(). Wireless interfaces get a /sys/class/net/<iface>/wireless
+// directory in both formats, since the classifier checks it on the real system too.
+struct fake_root {
+    char path[256];
+    enum fake_root_format format;
+    // ip-addr or netlink/addr
+    FILE *addrs;
+    // netlink/link, netlink format only
+    FILE *links;
+    // proc/net/route or netlink/route
+    FILE *routes;
+    int next_index;
+};
+
+// Creates a fresh root in a temporary directory. Returns 0 on success.
+int fake_root_create(struct fake_root *root, enum fake_root_format format);
+
+// Adds an interface with an optional IPv4 address in CIDR notation. Returns its index.
+int fake_root_add_iface(struct fake_root *root, const char *name, const char *operstate,
+                        const char *inet, int wireless);
+
+// Adds an IPv4 route through the interface, the default one for "0.0.0.0/0"
+void fake_root_add_route(struct fake_root *root, const char *iface, int index, const char *destination,
+                         int metric);
+
+void fake_root_write(struct fake_root *root, const char *relative, const char *content);
+
+// Completes the captures, after which the root is ready to be classified
+void fake_root_finish(struct fake_root *root);
+
+void fake_root_remove(struct fake_root *root);
+
+// Container host: loopback, a down ethernet port, Wi-Fi holding the default
+// route, a docker bridge and virtual_ifaces veth interfaces without addresses
+void fake_root_container_host(struct fake_root *root, int virtual_ifaces);
+
+#endif
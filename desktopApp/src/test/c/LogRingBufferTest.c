@@ -0,0 +1,276 @@
+// Stress test for the update bridges' log ring buffer in LogRingBuffer.c
+//
+// Several producer threads push numbered records while a consumer thread
+// drains them in batches, either polling or parked in log_ring_wait. Checks
+// that every record is either delivered intact or counted as dropped, that
+// each producer's records arrive in order and that no wake-up gets lost.
+//
+// Usage: LogRingBufferTest [-p producers] [-n records_per_producer]
+
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "LogRingBuffer.h"
+
+#define DEFAULT_PRODUCERS 8
+#define DEFAULT_RECORDS 200000
+#define MAX_PRODUCERS 64
+#define DRAIN_BATCH 64
+// Long enough that a consumer missing a wake-up stands out
+#define WAIT_TIMEOUT_MS 1000
+
+static struct log_ring ring;
+static int records_per_producer = DEFAULT_RECORDS;
+static atomic_int producers_running;
+static long pushed[MAX_PRODUCERS];
+
+static int failures = 0;
+static int passed = 0;
+
+static void check(const char *name, bool ok, const char *detail) {
+    if (ok) {
+        printf("ok   %s\n", name);
+        passed++;
+    } else {
+        printf("FAIL %s: %s\n", name, detail);
+        failures++;
+    }
+}
+
+static void *produce(void *arg) {
+    int producer = (int)(intptr_t)arg;
+    char operation[32], message[64];
+    snprintf(operation, sizeof(operation), "producer-%d", producer);
+    for (int i = 0; i < records_per_producer; i++) {
+        snprintf(message, sizeof(message), "%d:%d", producer, i);
+        if (log_ring_push(&ring, producer % 4, operation, message)) pushed[producer]++;
+    }
+    atomic_fetch_sub(&producers_running, 1);
+    return NULL;
+}
+
+static long long now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+struct consumer_result {
+    // Park in log_ring_wait instead of polling when the ring is empty
+    bool parked;
+    long received;
+    long corrupted;
+    long out_of_order;
+    // Waits that ran into the timeout although a record was queued meanwhile
+    long lost_wakeups;
+    int last[MAX_PRODUCERS];
+};
+
+static void consume_batch(struct consumer_result *result, struct log_record *batch, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        const struct log_record *record = &batch[i];
+        int producer, sequence;
+        char operation[32];
+        if (sscanf(record->message, "%d:%d", &producer, &sequence) != 2 || producer < 0 ||
+            producer >= MAX_PRODUCERS) {
+            result->corrupted++;
+            continue;
+        }
+        snprintf(operation, sizeof(operation), "producer-%d", producer);
+        if (strcmp(record->operation, operation) != 0 || record->level != producer % 4 ||
+            record->operation_length != strlen(record->operation) ||
+            record->message_length != strlen(record->message) || record->timestamp_ms <= 0) {
+            result->corrupted++;
+        }
+        if (sequence <= result->last[producer]) result->out_of_order++;
+        result->last[producer] = sequence;
+        result->received++;
+    }
+}
+
+static void *consume(void *arg) {
+    struct consumer_result *result = arg;
+    struct log_record batch[DRAIN_BATCH];
+    for (int i = 0; i < MAX_PRODUCERS; i++) result->last[i] = -1;
+    for (;;) {
+        bool done = atomic_load(&producers_running) == 0;
+        size_t count = log_ring_drain(&ring, batch, DRAIN_BATCH);
+        consume_batch(result, batch, count);
+        if (count == 0) {
+            if (done) break;
+            if (result->parked) {
+                long long start = now_ms();
+                if (log_ring_wait(&ring, WAIT_TIMEOUT_MS) && now_ms() - start >= WAIT_TIMEOUT_MS) {
+                    result->lost_wakeups++;
+                }
+            } else {
+                // Let the ring fill up now and then, so drops happen too
+                usleep(50);
+            }
+        }
+    }
+    return NULL;
+}
+
+// Producers are done when the last one exits, which the parked consumer only
+// notices once woken
+static void *produce_and_wake(void *arg) {
+    produce(arg);
+    if (atomic_load(&producers_running) == 0) log_ring_wake(&ring);
+    return NULL;
+}
+
+static void run_stress(int producers, bool parked) {
+    log_ring_init(&ring);
+    memset(pushed, 0, sizeof(pushed));
+    atomic_store(&producers_running, producers);
+
+    struct consumer_result result;
+    memset(&result, 0, sizeof(result));
+    result.parked = parked;
+    pthread_t consumer, threads[MAX_PRODUCERS];
+    pthread_create(&consumer, NULL, consume, &result);
+    for (int i = 0; i < producers; i++) {
+        pthread_create(&threads[i], NULL, produce_and_wake, (void *)(intptr_t)i);
+    }
+    for (int i = 0; i < producers; i++) pthread_join(threads[i], NULL);
+    pthread_join(consumer, NULL);
+
+    long total_pushed = 0;
+    for (int i = 0; i < producers; i++) total_pushed += pushed[i];
+    long expected = (long)producers * records_per_producer;
+    long dropped = (long)log_ring_dropped(&ring);
+    printf("     %d producers, %s: %ld records, %ld delivered, %ld dropped\n", producers,
+           parked ? "parked" : "polling", expected, result.received, dropped);
+
+    char detail[128];
+    snprintf(detail, sizeof(detail), "%ld delivered + %ld dropped != %ld", result.received, dropped, expected);
+    check("stress/accounted", result.received + dropped == expected && result.received == total_pushed, detail);
+    snprintf(detail, sizeof(detail), "%ld corrupted records", result.corrupted);
+    check("stress/intact", result.corrupted == 0, detail);
+    snprintf(detail, sizeof(detail), "%ld records out of order", result.out_of_order);
+    check("stress/ordered", result.out_of_order == 0, detail);
+    if (parked) {
+        snprintf(detail, sizeof(detail), "%ld waits missed a queued record", result.lost_wakeups);
+        check("stress/woken", result.lost_wakeups == 0, detail);
+    }
+}
+
+// The consumer sleeps while the ring is empty and wakes up for a record or log_ring_wake
+static void *push_later(void *arg) {
+    (void)arg;
+    usleep(20000);
+    log_ring_push(&ring, 1, "wait", "late");
+    return NULL;
+}
+
+static void run_wait(void) {
+    log_ring_init(&ring);
+    long long start = now_ms();
+    bool available = log_ring_wait(&ring, 50);
+    check("wait/times_out", !available && now_ms() - start >= 40, "wait on an empty ring didn't time out");
+
+    pthread_t producer;
+    pthread_create(&producer, NULL, push_later, NULL);
+    start = now_ms();
+    available = log_ring_wait(&ring, WAIT_TIMEOUT_MS);
+    pthread_join(producer, NULL);
+    check("wait/woken_by_push", available && now_ms() - start < WAIT_TIMEOUT_MS, "push didn't wake the consumer");
+
+    struct log_record record;
+    log_ring_drain(&ring, &record, 1);
+    log_ring_wake(&ring);
+    start = now_ms();
+    available = log_ring_wait(&ring, WAIT_TIMEOUT_MS);
+    check("wait/woken_by_wake", !available && now_ms() - start < WAIT_TIMEOUT_MS, "wake didn't end the wait");
+}
+
+// A full ring drops new records and keeps the oldest ones
+static void run_overflow(void) {
+    log_ring_init(&ring);
+    for (int i = 0; i < LOG_RING_CAPACITY + 10; i++) {
+        char message[16];
+        snprintf(message, sizeof(message), "%d", i);
+        log_ring_push(&ring, 1, "overflow", message);
+    }
+    struct log_record batch[LOG_RING_CAPACITY];
+    size_t count = log_ring_drain(&ring, batch, LOG_RING_CAPACITY);
+    check("overflow/drops_newest",
+          count == LOG_RING_CAPACITY && log_ring_dropped(&ring) == 10 && strcmp(batch[0].message, "0") == 0,
+          "unexpected records after overflow");
+    check("overflow/reusable", log_ring_push(&ring, 1, "overflow", "again") && log_ring_drain(&ring, batch, 1) == 1,
+          "ring not usable after draining");
+}
+
+static bool ends_with_mark(const char *text, size_t length) {
+    size_t mark_length = strlen(LOG_RECORD_TRUNCATION_MARK);
+    return length >= mark_length && strlen(text) == length &&
+           strcmp(text + length - mark_length, LOG_RECORD_TRUNCATION_MARK) == 0;
+}
+
+// Long operations and messages are cut to the record size and marked, still NUL-terminated
+static void run_truncation(void) {
+    log_ring_init(&ring);
+    char message[LOG_RECORD_MESSAGE_SIZE * 2];
+    memset(message, 'x', sizeof(message) - 1);
+    message[sizeof(message) - 1] = '\0';
+    log_ring_push(&ring, 2, "an_operation_name_longer_than_the_record_allows", message);
+    struct log_record record;
+    size_t count = log_ring_drain(&ring, &record, 1);
+    check("truncation/marked",
+          count == 1 && record.message_length == LOG_RECORD_MESSAGE_SIZE - 1 &&
+              ends_with_mark(record.message, record.message_length) &&
+              record.operation_length == LOG_RECORD_OPERATION_SIZE - 1 &&
+              ends_with_mark(record.operation, record.operation_length),
+          "record not truncated as expected");
+
+    // Two-byte characters: the cut must not leave half of one before the mark
+    for (size_t i = 0; i + 2 < sizeof(message); i += 2) memcpy(message + i, "\xC3\xA9", 2);
+    message[sizeof(message) - 2] = '\0';
+    log_ring_push(&ring, 2, "utf8", message);
+    count = log_ring_drain(&ring, &record, 1);
+    size_t text_length = record.message_length - strlen(LOG_RECORD_TRUNCATION_MARK);
+    check("truncation/utf8",
+          count == 1 && ends_with_mark(record.message, record.message_length) && text_length % 2 == 0 &&
+              (unsigned char)record.message[text_length - 2] == 0xC3,
+          "truncation split a multi-byte character");
+
+    log_ring_push(&ring, 2, "short", "fits");
+    count = log_ring_drain(&ring, &record, 1);
+    check("truncation/untouched", count == 1 && strcmp(record.message, "fits") == 0 && record.message_length == 4,
+          "short message changed");
+}
+
+int main(int argc, char **argv) {
+    int producers = DEFAULT_PRODUCERS;
+    int opt;
+    while ((opt = getopt(argc, argv, "p:n:")) != -1) {
+        switch (opt) {
+            case 'p': producers = atoi(optarg); break;
+            case 'n': records_per_producer = atoi(optarg); break;
+            default:
+                fprintf(stderr, "Usage: %s [-p producers] [-n records_per_producer]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (producers < 1) producers = 1;
+    if (producers > MAX_PRODUCERS) producers = MAX_PRODUCERS;
+
+    run_overflow();
+    run_truncation();
+    run_wait();
+    run_stress(1, false);
+    run_stress(producers, false);
+    run_stress(producers, true);
+
+    printf("%d passed, %d failed\n", passed, failures);
+    return failures ? 1 : 0;
+}
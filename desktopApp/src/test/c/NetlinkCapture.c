@@ -0,0 +1,87 @@
+// Saves the kernel's replies to the three rtnetlink dumps the Linux network
+// classifier makes, as-is, to <dir>/netlink/{link,addr,route}. A fake root
+// holding them is classified through the same parser as the live dumps.
+//
+// Usage: NetlinkCapture <dir>
+
+#include <errno.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Same requests as netlink_dump in NetworkTypeFinder.m
+static int capture(int fd, unsigned short type, unsigned int seq, const char *path) {
+    struct {
+        struct nlmsghdr nh;
+        struct rtgenmsg gen;
+    } req;
+    memset(&req, 0, sizeof(req));
+    req.nh.nlmsg_len = NLMSG_LENGTH(sizeof(struct rtgenmsg));
+    req.nh.nlmsg_type = type;
+    req.nh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    req.nh.nlmsg_seq = seq;
+    req.gen.rtgen_family = AF_UNSPEC;
+    struct sockaddr_nl kernel = { .nl_family = AF_NETLINK };
+    if (sendto(fd, &req, req.nh.nlmsg_len, 0, (struct sockaddr *)&kernel, sizeof(kernel)) < 0) {
+        perror("sendto");
+        return -1;
+    }
+
+    FILE *fp = fopen(path, "wb");
+    if (!fp) {
+        perror(path);
+        return -1;
+    }
+    char buf[16384] __attribute__((aligned(NLMSG_ALIGNTO)));
+    int done = 0;
+    while (!done) {
+        ssize_t len = recv(fd, buf, sizeof(buf), 0);
+        if (len <= 0) {
+            perror("recv");
+            fclose(fp);
+            return -1;
+        }
+        fwrite(buf, 1, (size_t)len, fp);
+        int remaining = (int)len;
+        for (struct nlmsghdr *nh = (struct nlmsghdr *)buf; NLMSG_OK(nh, remaining); nh = NLMSG_NEXT(nh, remaining)) {
+            if (nh->nlmsg_type == NLMSG_DONE || nh->nlmsg_type == NLMSG_ERROR) done = 1;
+        }
+    }
+    fclose(fp);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s <dir>\n", argv[0]);
+        return 2;
+    }
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/netlink", argv[1]);
+    if ((mkdir(argv[1], 0755) != 0 && errno != EEXIST) || (mkdir(path, 0755) != 0 && errno != EEXIST)) {
+        perror(path);
+        return 1;
+    }
+    int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd < 0) {
+        perror("socket");
+        return 1;
+    }
+    static const struct {
+        unsigned short type;
+        const char *name;
+    } dumps[] = { { RTM_GETLINK, "link" }, { RTM_GETADDR, "addr" }, { RTM_GETROUTE, "route" } };
+    for (unsigned int i = 0; i < sizeof(dumps) / sizeof(dumps[0]); i++) {
+        snprintf(path, sizeof(path), "%s/netlink/%s", argv[1], dumps[i].name);
+        if (capture(fd, dumps[i].type, i + 1, path) != 0) {
+            close(fd);
+            return 1;
+        }
+    }
+    close(fd);
+    return 0;
+}
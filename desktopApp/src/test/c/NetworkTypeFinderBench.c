@@ -0,0 +1,170 @@
+// Benchmark for the Linux network type classifier in NetworkTypeFinder.m
+//
+// Builds a fake topology (or uses the root passed with -r), points the classifier
+// at it and reports per-call latency percentiles. Generated topologies hold
+// rtnetlink dumps, parsed by the same code as the live ones, or with -t the
+// text files of the older fixtures. With -l the classifier instead dumps the
+// host's own interfaces over rtnetlink on every call, bypassing the snapshot
+// kept by the netlink monitor. Syscalls and child processes per call are
+// counted by running the same loop in a ptrace'd child, so the numbers hold in
+// an unprivileged container.
+//
+// Usage: NetworkTypeFinderBench [-l | -r root | [-t] -n virtual_ifaces] [-i iterations]
+
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ptrace.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "FakeNetworkRoot.h"
+#include "NetworkTypeFinder.h"
+
+#define DEFAULT_VIRTUAL_IFACES 300
+#define DEFAULT_ITERATIONS 2000
+#define WARMUP_ITERATIONS 50
+#define SYSCALL_ITERATIONS 20
+
+static const char *network_type_names[] = {
+    "unknown", "vpn", "wifi", "mobile", "wired_ethernet", "no_internet",
+};
+
+static bool live = false;
+
+static void classify(struct network_snapshot *snapshot) {
+    if (live) classifyNetworkImpl(snapshot);
+    else getNetworkSnapshotImpl(snapshot);
+}
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Runs `calls` classifications in a traced child and counts the syscalls and
+// processes it makes, including those of any process it spawns
+static int trace_calls(int calls, long *syscalls, long *processes) {
+    pid_t child = fork();
+    if (child < 0) return -1;
+    if (child == 0) {
+        if (ptrace(PTRACE_TRACEME, 0, NULL, NULL) != 0) _exit(2);
+        raise(SIGSTOP);
+        struct network_snapshot snapshot;
+        for (int i = 0; i < calls; i++) classify(&snapshot);
+        _exit(0);
+    }
+
+    int status;
+    if (waitpid(child, &status, 0) < 0 || !WIFSTOPPED(status)) return -1;
+    ptrace(PTRACE_SETOPTIONS, child, NULL,
+           (void *)(long)(PTRACE_O_TRACESYSGOOD | PTRACE_O_TRACEFORK | PTRACE_O_TRACEVFORK |
+                          PTRACE_O_TRACECLONE | PTRACE_O_EXITKILL));
+    ptrace(PTRACE_SYSCALL, child, NULL, NULL);
+
+    *syscalls = 0;
+    *processes = 0;
+    int live = 1;
+    // Syscall stops come in entry/exit pairs
+    long stops = 0;
+    while (live > 0) {
+        pid_t pid = waitpid(-1, &status, __WALL);
+        if (pid < 0) break;
+        if (WIFEXITED(status) || WIFSIGNALED(status)) {
+            live--;
+            continue;
+        }
+        int signal = 0;
+        if (WIFSTOPPED(status)) {
+            int event = status >> 16;
+            if (WSTOPSIG(status) == (SIGTRAP | 0x80)) {
+                stops++;
+            } else if (event == PTRACE_EVENT_FORK || event == PTRACE_EVENT_VFORK || event == PTRACE_EVENT_CLONE) {
+                live++;
+                if (event != PTRACE_EVENT_CLONE) (*processes)++;
+            } else if (WSTOPSIG(status) != SIGTRAP && WSTOPSIG(status) != SIGSTOP) {
+                signal = WSTOPSIG(status);
+            }
+        }
+        ptrace(PTRACE_SYSCALL, pid, NULL, (void *)(long)signal);
+    }
+    *syscalls = stops / 2;
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    const char *root = NULL;
+    enum fake_root_format format = FAKE_ROOT_NETLINK;
+    int virtual_ifaces = DEFAULT_VIRTUAL_IFACES;
+    int iterations = DEFAULT_ITERATIONS;
+    int opt;
+    while ((opt = getopt(argc, argv, "lr:tn:i:")) != -1) {
+        switch (opt) {
+            case 'l': live = true; break;
+            case 'r': root = optarg; break;
+            case 't': format = FAKE_ROOT_TEXT; break;
+            case 'n': virtual_ifaces = atoi(optarg); break;
+            case 'i': iterations = atoi(optarg); break;
+            default:
+                fprintf(stderr, "Usage: %s [-l | -r root | [-t] -n virtual_ifaces] [-i iterations]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (iterations < 1) iterations = 1;
+
+    struct fake_root generated = { 0 };
+    if (live) {
+        printf("topology: host interfaces over rtnetlink\n");
+    } else if (root == NULL) {
+        if (fake_root_create(&generated, format) != 0) {
+            perror("fake_root_create");
+            return 1;
+        }
+        fake_root_container_host(&generated, virtual_ifaces);
+        root = generated.path;
+        printf("topology: generated %s at %s (%d virtual interfaces)\n",
+               format == FAKE_ROOT_NETLINK ? "netlink dumps" : "text files", root, virtual_ifaces);
+    } else {
+        printf("topology: %s\n", root);
+    }
+    if (root) setNetworkTypeFinderRoot(root);
+
+    struct network_snapshot snapshot;
+    classify(&snapshot);
+    printf("result:   %s (%s)\n", network_type_names[snapshot.type],
+           snapshot.interface_name[0] ? snapshot.interface_name : "no interface");
+
+    for (int i = 0; i < WARMUP_ITERATIONS; i++) classify(&snapshot);
+    double *samples = malloc(sizeof(double) * iterations);
+    if (!samples) return 1;
+    for (int i = 0; i < iterations; i++) {
+        double start = now_us();
+        classify(&snapshot);
+        samples[i] = now_us() - start;
+    }
+    qsort(samples, iterations, sizeof(double), compare_doubles);
+    printf("latency:  p50 %.1f us, p99 %.1f us, max %.1f us over %d calls\n",
+           samples[iterations / 2], samples[(int)(iterations * 0.99)], samples[iterations - 1], iterations);
+    free(samples);
+
+    long base_syscalls, base_processes, syscalls, processes;
+    if (trace_calls(0, &base_syscalls, &base_processes) == 0 &&
+        trace_calls(SYSCALL_ITERATIONS, &syscalls, &processes) == 0) {
+        printf("syscalls: %.1f per call\n", (double)(syscalls - base_syscalls) / SYSCALL_ITERATIONS);
+        printf("children: %.1f processes per call\n", (double)(processes - base_processes) / SYSCALL_ITERATIONS);
+    } else {
+        printf("syscalls: unavailable (ptrace not permitted)\n");
+    }
+
+    if (root == generated.path) fake_root_remove(&generated);
+    return 0;
+}
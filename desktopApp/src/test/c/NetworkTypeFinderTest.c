@@ -0,0 +1,276 @@
+// Test runner for the Linux network type classifier in NetworkTypeFinder.m
+//
+// Classifies every fixture below the given directory and compares the result
+// with its `expected` file, and the snapshot fields with its optional `snapshot`
+// file, which holds one "<field> <value>" pair per line. Each fixture is a fake
+// root holding the sys/class/net and proc/net files the classifier reads, plus
+// either an `ip-addr` capture of `ip -o addr` or the rtnetlink dumps of a real
+// kernel in netlink/ (see `make capture-netlink-fixtures`). Synthetic
+// container-host topologies are generated on the fly on top of that, in both
+// formats.
+//
+// Usage: NetworkTypeFinderTest <fixtures_dir>
+
+#define _GNU_SOURCE
+
+#include <dirent.h>
+#include <linux/netlink.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "FakeNetworkRoot.h"
+#include "NetworkTypeFinder.h"
+
+static int failures = 0;
+static int passed = 0;
+
+static void check(const char *name, const char *root, const char *expected) {
+    setNetworkTypeFinderRoot(root);
+    const char *actual = getNetworkTypeImpl();
+    setNetworkTypeFinderRoot(NULL);
+    if (strcmp(actual, expected) == 0) {
+        printf("ok   %s\n", name);
+        passed++;
+    } else {
+        printf("FAIL %s: expected %s, got %s\n", name, expected, actual);
+        failures++;
+    }
+}
+
+static const char *vpn_kind_names[] = { "none", "wireguard", "tun", "ppp", "ipsec", "other" };
+
+// "1", "0", or "-" when the platform doesn't know the flag
+static void flag_value(char *buf, size_t size, const struct network_snapshot *snapshot, int32_t flag) {
+    if (!(snapshot->known_flags & flag)) snprintf(buf, size, "-");
+    else snprintf(buf, size, "%d", (snapshot->flags & flag) != 0);
+}
+
+// Compares the snapshot of the root with the fields listed in snapshot_path
+static void check_snapshot(const char *name, const char *root, const char *snapshot_path) {
+    FILE *fp = fopen(snapshot_path, "r");
+    if (!fp) return;
+    setNetworkTypeFinderRoot(root);
+    struct network_snapshot snapshot;
+    getNetworkSnapshotImpl(&snapshot);
+    setNetworkTypeFinderRoot(NULL);
+
+    char line[128], field[32], expected[64], actual[64];
+    bool ok = true;
+    while (fgets(line, sizeof(line), fp)) {
+        if (sscanf(line, "%31s %63s", field, expected) != 2) continue;
+        if (strcmp(field, "interface") == 0) {
+            snprintf(actual, sizeof(actual), "%s", snapshot.interface_name[0] ? snapshot.interface_name : "-");
+        } else if (strcmp(field, "mtu") == 0) {
+            snprintf(actual, sizeof(actual), "%d", snapshot.mtu);
+        } else if (strcmp(field, "vpn_kind") == 0) {
+            snprintf(actual, sizeof(actual), "%s", vpn_kind_names[snapshot.vpn_kind]);
+        } else if (strcmp(field, "ipv6_default_route") == 0) {
+            flag_value(actual, sizeof(actual), &snapshot, NETWORK_SNAPSHOT_IPV6_DEFAULT_ROUTE);
+        } else if (strcmp(field, "metered") == 0) {
+            flag_value(actual, sizeof(actual), &snapshot, NETWORK_SNAPSHOT_METERED);
+        } else {
+            snprintf(actual, sizeof(actual), "<unknown field>");
+        }
+        if (strcmp(actual, expected) != 0) {
+            printf("FAIL %s: snapshot %s expected %s, got %s\n", name, field, expected, actual);
+            ok = false;
+        }
+    }
+    fclose(fp);
+    if (ok) {
+        printf("ok   %s (snapshot)\n", name);
+        passed++;
+    } else {
+        failures++;
+    }
+}
+
+static int is_fixture(const struct dirent *entry) {
+    return entry->d_name[0] != '.';
+}
+
+static void run_fixtures(const char *dir) {
+    struct dirent **entries;
+    int count = scandir(dir, &entries, is_fixture, alphasort);
+    if (count < 0) {
+        perror(dir);
+        failures++;
+        return;
+    }
+    for (int i = 0; i < count; i++) {
+        char root[1024], expected_path[1100], snapshot_path[1100], expected[32] = "";
+        snprintf(root, sizeof(root), "%s/%s", dir, entries[i]->d_name);
+        snprintf(expected_path, sizeof(expected_path), "%s/expected", root);
+        FILE *fp = fopen(expected_path, "r");
+        if (fp) {
+            fgets(expected, sizeof(expected), fp);
+            fclose(fp);
+        }
+        expected[strcspn(expected, "\n")] = '\0';
+        if (!expected[0]) {
+            printf("FAIL %s: missing expected file\n", entries[i]->d_name);
+            failures++;
+        } else {
+            check(entries[i]->d_name, root, expected);
+        }
+        snprintf(snapshot_path, sizeof(snapshot_path), "%s/snapshot", root);
+        check_snapshot(entries[i]->d_name, root, snapshot_path);
+        free(entries[i]);
+    }
+    free(entries);
+}
+
+static const char *format_names[] = { "text", "netlink" };
+
+static void run_container_host(enum fake_root_format format, int virtual_ifaces) {
+    struct fake_root root;
+    if (fake_root_create(&root, format) != 0) {
+        perror("fake_root_create");
+        failures++;
+        return;
+    }
+    fake_root_container_host(&root, virtual_ifaces);
+    char name[64];
+    snprintf(name, sizeof(name), "generated/%s/container_host_%d_veth", format_names[format], virtual_ifaces);
+    check(name, root.path, "wifi");
+    fake_root_remove(&root);
+}
+
+// Many virtual interfaces around a plain wired uplink
+static void run_wired_node(enum fake_root_format format, int virtual_ifaces) {
+    struct fake_root root;
+    if (fake_root_create(&root, format) != 0) {
+        perror("fake_root_create");
+        failures++;
+        return;
+    }
+    fake_root_add_iface(&root, "lo", "unknown", "127.0.0.1/8", 0);
+    int eno1 = fake_root_add_iface(&root, "eno1", "up", "10.20.0.7/16", 0);
+    fake_root_add_iface(&root, "cni0", "up", "10.244.1.1/24", 0);
+    for (int i = 0; i < virtual_ifaces; i++) {
+        char iface[32];
+        snprintf(iface, sizeof(iface), i % 2 ? "cali%011x" : "veth%07x", i);
+        fake_root_add_iface(&root, iface, "up", NULL, 0);
+    }
+    fake_root_add_route(&root, "eno1", eno1, "0.0.0.0/0", 0);
+    fake_root_finish(&root);
+    char name[64];
+    snprintf(name, sizeof(name), "generated/%s/wired_node_%d_virtual", format_names[format], virtual_ifaces);
+    check(name, root.path, "wired_ethernet");
+    fake_root_remove(&root);
+}
+
+// Copies a captured dump, without its last `cut` bytes
+static void copy_capture(const char *from_root, const char *to_root, const char *name, long cut) {
+    char from[1100], to[1100];
+    snprintf(from, sizeof(from), "%s/netlink/%s", from_root, name);
+    snprintf(to, sizeof(to), "%s/netlink/%s", to_root, name);
+    FILE *in = fopen(from, "rb"), *out = fopen(to, "wb");
+    if (in && out) {
+        fseek(in, 0, SEEK_END);
+        long size = ftell(in) - cut;
+        fseek(in, 0, SEEK_SET);
+        char buf[4096];
+        for (long copied = 0; copied < size;) {
+            size_t n = fread(buf, 1, size - copied < (long)sizeof(buf) ? (size_t)(size - copied) : sizeof(buf), in);
+            if (n == 0) break;
+            fwrite(buf, 1, n, out);
+            copied += (long)n;
+        }
+    }
+    if (in) fclose(in);
+    if (out) fclose(out);
+}
+
+// Kernel replies the parser must reject rather than classify half a topology:
+// a dump cut before NLMSG_DONE, a message cut in the middle, and an NLMSG_ERROR
+static void run_broken_captures(const char *dir) {
+    char source[1024];
+    snprintf(source, sizeof(source), "%s/netlink_wired_dual_stack", dir);
+    static const struct {
+        const char *name;
+        const char *dump;
+        long cut;
+    } cases[] = {
+        { "missing_done", "route", NLMSG_LENGTH(sizeof(int)) },
+        { "truncated_message", "link", NLMSG_LENGTH(sizeof(int)) + 8 },
+        { "error_reply", "addr", -1 },
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        struct fake_root root = { .path = "/tmp/ntf-root-XXXXXX" };
+        char netlink[1100], name[64];
+        if (!mkdtemp(root.path)) {
+            perror("mkdtemp");
+            failures++;
+            return;
+        }
+        snprintf(netlink, sizeof(netlink), "%s/netlink", root.path);
+        mkdir(netlink, 0755);
+        copy_capture(source, root.path, "link", strcmp(cases[i].dump, "link") == 0 ? cases[i].cut : 0);
+        copy_capture(source, root.path, "addr", 0);
+        copy_capture(source, root.path, "route", strcmp(cases[i].dump, "route") == 0 ? cases[i].cut : 0);
+        if (cases[i].cut < 0) {
+            // What the kernel sends instead of a dump it can't serve
+            struct {
+                struct nlmsghdr nh;
+                struct nlmsgerr err;
+            } reply = { 0 };
+            reply.nh.nlmsg_len = sizeof(reply);
+            reply.nh.nlmsg_type = NLMSG_ERROR;
+            reply.nh.nlmsg_seq = 2;
+            reply.err.error = -1;
+            snprintf(netlink, sizeof(netlink), "%s/netlink/%s", root.path, cases[i].dump);
+            FILE *fp = fopen(netlink, "wb");
+            if (fp) {
+                fwrite(&reply, 1, sizeof(reply), fp);
+                fclose(fp);
+            }
+        }
+        snprintf(name, sizeof(name), "generated/broken/%s", cases[i].name);
+        check(name, root.path, "unknown");
+        fake_root_remove(&root);
+    }
+}
+
+// The generation only moves when the snapshot changes
+static void run_generation(const char *dir) {
+    char wifi[1024], wired[1024];
+    snprintf(wifi, sizeof(wifi), "%s/wifi_laptop", dir);
+    snprintf(wired, sizeof(wired), "%s/wired_eth", dir);
+    struct network_snapshot first, same, changed;
+    setNetworkTypeFinderRoot(wifi);
+    getNetworkSnapshotImpl(&first);
+    getNetworkSnapshotImpl(&same);
+    setNetworkTypeFinderRoot(wired);
+    getNetworkSnapshotImpl(&changed);
+    setNetworkTypeFinderRoot(NULL);
+    if (same.generation == first.generation && changed.generation == first.generation + 1) {
+        printf("ok   generation\n");
+        passed++;
+    } else {
+        printf("FAIL generation: got %lld, %lld, %lld\n", (long long)first.generation,
+               (long long)same.generation, (long long)changed.generation);
+        failures++;
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s <fixtures_dir>\n", argv[0]);
+        return 2;
+    }
+    run_fixtures(argv[1]);
+    run_generation(argv[1]);
+    run_broken_captures(argv[1]);
+    for (int format = FAKE_ROOT_TEXT; format <= FAKE_ROOT_NETLINK; format++) {
+        run_container_host(format, 0);
+        run_container_host(format, 200);
+        run_wired_node(format, 300);
+    }
+
+    printf("%d passed, %d failed\n", passed, failures);
+    return failures ? 1 : 0;
+}
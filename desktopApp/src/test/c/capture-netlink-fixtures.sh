@@ -0,0 +1,116 @@
+#!/bin/bash
+
+# Captures the rtnetlink fixtures (fixtures/network/netlink_*) from real
+# kernels: every topology is built in its own network namespace, which needs no
+# root thanks to a user namespace, and NetlinkCapture saves the kernel's
+# replies as-is. The expected and snapshot files are written by hand.
+#
+# Usage: capture-netlink-fixtures.sh <NetlinkCapture> <fixtures_dir>
+# Run through `make capture-netlink-fixtures`.
+
+set -e
+
+if [ "$1" = "--in-namespace" ]; then
+    capture="$2"
+    topology="$3"
+    output="$4"
+
+    ip link set lo up
+    case "$topology" in
+        netlink_wired_dual_stack)
+            ip link add eth0 type veth peer name veth0
+            ip link set veth0 up
+            ip link set eth0 up
+            ip addr add 192.0.2.10/24 dev eth0
+            ip addr add 2001:db8::10/64 dev eth0 nodad
+            ip route add default via 192.0.2.1 dev eth0 metric 100
+            ip -6 route add default via 2001:db8::1 dev eth0 metric 100
+            ;;
+        netlink_wifi)
+            ip link add wlan0 mtu 1400 type veth peer name veth0
+            ip link set veth0 up
+            ip link set wlan0 up
+            ip addr add 192.168.1.20/24 dev wlan0
+            ip route add default via 192.168.1.1 dev wlan0 metric 600
+            ;;
+        netlink_vpn_tun)
+            ip link add wlan0 type veth peer name veth0
+            ip link set veth0 up
+            ip link set wlan0 up
+            ip addr add 192.168.1.20/24 dev wlan0
+            ip route add default via 192.168.1.1 dev wlan0 metric 600
+            # Held open by a client for the duration of the capture, like an OpenVPN tunnel
+            ip tuntap add dev tun0 mode tun
+            python3 -c '
+import fcntl, os, struct, time
+fd = os.open("/dev/net/tun", os.O_RDWR)
+fcntl.ioctl(fd, 0x400454ca, struct.pack("16sH", b"tun0", 0x0001 | 0x1000))
+time.sleep(5)' &
+            sleep 1
+            ip link set tun0 mtu 1420 up
+            ip addr add 10.8.0.2/24 dev tun0
+            # In its own table, as most VPN clients do
+            ip route add default dev tun0 table 100
+            ;;
+        netlink_tun_no_carrier)
+            ip link add eth0 type veth peer name veth0
+            ip link set veth0 up
+            ip link set eth0 up
+            ip addr add 192.0.2.10/24 dev eth0
+            ip route add default via 192.0.2.1 dev eth0
+            # Nothing holds the tunnel open: up, but without carrier
+            ip tuntap add dev tun0 mode tun
+            ip link set tun0 up
+            ip addr add 10.8.0.2/24 dev tun0
+            ;;
+        netlink_container_host)
+            ip link add eth0 type veth peer name veth0
+            ip link set veth0 up
+            ip link set eth0 up
+            ip addr add 192.0.2.10/24 dev eth0
+            ip route add default via 192.0.2.1 dev eth0
+            ip link add docker0 type bridge
+            ip link set docker0 up
+            ip addr add 172.17.0.1/16 dev docker0
+            # Enough links for the dump to span several recv() buffers
+            for i in $(seq 1 12); do
+                name=$(printf 'veth%07x' "$i")
+                ip link add "$name" type veth peer name "c$name"
+                ip link set "$name" master docker0 up
+                ip link set "c$name" up
+            done
+            ;;
+        netlink_offline_loopback)
+            ;;
+        netlink_ipv6_only)
+            ip link add eth0 type veth peer name veth0
+            ip link set veth0 up
+            ip link set eth0 up
+            ip addr add 2001:db8::10/64 dev eth0 nodad
+            ip -6 route add default via 2001:db8::1 dev eth0
+            ;;
+        *)
+            echo "Unknown topology $topology" >&2
+            exit 1
+            ;;
+    esac
+    "$capture" "$output"
+    exit 0
+fi
+
+if [ $# -ne 2 ]; then
+    echo "Usage: $0 <NetlinkCapture> <fixtures_dir>" >&2
+    exit 2
+fi
+capture="$(realpath "$1")"
+fixtures="$(realpath "$2")"
+for topology in netlink_wired_dual_stack netlink_wifi netlink_vpn_tun netlink_tun_no_carrier \
+    netlink_container_host netlink_offline_loopback netlink_ipv6_only; do
+    echo "Capturing $topology..."
+    rm -rf "$fixtures/$topology/netlink"
+    mkdir -p "$fixtures/$topology"
+    unshare --user --map-root-user --net "$0" --in-namespace "$capture" "$topology" "$fixtures/$topology"
+done
+# The classifier recognises Wi-Fi by this directory, which rtnetlink doesn't report
+mkdir -p "$fixtures/netlink_wifi/sys/class/net/wlan0/wireless" "$fixtures/netlink_vpn_tun/sys/class/net/wlan0/wireless"
+touch "$fixtures/netlink_wifi/sys/class/net/wlan0/wireless/.gitkeep" "$fixtures/netlink_vpn_tun/sys/class/net/wlan0/wireless/.gitkeep"